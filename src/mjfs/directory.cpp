@@ -6,11 +6,16 @@
 #include <cstdlib>
 #include <mjfs/bitmask.hpp>
 #include <mjfs/directory.hpp>
+#include <mjfs/impl/copy_directory.hpp>
 #include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/disk_usage.hpp>
 #include <mjfs/impl/path.hpp>
+#include <mjfs/impl/remove_all.hpp>
 #include <mjfs/impl/status.hpp>
 #include <mjfs/impl/utils.hpp>
 #include <mjmem/object_allocator.hpp>
+#include <mjstr/string_view.hpp>
+#include <utility>
 
 namespace mjx {
     directory_entry::directory_entry(const path& _Target)
@@ -76,14 +81,21 @@ namespace mjx {
 
     directory_iterator::directory_iterator(const path& _Target)
         : _Myimpl(::mjx::create_object<mjfs_impl::_Dir_iter>(_Target)) {
-        if (!_Myimpl->_Normal()->_Skip_dots()) {
+        if (!_Myimpl->_Normal()->_Start()) {
             _Myimpl.reset();
         }
     }
 
     directory_iterator::directory_iterator(const path& _Target, const directory_options)
         : _Myimpl(::mjx::create_object<mjfs_impl::_Dir_iter>(_Target)) {
-        if (!_Myimpl->_Normal()->_Skip_dots()) {
+        if (!_Myimpl->_Normal()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    directory_iterator::directory_iterator(const path& _Target, const glob_pattern& _Pattern)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Dir_iter>(_Target, _Pattern)) {
+        if (!_Myimpl->_Normal()->_Start()) {
             _Myimpl.reset();
         }
     }
@@ -124,11 +136,63 @@ namespace mjx {
         return directory_iterator{};
     }
 
+    directory_name_iterator::directory_name_iterator() noexcept : _Myimpl(nullptr) {}
+
+    directory_name_iterator::directory_name_iterator(const path& _Target)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Dir_iter>(_Target, true)) {
+        if (!_Myimpl->_Normal()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    directory_name_iterator::directory_name_iterator(const path& _Target, const glob_pattern& _Pattern)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Dir_iter>(_Target, _Pattern, true)) {
+        if (!_Myimpl->_Normal()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    directory_name_iterator::~directory_name_iterator() noexcept {}
+
+    bool directory_name_iterator::operator==(const directory_name_iterator& _Other) const noexcept {
+        return _Myimpl == _Other._Myimpl;
+    }
+
+    directory_name_iterator::reference directory_name_iterator::operator*() const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Myimpl != nullptr, "attempt to dereference invalid iterator");
+#endif // _DEBUG
+        return _Myimpl->_Normal()->_Name_entry;
+    }
+
+    directory_name_iterator::pointer directory_name_iterator::operator->() const noexcept {
+        return &**this;
+    }
+
+    directory_name_iterator& directory_name_iterator::operator++() {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Myimpl != nullptr, "attempt to advance invalid iterator");
+#endif // _DEBUG
+        if (!_Myimpl->_Normal()->_Advance()) {
+            _Myimpl.reset();
+        }
+
+        return *this;
+    }
+
+    directory_name_iterator begin(directory_name_iterator _Iter) noexcept {
+        return _Iter;
+    }
+
+    directory_name_iterator end(directory_name_iterator) noexcept {
+        return directory_name_iterator{};
+    }
+
     recursive_directory_iterator::recursive_directory_iterator() noexcept : _Myimpl(nullptr) {}
 
     recursive_directory_iterator::recursive_directory_iterator(const path& _Target)
         : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(_Target, directory_options::none)) {
-        if (!_Myimpl->_Recursive()->_Skip_dots()) {
+        if (!_Myimpl->_Recursive()->_Start()) {
             _Myimpl.reset();
         }
     }
@@ -136,7 +200,42 @@ namespace mjx {
     recursive_directory_iterator::recursive_directory_iterator(
         const path& _Target, const directory_options _Options)
         : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(_Target, _Options)) {
-        if (!_Myimpl->_Recursive()->_Skip_dots()) {
+        if (!_Myimpl->_Recursive()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    recursive_directory_iterator::recursive_directory_iterator(
+        const path& _Target, const glob_pattern& _Pattern)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(
+            _Target, _Pattern, directory_options::none)) {
+        if (!_Myimpl->_Recursive()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    recursive_directory_iterator::recursive_directory_iterator(
+        const path& _Target, const glob_pattern& _Pattern, const directory_options _Options)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(_Target, _Pattern, _Options)) {
+        if (!_Myimpl->_Recursive()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    recursive_directory_iterator::recursive_directory_iterator(const path& _Target,
+        const directory_options _Options, const recursive_directory_limits& _Limits)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(_Target, _Options, _Limits)) {
+        if (!_Myimpl->_Recursive()->_Start()) {
+            _Myimpl.reset();
+        }
+    }
+
+    recursive_directory_iterator::recursive_directory_iterator(const path& _Target,
+        const glob_pattern& _Pattern, const directory_options _Options,
+        const recursive_directory_limits& _Limits)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Recursive_dir_iter>(
+            _Target, _Pattern, _Options, _Limits)) {
+        if (!_Myimpl->_Recursive()->_Start()) {
             _Myimpl.reset();
         }
     }
@@ -180,7 +279,7 @@ namespace mjx {
 #ifdef _DEBUG
         _INTERNAL_ASSERT(_Myimpl != nullptr, "attempt to use invalid iterator");
 #endif // _DEBUG
-        return static_cast<int>(_Myimpl->_Recursive()->_Stack.size());
+        return static_cast<int>(_Myimpl->_Recursive()->_Depth);
     }
 
     bool recursive_directory_iterator::recursion_pending() const noexcept {
@@ -201,7 +300,9 @@ namespace mjx {
 #ifdef _DEBUG
         _INTERNAL_ASSERT(_Myimpl != nullptr, "attempt to use invalid iterator");
 #endif // _DEBUG
-        _Myimpl->_Recursive()->_Pop();
+        if (!_Myimpl->_Recursive()->_Pop()) {
+            _Myimpl.reset();
+        }
     }
 
     recursive_directory_iterator begin(recursive_directory_iterator _Iter) noexcept {
@@ -212,11 +313,119 @@ namespace mjx {
         return recursive_directory_iterator{};
     }
 
+    bool count_entries(const path& _Dir, size_t& _Count, const entry_filter _Filter) {
+        // Note: The directory attribute of an entry must match the filter, unless all entries are counted.
+        const bool _Want_dirs = _Filter == entry_filter::directories;
+        size_t _Result        = 0;
+        const auto _Func      = [&_Result, _Filter, _Want_dirs](
+            const unicode_string_view, const FILE_FULL_DIR_INFO& _Info) noexcept {
+            const bool _Is_dir = (_Info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            if (_Filter == entry_filter::all || _Is_dir == _Want_dirs) {
+                ++_Result;
+            }
+        };
+        if (!mjfs_impl::_For_each_directory_info<FILE_FULL_DIR_INFO>(
+            _Dir.c_str(), FileFullDirectoryInfo, _Func)) {
+            return false;
+        }
+
+        _Count = _Result;
+        return true;
+    }
+
+    bool count_entries(const path& _Dir, const glob_pattern& _Pattern, size_t& _Count) {
+        const glob_pattern::state_type _Initial = _Pattern.initial_state();
+        size_t _Result                          = 0;
+        const auto _Func                        = [&_Result, &_Pattern, _Initial](
+            const unicode_string_view _Name, const FILE_FULL_DIR_INFO&) {
+            if (_Pattern.accepts(_Pattern.advance(_Initial, _Name))) {
+                ++_Result;
+            }
+        };
+        if (!mjfs_impl::_For_each_directory_info<FILE_FULL_DIR_INFO>(
+            _Dir.c_str(), FileFullDirectoryInfo, _Func)) {
+            return false;
+        }
+
+        _Count = _Result;
+        return true;
+    }
+
     bool create_directory(const path& _Path) {
         return ::CreateDirectoryW(_Path.c_str(), nullptr) != 0;
     }
 
+    bool create_directories(const path& _Path) {
+        if (::CreateDirectoryW(_Path.c_str(), nullptr) != 0) {
+            return true;
+        }
+
+        if (::GetLastError() == ERROR_PATH_NOT_FOUND) { // some of the parents are missing
+            path::string_type _Buf = _Path.native();
+            return mjfs_impl::_Create_missing_directories(_Buf);
+        } else { // Note: A drive root cannot be created (ERROR_ACCESS_DENIED), but it may exist.
+            return mjfs_impl::_Is_existing_directory(_Path.c_str());
+        }
+    }
+
     bool remove_directory(const path& _Target) {
         return ::RemoveDirectoryW(_Target.c_str()) != 0;
     }
+
+    bool disk_usage(const path& _Root, disk_usage_info& _Usage, const disk_usage_options _Options,
+        ::std::vector<disk_usage_subtotal>* const _Subtotals) {
+        return mjfs_impl::_Usage_counter{_Options, _Subtotals != nullptr}._Count(_Root, _Usage, _Subtotals);
+    }
+
+    bool copy_directory(
+        const path& _From, const path& _To, const copy_options _Options, copy_directory_stats* const _Stats) {
+        copy_directory_stats _Local;
+        return mjfs_impl::_Tree_copier{_Options}._Copy(_From, _To, _Stats != nullptr ? *_Stats : _Local);
+    }
+
+    bool remove_all(const path& _Target, remove_all_stats* const _Stats) {
+        remove_all_stats _Local;
+        return mjfs_impl::_Tree_remover{}._Remove(_Target, _Stats != nullptr ? *_Stats : _Local);
+    }
+
+    background_removal::background_removal() noexcept : _Myimpl() {}
+
+    background_removal::background_removal(background_removal&& _Other) noexcept
+        : _Myimpl(::std::move(_Other._Myimpl)) {}
+
+    background_removal::~background_removal() noexcept {}
+
+    background_removal& background_removal::operator=(background_removal&& _Other) noexcept {
+        _Myimpl = ::std::move(_Other._Myimpl); // waits for the current removal
+        return *this;
+    }
+
+    bool background_removal::pending() const noexcept {
+        return _Myimpl != nullptr && _Myimpl->_Pending();
+    }
+
+    bool background_removal::wait(remove_all_stats* const _Stats) {
+        if (_Myimpl == nullptr) { // nothing was started
+            if (_Stats != nullptr) {
+                *_Stats = remove_all_stats{};
+            }
+
+            return true;
+        }
+
+        return _Myimpl->_Wait(_Stats);
+    }
+
+    bool remove_all(const path& _Target, background_removal& _Removal) {
+        // Note: Replacing the implementation waits for the previous removal.
+        _Removal._Myimpl.reset(::mjx::create_object<mjfs_impl::_Background_removal>());
+        path _Trash;
+        if (mjfs_impl::_Move_to_trash(_Target, _Trash)) {
+            _Removal._Myimpl->_Start(::std::move(_Trash));
+            return true;
+        } else {
+            _Removal._Myimpl->_Remove_now(_Target);
+            return _Removal._Myimpl->_Wait(nullptr);
+        }
+    }
 } // namespace mjx
\ No newline at end of file
@@ -6,26 +6,92 @@
 #pragma once
 #ifndef _MJFS_DIRECTORY_HPP_
 #define _MJFS_DIRECTORY_HPP_
+#include <cstdint>
 #include <mjfs/api.hpp>
 #include <mjfs/file.hpp>
+#include <mjfs/glob.hpp>
 #include <mjfs/path.hpp>
 #include <mjmem/smart_pointer.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
 
 namespace mjx {
     namespace mjfs_impl {
         class _Dir_iter_base;
         class _Dir_iter;
         class _Recursive_dir_iter;
+        class _Background_removal;
     } // namespace mjfs_impl
 
-    enum class directory_options : unsigned char {
+    enum class directory_options : unsigned short {
         none                     = 0x00,
         follow_directory_symlink = 0x10,
-        skip_permission_denied   = 0x20
+        skip_permission_denied   = 0x20,
+        skip_visited_directories = 0x40, // enter each directory once, even if reachable through links
+        report_hard_links_once   = 0x80, // report only the first name of a file with multiple hard links
+        breadth_first            = 0x100, // report a whole level before entering the directories below it
+        sorted_by_name           = 0x200 // report the entries of each directory in the order of their names
     };
 
     _DECLARE_BIT_OPS(directory_options);
 
+    struct recursive_directory_limits {
+        // Note: Each directory on the current path keeps its handle open. Once the limit is reached,
+        //       the remaining entries of the outermost open directory are read into memory and its handle
+        //       is closed, so the memory use grows instead of the number of handles. Zero means no limit.
+        size_t max_open_handles = 0;
+
+        // the maximum depth of the entered directories, 0 reports only the target's entries,
+        // a negative value means no limit
+        int max_depth = -1;
+    };
+
+    struct remove_all_stats {
+        uint64_t removed_files       = 0;
+        uint64_t removed_directories = 0; // including the removed links to directories
+        unsigned long error          = 0; // the first error that occurred, 0 if none
+        path failed_path; // the entry that caused the first error
+    };
+
+    enum class copy_options : unsigned char {
+        none                = 0x00, // fail on the existing files
+        skip_existing       = 0x01, // keep the existing files
+        overwrite_existing  = 0x02, // replace the existing files
+        update_existing     = 0x04, // replace the existing files that are older than their sources
+        preserve_times      = 0x08, // copy the creation and access times, and the times of the directories
+        preserve_attributes = 0x10 // copy the attributes of the directories
+    };
+
+    _DECLARE_BIT_OPS(copy_options);
+
+    struct copy_directory_stats {
+        uint64_t copied_files        = 0;
+        uint64_t cloned_files        = 0; // the copied files that share their blocks with the sources
+        uint64_t skipped_files       = 0;
+        uint64_t created_directories = 0;
+        unsigned long error          = 0; // the first error that occurred, 0 if none
+        path failed_path; // the entry that caused the first error
+    };
+
+    enum class disk_usage_options : unsigned char {
+        none                  = 0x00,
+        count_hard_links_once = 0x01 // count a file with multiple hard links once, by its file ID
+    };
+
+    _DECLARE_BIT_OPS(disk_usage_options);
+
+    struct disk_usage_info {
+        uint64_t bytes           = 0; // the sum of the file sizes
+        uint64_t allocated_bytes = 0; // the space taken by the files, less for sparse or compressed files
+        uint64_t files           = 0;
+        uint64_t directories     = 0; // including the links to directories, excluding the root
+    };
+
+    struct disk_usage_subtotal {
+        path name; // the name of the root's entry
+        disk_usage_info usage;
+    };
+
     class _MJFS_API directory_entry { // represents a directory entry
     public:
         directory_entry() noexcept                  = default;
@@ -72,6 +138,17 @@ namespace mjx {
         path _Mypath;
     };
 
+    struct directory_name_entry { // the raw name and attributes of an entry, as reported by the system
+        unicode_string_view name; // valid until the iterator is advanced
+        file_attribute attributes = file_attribute::none;
+    };
+
+    enum class entry_filter : unsigned char {
+        all,
+        files, // the entries without the directory attribute
+        directories // the entries with the directory attribute, including links to directories
+    };
+
     class _Any_dir_iter { // base class for any kind of directory iterator
     public:
         using _Normal_t    = mjfs_impl::_Dir_iter;
@@ -102,6 +179,9 @@ namespace mjx {
         explicit directory_iterator(const path& _Target);
         directory_iterator(const path& _Target, const directory_options _Options);
 
+        // reports only the entries whose names match the pattern
+        directory_iterator(const path& _Target, const glob_pattern& _Pattern);
+
         directory_iterator& operator=(const directory_iterator&) noexcept = default;
         directory_iterator& operator=(directory_iterator&&) noexcept      = default;
 
@@ -125,6 +205,50 @@ namespace mjx {
     _MJFS_API directory_iterator begin(directory_iterator _Iter) noexcept;
     _MJFS_API directory_iterator end(directory_iterator _Iter) noexcept;
 
+    class _MJFS_API directory_name_iterator { // an iterator to the names of the directory's entries
+    public:
+        using value_type        = directory_name_entry;
+        using difference_type   = ptrdiff_t;
+        using pointer           = const directory_name_entry*;
+        using reference         = const directory_name_entry&;
+        using iterator_category = ::std::input_iterator_tag;
+
+        directory_name_iterator() noexcept;
+        ~directory_name_iterator() noexcept;
+
+        directory_name_iterator(const directory_name_iterator&)     = default;
+        directory_name_iterator(directory_name_iterator&&) noexcept = default;
+
+        // Note: Unlike directory_iterator, no path is built for the entries, the names are read
+        //       straight from the enumeration buffer.
+        explicit directory_name_iterator(const path& _Target);
+
+        // reports only the entries whose names match the pattern
+        directory_name_iterator(const path& _Target, const glob_pattern& _Pattern);
+
+        directory_name_iterator& operator=(const directory_name_iterator&) noexcept = default;
+        directory_name_iterator& operator=(directory_name_iterator&&) noexcept      = default;
+
+        // checks whether two iterators are equal
+        bool operator==(const directory_name_iterator& _Other) const noexcept;
+
+        // returns a reference to the current entry
+        reference operator*() const noexcept;
+
+        // returns a pointer to the current entry
+        pointer operator->() const noexcept;
+
+        // advances the iterator to the next entry
+        directory_name_iterator& operator++();
+
+    private:
+#pragma warning(suppress : 4251) // C4251: _Any_dir_iter needs to have dll-interface
+        smart_ptr<_Any_dir_iter> _Myimpl;
+    };
+
+    _MJFS_API directory_name_iterator begin(directory_name_iterator _Iter) noexcept;
+    _MJFS_API directory_name_iterator end(directory_name_iterator _Iter) noexcept;
+
     class _MJFS_API recursive_directory_iterator {
     public:
         using value_type        = directory_entry;
@@ -142,6 +266,18 @@ namespace mjx {
         explicit recursive_directory_iterator(const path& _Target);
         recursive_directory_iterator(const path& _Target, const directory_options _Options);
 
+        // reports only the entries whose paths relative to the target match the pattern,
+        // directories that cannot contain any match are not entered
+        recursive_directory_iterator(const path& _Target, const glob_pattern& _Pattern);
+        recursive_directory_iterator(
+            const path& _Target, const glob_pattern& _Pattern, const directory_options _Options);
+
+        // keeps the iteration within the limits
+        recursive_directory_iterator(const path& _Target, const directory_options _Options,
+            const recursive_directory_limits& _Limits);
+        recursive_directory_iterator(const path& _Target, const glob_pattern& _Pattern,
+            const directory_options _Options, const recursive_directory_limits& _Limits);
+
         recursive_directory_iterator& operator=(const recursive_directory_iterator&)     = default;
         recursive_directory_iterator& operator=(recursive_directory_iterator&&) noexcept = default;
 
@@ -169,7 +305,8 @@ namespace mjx {
         // disables recursion to the currently referred subdirectory
         void disable_recursion_pending() noexcept;
 
-        // moves the iterator one level up in the directory hierarchy
+        // moves the iterator one level up in the directory hierarchy,
+        // in breadth-first order skips the rest of the current directory instead
         void pop();
 
     private:
@@ -180,8 +317,80 @@ namespace mjx {
     _MJFS_API recursive_directory_iterator begin(recursive_directory_iterator _Iter) noexcept;
     _MJFS_API recursive_directory_iterator end(recursive_directory_iterator _Iter) noexcept;
 
+    // Note: Counts the entries other than the dots without allocating memory. The entries are read
+    //       in large batches, so a big directory takes only a few system calls.
+    _MJFS_API bool count_entries(
+        const path& _Dir, size_t& _Count, const entry_filter _Filter = entry_filter::all);
+
+    // counts the entries whose names match the pattern
+    _MJFS_API bool count_entries(const path& _Dir, const glob_pattern& _Pattern, size_t& _Count);
+
     _MJFS_API bool create_directory(const path& _Path);
+
+    // Note: Creates the directory along with its missing parents. The directory itself is tried first,
+    //       so an existing path or a path with an existing parent costs one or two system calls. Only if
+    //       the parent is missing, the path is walked back as far as needed. A directory created by someone
+    //       else in the meantime counts as created, an existing file with the same name doesn't.
+    _MJFS_API bool create_directories(const path& _Path);
     _MJFS_API bool remove_directory(const path& _Target);
+
+    // Note: Sums the sizes of all files below the root. The sizes are read along with the names, so no file
+    //       is opened, and the subdirectories are read by multiple threads. The links are not followed.
+    //       If requested, the sums are also reported for each of the root's entries, in the order they were
+    //       read. With count_hard_links_once, the IDs of all counted files are kept in memory. Returns false
+    //       if any directory cannot be read, the sums then cover only the directories that were read.
+    _MJFS_API bool disk_usage(const path& _Root, disk_usage_info& _Usage,
+        const disk_usage_options _Options = disk_usage_options::none,
+        ::std::vector<disk_usage_subtotal>* const _Subtotals = nullptr);
+
+    // Note: Copies the contents of the source directory into the target directory, which is created along
+    //       with its missing parents if needed. The directories are read and created by multiple threads
+    //       first, then the files are copied by multiple threads. Each file is cloned if the volume supports
+    //       it (e.g. ReFS), a file that cannot be cloned is copied by the system. The files keep their
+    //       attributes and last write times, the links to files are copied as links and the links
+    //       to directories are skipped. An error, including a directory that cannot be read, doesn't stop
+    //       the copying of the other entries, only the first one is reported. A target that is the source
+    //       or lies inside it is rejected (ERROR_INVALID_PARAMETER) before anything is created.
+    _MJFS_API bool copy_directory(const path& _From, const path& _To,
+        const copy_options _Options = copy_options::none, copy_directory_stats* const _Stats = nullptr);
+
+    // Note: Removes the target and, if it's a directory, all of its contents. The files are removed
+    //       by multiple threads, each directory is removed once all of its entries are gone. Links are
+    //       removed without touching their targets. An error doesn't stop the removal of the other
+    //       entries, only the first one is reported. A target that doesn't exist is not an error.
+    _MJFS_API bool remove_all(const path& _Target, remove_all_stats* const _Stats = nullptr);
+
+    class _MJFS_API background_removal { // a tree being removed on a separate thread, see remove_all()
+    public:
+        background_removal() noexcept;
+        background_removal(background_removal&& _Other) noexcept;
+        ~background_removal() noexcept;
+
+        background_removal& operator=(background_removal&& _Other) noexcept;
+
+        background_removal(const background_removal&)            = delete;
+        background_removal& operator=(const background_removal&) = delete;
+
+        // checks whether a removal was started and not waited for yet
+        bool pending() const noexcept;
+
+        // waits for the removal to finish, returns false if some entries could not be removed
+        // (an exception thrown by the removal thread is rethrown here)
+        bool wait(remove_all_stats* const _Stats = nullptr);
+
+    private:
+        friend _MJFS_API bool remove_all(const path&, background_removal&);
+
+#pragma warning(suppress : 4251) // C4251: unique_smart_ptr<_Background_removal> needs to have dll-interface
+        unique_smart_ptr<mjfs_impl::_Background_removal> _Myimpl;
+    };
+
+    // Note: Renames the target within its parent directory and returns once it's renamed, the renamed
+    //       tree is removed on a thread owned by the removal. The thread is joined by wait(), or when
+    //       the removal is destroyed or assigned, so it never outlives the caller. A removal that was
+    //       still pending is waited for first. If the target cannot be renamed, it's removed before
+    //       returning instead, and wait() reports the result.
+    _MJFS_API bool remove_all(const path& _Target, background_removal& _Removal);
 } // namespace mjx
 
 #endif // _MJFS_DIRECTORY_HPP_
\ No newline at end of file
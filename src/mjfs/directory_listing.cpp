@@ -0,0 +1,213 @@
+// directory_listing.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <mjfs/directory_listing.hpp>
+#include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/directory_listing.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/impl/utils.hpp>
+#include <numeric>
+
+namespace mjx {
+    directory_listing::directory_listing() noexcept
+        : _Mydir(), _Mynames(), _Myfolded_names(), _Myoffsets(), _Myattributes(), _Mysizes(),
+        _Mycreation_times(), _Mylast_access_times(), _Mylast_write_times(), _Myfile_ids(),
+        _Myvalid(false), _Mysorted(false) {}
+
+    directory_listing::~directory_listing() noexcept {}
+
+    directory_listing::directory_listing(const path& _Dir) : directory_listing() {
+        read(_Dir);
+    }
+
+    void directory_listing::_Clear() noexcept {
+        _Mynames.clear();
+        _Myfolded_names.clear();
+        _Myoffsets.clear();
+        _Myattributes.clear();
+        _Mysizes.clear();
+        _Mycreation_times.clear();
+        _Mylast_access_times.clear();
+        _Mylast_write_times.clear();
+        _Myfile_ids.clear();
+        _Myvalid  = false;
+        _Mysorted = false;
+    }
+
+    bool directory_listing::read(const path& _Dir) {
+        _Clear();
+        _Mydir = _Dir;
+        _Myoffsets.push_back(0);
+        const auto _Func = [this](const unicode_string_view _Name, const auto& _Info) {
+            const mjfs_impl::_File_id _Id = mjfs_impl::_Make_file_id(0, _Info);
+            _Mynames.insert(_Mynames.end(), _Name.data(), _Name.data() + _Name.size());
+            _Myoffsets.push_back(_Mynames.size());
+            _Myattributes.push_back(static_cast<file_attribute>(_Info.FileAttributes));
+            _Mysizes.push_back(static_cast<uint64_t>(_Info.EndOfFile.QuadPart));
+            _Mycreation_times.push_back(static_cast<uint64_t>(_Info.CreationTime.QuadPart));
+            _Mylast_access_times.push_back(static_cast<uint64_t>(_Info.LastAccessTime.QuadPart));
+            _Mylast_write_times.push_back(static_cast<uint64_t>(_Info.LastWriteTime.QuadPart));
+            _Myfile_ids.push_back(file_id_128{_Id._Low, _Id._High});
+        };
+        bool _Extended_ids = true;
+        if (!mjfs_impl::_For_each_directory_id_info(_Dir.c_str(), _Extended_ids, _Func)) {
+            _Clear();
+            return false;
+        }
+
+        _Myvalid = true;
+        return true;
+    }
+
+    bool directory_listing::valid() const noexcept {
+        return _Myvalid;
+    }
+
+    const path& directory_listing::directory() const noexcept {
+        return _Mydir;
+    }
+
+    size_t directory_listing::size() const noexcept {
+        return _Myattributes.size();
+    }
+
+    bool directory_listing::empty() const noexcept {
+        return _Myattributes.empty();
+    }
+
+    unicode_string_view directory_listing::name(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        const size_t _Offset = _Myoffsets[_Idx];
+        return unicode_string_view{_Mynames.data() + _Offset, _Myoffsets[_Idx + 1] - _Offset};
+    }
+
+    file_attribute directory_listing::attributes(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myattributes[_Idx];
+    }
+
+    uint64_t directory_listing::file_size(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Mysizes[_Idx];
+    }
+
+    uint64_t directory_listing::creation_time(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Mycreation_times[_Idx];
+    }
+
+    uint64_t directory_listing::last_access_time(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Mylast_access_times[_Idx];
+    }
+
+    uint64_t directory_listing::last_write_time(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Mylast_write_times[_Idx];
+    }
+
+    file_id_128 directory_listing::file_id(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myfile_ids[_Idx];
+    }
+
+    void directory_listing::sort() {
+        // Note: The names are folded to upper case once, so the comparisons are plain code unit
+        //       comparisons. The entries are sorted through an array of positions, then each column is
+        //       rearranged at once, so the number of allocations doesn't depend on the number of entries.
+        if (_Mysorted) {
+            return;
+        }
+
+        _Myfolded_names.resize(_Mynames.size());
+        for (size_t _Idx = 0; _Idx < size(); ++_Idx) {
+            mjfs_impl::_Fold_path_chunk(_Mynames.data() + _Myoffsets[_Idx],
+                _Myoffsets[_Idx + 1] - _Myoffsets[_Idx], _Myfolded_names.data() + _Myoffsets[_Idx]);
+        }
+
+        ::std::vector<size_t> _Order(size());
+        ::std::iota(_Order.begin(), _Order.end(), size_t{0});
+        const wchar_t* const _Folded = _Myfolded_names.data();
+        const size_t* const _Offsets = _Myoffsets.data();
+        ::std::sort(_Order.begin(), _Order.end(),
+            [_Folded, _Offsets](const size_t _Left, const size_t _Right) noexcept {
+                return mjfs_impl::_Compare_names(
+                    _Folded + _Offsets[_Left], _Offsets[_Left + 1] - _Offsets[_Left],
+                    _Folded + _Offsets[_Right], _Offsets[_Right + 1] - _Offsets[_Right]) < 0;
+            });
+
+        ::std::vector<size_t> _Old_offsets = _Myoffsets;
+        mjfs_impl::_Reorder_names(_Mynames, _Myoffsets, _Order);
+        mjfs_impl::_Reorder_names(_Myfolded_names, _Old_offsets, _Order);
+        mjfs_impl::_Reorder_column(_Myattributes, _Order);
+        mjfs_impl::_Reorder_column(_Mysizes, _Order);
+        mjfs_impl::_Reorder_column(_Mycreation_times, _Order);
+        mjfs_impl::_Reorder_column(_Mylast_access_times, _Order);
+        mjfs_impl::_Reorder_column(_Mylast_write_times, _Order);
+        mjfs_impl::_Reorder_column(_Myfile_ids, _Order);
+        _Mysorted = true;
+    }
+
+    bool directory_listing::is_sorted() const noexcept {
+        return _Mysorted;
+    }
+
+    size_t directory_listing::find(const unicode_string_view _Name) const noexcept {
+        if (!_Mysorted) { // compare the names one by one
+            for (size_t _Idx = 0; _Idx < size(); ++_Idx) {
+                if (mjfs_impl::_Equal_path_strings_insensitive(name(_Idx), _Name)) {
+                    return _Idx;
+                }
+            }
+
+            return npos;
+        }
+
+        const size_t _Size = _Name.size();
+        if (_Size > MAX_PATH) { // names reported by the system never exceed MAX_PATH characters
+            return npos;
+        }
+
+        wchar_t _Folded_name[MAX_PATH];
+        mjfs_impl::_Fold_path_chunk(_Name.data(), _Size, _Folded_name);
+        size_t _First = 0;
+        size_t _Count = size();
+        while (_Count > 0) { // find the first name that is not less than the searched one
+            const size_t _Half = _Count / 2;
+            const size_t _Mid  = _First + _Half;
+            if (mjfs_impl::_Compare_names(_Myfolded_names.data() + _Myoffsets[_Mid],
+                _Myoffsets[_Mid + 1] - _Myoffsets[_Mid], _Folded_name, _Size) < 0) {
+                _First  = _Mid + 1;
+                _Count -= _Half + 1;
+            } else {
+                _Count = _Half;
+            }
+        }
+
+        if (_First == size() || mjfs_impl::_Compare_names(_Myfolded_names.data() + _Myoffsets[_First],
+            _Myoffsets[_First + 1] - _Myoffsets[_First], _Folded_name, _Size) != 0) {
+            return npos;
+        }
+
+        return _First;
+    }
+} // namespace mjx
@@ -0,0 +1,104 @@
+// directory_listing.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_DIRECTORY_LISTING_HPP_
+#define _MJFS_DIRECTORY_LISTING_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    class _MJFS_API directory_listing { // the entries of a directory, stored column by column
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        directory_listing() noexcept;
+        directory_listing(const directory_listing&)     = default;
+        directory_listing(directory_listing&&) noexcept = default;
+        ~directory_listing() noexcept;
+
+        // Note: The names are stored in a single buffer and the remaining fields in one array each,
+        //       so reading a directory doesn't allocate memory for each entry.
+        explicit directory_listing(const path& _Dir);
+
+        directory_listing& operator=(const directory_listing&)     = default;
+        directory_listing& operator=(directory_listing&&) noexcept = default;
+
+        // replaces the entries with the entries of the directory, the allocated memory is reused
+        bool read(const path& _Dir);
+
+        // checks whether the directory was read successfully
+        bool valid() const noexcept;
+
+        // returns the directory the listing describes
+        const path& directory() const noexcept;
+
+        // returns the number of entries
+        size_t size() const noexcept;
+
+        // checks whether there are no entries
+        bool empty() const noexcept;
+
+        // returns the name of the entry
+        unicode_string_view name(const size_t _Idx) const noexcept;
+
+        // returns the attributes of the entry
+        file_attribute attributes(const size_t _Idx) const noexcept;
+
+        // returns the size of the entry in bytes
+        uint64_t file_size(const size_t _Idx) const noexcept;
+
+        // returns the times of the entry, in 100-nanosecond intervals since January 1, 1601 (UTC)
+        uint64_t creation_time(const size_t _Idx) const noexcept;
+        uint64_t last_access_time(const size_t _Idx) const noexcept;
+        uint64_t last_write_time(const size_t _Idx) const noexcept;
+
+        // returns the file ID of the entry, 128-bit where the volume supports it (e.g. ReFS)
+        file_id_128 file_id(const size_t _Idx) const noexcept;
+
+        // sorts the entries by their names (case-insensitive)
+        void sort();
+
+        // checks whether the entries are sorted
+        bool is_sorted() const noexcept;
+
+        // Note: Returns the position of the entry with the name (case-insensitive), or npos if there is
+        //       no such entry. A sorted listing is searched in logarithmic time, an unsorted one in linear.
+        size_t find(const unicode_string_view _Name) const noexcept;
+
+    private:
+        // clears all columns, but keeps their memory
+        void _Clear() noexcept;
+
+        path _Mydir;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<wchar_t> _Mynames; // the names without the null terminators
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<wchar_t> _Myfolded_names; // the upper-case names, filled only when sorted
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<size_t> _Myoffsets; // the positions of the names, followed by the size of the buffer
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<file_attribute> _Myattributes;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<uint64_t> _Mysizes;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<uint64_t> _Mycreation_times;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<uint64_t> _Mylast_access_times;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<uint64_t> _Mylast_write_times;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<file_id_128> _Myfile_ids;
+        bool _Myvalid;
+        bool _Mysorted;
+    };
+} // namespace mjx
+
+#endif // _MJFS_DIRECTORY_LISTING_HPP_
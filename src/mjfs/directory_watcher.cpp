@@ -0,0 +1,49 @@
+// directory_watcher.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <mjfs/directory_watcher.hpp>
+#include <mjfs/impl/directory_watcher.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <utility>
+
+namespace mjx {
+    directory_watcher::directory_watcher() : directory_watcher(directory_watcher_options{}) {}
+
+    directory_watcher::directory_watcher(const directory_watcher_options& _Options)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Change_watcher>(_Options, watch_callback{})) {}
+
+    directory_watcher::directory_watcher(const directory_watcher_options& _Options, watch_callback _Callback)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Change_watcher>(_Options, ::std::move(_Callback))) {}
+
+    directory_watcher::directory_watcher(directory_watcher&& _Other) noexcept
+        : _Myimpl(::std::move(_Other._Myimpl)) {}
+
+    directory_watcher::~directory_watcher() noexcept {}
+
+    directory_watcher& directory_watcher::operator=(directory_watcher&& _Other) noexcept {
+        _Myimpl = ::std::move(_Other._Myimpl);
+        return *this;
+    }
+
+    bool directory_watcher::watch(const path& _Dir) {
+        return _Myimpl->_Watch(_Dir);
+    }
+
+    bool directory_watcher::unwatch(const path& _Dir) {
+        return _Myimpl->_Unwatch(_Dir);
+    }
+
+    bool directory_watcher::is_watched(const path& _Dir) const {
+        return _Myimpl->_Is_watched(_Dir);
+    }
+
+    bool directory_watcher::poll(::std::vector<watch_event>& _Events) {
+        return _Myimpl->_Poll(_Events);
+    }
+
+    bool directory_watcher::wait(::std::vector<watch_event>& _Events, const uint64_t _Timeout) {
+        return _Myimpl->_Wait(_Events, _Timeout);
+    }
+} // namespace mjx
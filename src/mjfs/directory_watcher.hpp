@@ -0,0 +1,87 @@
+// directory_watcher.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_DIRECTORY_WATCHER_HPP_
+#define _MJFS_DIRECTORY_WATCHER_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mjfs/api.hpp>
+#include <mjfs/path.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Change_watcher;
+    } // namespace mjfs_impl
+
+    enum class watch_event_type : unsigned char {
+        added,
+        removed,
+        modified,
+        renamed,
+        overflow, // some changes were lost, the directory should be scanned again
+        stopped // the directory can no longer be watched (e.g. it was removed)
+    };
+
+    struct watch_event {
+        watch_event_type type;
+        path target; // the changed entry, or the watched directory for overflow and stopped
+        path old_target; // the previous path of a renamed entry, empty otherwise
+    };
+
+    // Note: The events are delivered in batches, once the window since the first event of a batch elapses.
+    //       Repeated modifications of an entry within a batch are reported once.
+    struct directory_watcher_options {
+        bool recursive           = true; // watch the subdirectories as well
+        uint64_t coalesce_window = 50; // the time in milliseconds the events are collected before delivery
+        size_t buffer_size       = 64 * 1024; // the size of the system buffer of each watched directory
+    };
+
+    // Note: Receives each batch of events on the watcher's thread. It should return quickly, since no
+    //       further changes are processed until it returns. If it throws, the batch is considered lost and
+    //       an overflow event of each watched directory is delivered instead.
+    using watch_callback = ::std::function<void(const ::std::vector<watch_event>&)>;
+
+    class _MJFS_API directory_watcher { // reports changes made in the watched directories
+    public:
+        // Note: Without a callback, the events are queued and must be taken with poll() or wait().
+        //       The watcher's thread sleeps while nothing changes.
+        directory_watcher();
+        explicit directory_watcher(const directory_watcher_options& _Options);
+        directory_watcher(const directory_watcher_options& _Options, watch_callback _Callback);
+        directory_watcher(directory_watcher&& _Other) noexcept;
+        ~directory_watcher() noexcept;
+
+        directory_watcher& operator=(directory_watcher&& _Other) noexcept;
+
+        directory_watcher(const directory_watcher&)            = delete;
+        directory_watcher& operator=(const directory_watcher&) = delete;
+
+        // starts watching the directory, does nothing if the directory is already watched
+        bool watch(const path& _Dir);
+
+        // stops watching the directory, the events that were already collected are still delivered
+        bool unwatch(const path& _Dir);
+
+        // checks whether the directory is watched
+        bool is_watched(const path& _Dir) const;
+
+        // Note: Replaces the contents of the vector with the queued events, returns false if there are
+        //       none. The buffers are exchanged, so the vector's memory is reused by the next batch.
+        bool poll(::std::vector<watch_event>& _Events);
+
+        // waits up to the timeout (in milliseconds) for queued events, then behaves like poll()
+        bool wait(::std::vector<watch_event>& _Events, const uint64_t _Timeout);
+
+    private:
+#pragma warning(suppress : 4251) // C4251: unique_smart_ptr<_Change_watcher> needs to have dll-interface
+        unique_smart_ptr<mjfs_impl::_Change_watcher> _Myimpl;
+    };
+} // namespace mjx
+
+#endif // _MJFS_DIRECTORY_WATCHER_HPP_
@@ -61,6 +61,13 @@ namespace mjx {
         unknown
     };
 
+    struct file_id_128 { // the 128-bit file ID, unique within the volume
+        uint64_t low  = 0; // the 64-bit file ID on volumes that have no 128-bit IDs (e.g. NTFS)
+        uint64_t high = 0;
+
+        bool operator==(const file_id_128&) const noexcept = default;
+    };
+
     class _MJFS_API file {
     public:
         using native_handle_type = void*;
@@ -0,0 +1,288 @@
+// glob.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <mjfs/glob.hpp>
+#include <mjfs/impl/glob.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/path.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjstr/string.hpp>
+
+namespace mjx {
+    glob_pattern::glob_pattern() noexcept : _Mytokens(), _Mysegments(), _Myranges(), _Myvalid(false) {}
+
+    glob_pattern::glob_pattern(const glob_pattern& _Other)
+        : _Mytokens(_Other._Mytokens), _Mysegments(_Other._Mysegments),
+        _Myranges(_Other._Myranges), _Myvalid(_Other._Myvalid) {}
+
+    glob_pattern::glob_pattern(glob_pattern&& _Other) noexcept
+        : _Mytokens(::std::move(_Other._Mytokens)), _Mysegments(::std::move(_Other._Mysegments)),
+        _Myranges(::std::move(_Other._Myranges)), _Myvalid(_Other._Myvalid) {
+        _Other._Myvalid = false;
+    }
+
+    glob_pattern::~glob_pattern() noexcept {}
+
+    glob_pattern::glob_pattern(const unicode_string_view _Pattern)
+        : _Mytokens(), _Mysegments(), _Myranges(), _Myvalid(true) {
+        const size_t _Size = _Pattern.size();
+        size_t _Off        = 0;
+        while (_Off < _Size) {
+            if (mjfs_impl::_Is_slash(_Pattern[_Off])) { // skip empty segments
+                ++_Off;
+                continue;
+            }
+
+            size_t _End = _Off;
+            while (_End < _Size && !mjfs_impl::_Is_slash(_Pattern[_End])) {
+                ++_End;
+            }
+
+            if (_Mysegments.size() == max_segments) { // the state would not fit in state_type
+                _Mytokens.clear();
+                _Mysegments.clear();
+                _Myranges.clear();
+                _Myvalid = false;
+                return;
+            }
+
+            _Compile_segment(_Pattern.substr(_Off, _End - _Off));
+            _Off = _End;
+        }
+    }
+
+    glob_pattern& glob_pattern::operator=(const glob_pattern& _Other) {
+        if (this != ::std::addressof(_Other)) {
+            _Mytokens   = _Other._Mytokens;
+            _Mysegments = _Other._Mysegments;
+            _Myranges   = _Other._Myranges;
+            _Myvalid    = _Other._Myvalid;
+        }
+
+        return *this;
+    }
+
+    glob_pattern& glob_pattern::operator=(glob_pattern&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Mytokens       = ::std::move(_Other._Mytokens);
+            _Mysegments     = ::std::move(_Other._Mysegments);
+            _Myranges       = ::std::move(_Other._Myranges);
+            _Myvalid        = _Other._Myvalid;
+            _Other._Myvalid = false;
+        }
+
+        return *this;
+    }
+
+    void glob_pattern::_Compile_segment(const unicode_string_view _Segment_str) {
+        const uint32_t _First_token = static_cast<uint32_t>(_Mytokens.size());
+        if (_Segment_str == L"**") {
+            _Mysegments.push_back(_Segment{_First_token, 0, true});
+            return;
+        }
+
+        // Note: The segment is folded once here, so that matching compares folded characters only.
+        //       Folding doesn't change the meaning of '*', '?', '[', ']', '!', '^' and '-'.
+        const size_t _Size = _Segment_str.size();
+        unicode_string _Folded(_Size, L'\0');
+        mjfs_impl::_Fold_path_chunk(_Segment_str.data(), _Size, _Folded.data());
+        const wchar_t* const _Str = _Folded.data();
+        size_t _Idx               = 0;
+        while (_Idx < _Size) {
+            const wchar_t _Ch = _Str[_Idx];
+            if (_Ch == L'*') {
+                if (_Mytokens.size() == _First_token || _Mytokens.back()._Kind != _Any_sequence) {
+                    _Mytokens.push_back(_Token{_Any_sequence, L'\0', 0, 0}); // "**" inside a segment is "*"
+                }
+
+                ++_Idx;
+            } else if (_Ch == L'?') {
+                _Mytokens.push_back(_Token{_Any_char, L'\0', 0, 0});
+                ++_Idx;
+            } else if (_Ch == L'[') {
+                size_t _Pos          = _Idx + 1;
+                const bool _Negated  = _Pos < _Size && (_Str[_Pos] == L'!' || _Str[_Pos] == L'^');
+                const size_t _Ranges = _Myranges.size();
+                if (_Negated) {
+                    ++_Pos;
+                }
+
+                // Note: A ']' that immediately follows the opening bracket is a member of the set.
+                for (bool _First = true; _Pos < _Size && (_First || _Str[_Pos] != L']'); _First = false) {
+                    const wchar_t _Low = _Str[_Pos];
+                    if (_Pos + 2 < _Size && _Str[_Pos + 1] == L'-' && _Str[_Pos + 2] != L']') {
+                        _Myranges.push_back(_Low);
+                        _Myranges.push_back(_Str[_Pos + 2]);
+                        _Pos += 3;
+                    } else {
+                        _Myranges.push_back(_Low);
+                        _Myranges.push_back(_Low);
+                        ++_Pos;
+                    }
+                }
+
+                if (_Pos >= _Size) { // unterminated set, treat '[' as a literal
+                    _Myranges.resize(_Ranges);
+                    _Mytokens.push_back(_Token{_Literal, L'[', 0, 0});
+                    ++_Idx;
+                    continue;
+                }
+
+                const uint32_t _Range_count = static_cast<uint32_t>((_Myranges.size() - _Ranges) / 2);
+                _Mytokens.push_back(_Token{_Negated ? _Negated_char_set : _Char_set,
+                    L'\0', static_cast<uint32_t>(_Ranges / 2), _Range_count});
+                _Idx = _Pos + 1; // skip the closing bracket
+            } else {
+                _Mytokens.push_back(_Token{_Literal, _Ch, 0, 0});
+                ++_Idx;
+            }
+        }
+
+        _Mysegments.push_back(
+            _Segment{_First_token, static_cast<uint32_t>(_Mytokens.size() - _First_token), false});
+    }
+
+    glob_pattern::state_type glob_pattern::_Closure(state_type _State) const noexcept {
+        // the segments are visited in order, so a chain of globstars is handled in a single pass
+        for (size_t _Idx = 0; _Idx < _Mysegments.size(); ++_Idx) {
+            if (_Mysegments[_Idx]._Globstar && (_State & (state_type{1} << _Idx)) != 0) {
+                _State |= state_type{1} << (_Idx + 1); // "**" may match zero segments
+            }
+        }
+
+        return _State;
+    }
+
+    bool glob_pattern::_Match_segment(
+        const _Segment& _Target, const wchar_t* const _Name, const size_t _Size) const noexcept {
+        // Note: Greedy matching with backtracking to the most recent '*'. Only the most recent '*'
+        //       must be remembered, which keeps the matching linear for typical patterns.
+        const _Token* const _Tokens = _Mytokens.data() + _Target._First_token;
+        const size_t _Count         = _Target._Token_count;
+        size_t _Token_idx           = 0;
+        size_t _Name_idx            = 0;
+        size_t _Star_token          = static_cast<size_t>(-1);
+        size_t _Star_name           = 0;
+        while (_Name_idx < _Size) {
+            if (_Token_idx < _Count) {
+                const _Token& _Current = _Tokens[_Token_idx];
+                const wchar_t _Ch      = _Name[_Name_idx];
+                bool _Matches          = false;
+                switch (_Current._Kind) {
+                case _Any_sequence:
+                    _Star_token = _Token_idx++;
+                    _Star_name  = _Name_idx;
+                    continue;
+                case _Any_char:
+                    _Matches = true;
+                    break;
+                case _Literal:
+                    _Matches = _Current._Ch == _Ch;
+                    break;
+                default: // _Char_set or _Negated_char_set
+                    _Matches = mjfs_impl::_Is_in_char_ranges(
+                        _Myranges.data() + 2 * _Current._First_range, _Current._Range_count, _Ch);
+                    if (_Current._Kind == _Negated_char_set) {
+                        _Matches = !_Matches;
+                    }
+
+                    break;
+                }
+
+                if (_Matches) {
+                    ++_Token_idx;
+                    ++_Name_idx;
+                    continue;
+                }
+            }
+
+            if (_Star_token == static_cast<size_t>(-1)) { // mismatch and nothing to backtrack to
+                return false;
+            }
+
+            _Token_idx = _Star_token + 1;
+            _Name_idx  = ++_Star_name; // let the '*' consume one more character
+        }
+
+        while (_Token_idx < _Count && _Tokens[_Token_idx]._Kind == _Any_sequence) {
+            ++_Token_idx;
+        }
+
+        return _Token_idx == _Count;
+    }
+
+    bool glob_pattern::valid() const noexcept {
+        return _Myvalid;
+    }
+
+    size_t glob_pattern::segments() const noexcept {
+        return _Mysegments.size();
+    }
+
+    bool glob_pattern::match(const unicode_string_view _Path) const {
+        state_type _State  = initial_state();
+        const size_t _Size = _Path.size();
+        size_t _Off        = 0;
+        while (_Off < _Size && _State != 0) {
+            if (mjfs_impl::_Is_slash(_Path[_Off])) {
+                ++_Off;
+                continue;
+            }
+
+            size_t _End = _Off;
+            while (_End < _Size && !mjfs_impl::_Is_slash(_Path[_End])) {
+                ++_End;
+            }
+
+            _State = advance(_State, _Path.substr(_Off, _End - _Off));
+            _Off   = _End;
+        }
+
+        return accepts(_State);
+    }
+
+    glob_pattern::state_type glob_pattern::initial_state() const noexcept {
+        return _Myvalid ? _Closure(1) : 0;
+    }
+
+    glob_pattern::state_type glob_pattern::advance(
+        const state_type _State, const unicode_string_view _Name) const {
+        // Note: Names reported by the system never exceed MAX_PATH characters, so they are folded
+        //       into a local buffer. Longer names (only possible with match()) use a temporary string.
+        const size_t _Size = _Name.size();
+        wchar_t _Buf[MAX_PATH];
+        unicode_string _Long_buf;
+        wchar_t* _Folded = _Buf;
+        if (_Size > MAX_PATH) {
+            _Long_buf.resize(_Size);
+            _Folded = _Long_buf.data();
+        }
+
+        mjfs_impl::_Fold_path_chunk(_Name.data(), _Size, _Folded);
+        state_type _Next = 0;
+        for (size_t _Idx = 0; _Idx < _Mysegments.size(); ++_Idx) {
+            if ((_State & (state_type{1} << _Idx)) == 0) { // segment not active
+                continue;
+            }
+
+            const _Segment& _Current = _Mysegments[_Idx];
+            if (_Current._Globstar) { // "**" consumes the name and stays active
+                _Next |= state_type{1} << _Idx;
+            } else if (_Match_segment(_Current, _Folded, _Size)) {
+                _Next |= state_type{1} << (_Idx + 1);
+            }
+        }
+
+        return _Closure(_Next);
+    }
+
+    bool glob_pattern::accepts(const state_type _State) const noexcept {
+        return _Myvalid && (_State & (state_type{1} << _Mysegments.size())) != 0;
+    }
+
+    bool glob_pattern::can_continue(const state_type _State) const noexcept {
+        return (_State & ((state_type{1} << _Mysegments.size()) - 1)) != 0;
+    }
+} // namespace mjx
@@ -0,0 +1,101 @@
+// glob.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_GLOB_HPP_
+#define _MJFS_GLOB_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    class _MJFS_API glob_pattern { // compiled glob pattern, matches paths relative to a directory
+    public:
+        using state_type = uint64_t;
+
+        // Note: The pattern is split into segments on both slashes. A segment may contain '*' (any
+        //       sequence of characters), '?' (any single character) and '[...]' (any character from
+        //       the set, negated with '!' or '^'). A segment equal to "**" matches zero or more whole
+        //       segments. Matching is case-insensitive, as in the Windows file systems.
+        //       The compiled pattern is a small automaton, the state is a set of the numbers
+        //       of segments matched so far, so at most max_segments segments are supported.
+        static constexpr size_t max_segments = 63;
+
+        glob_pattern() noexcept;
+        glob_pattern(const glob_pattern& _Other);
+        glob_pattern(glob_pattern&& _Other) noexcept;
+        ~glob_pattern() noexcept;
+
+        explicit glob_pattern(const unicode_string_view _Pattern);
+
+        glob_pattern& operator=(const glob_pattern& _Other);
+        glob_pattern& operator=(glob_pattern&& _Other) noexcept;
+
+        // checks whether the pattern was compiled successfully
+        bool valid() const noexcept;
+
+        // returns the number of segments
+        size_t segments() const noexcept;
+
+        // checks whether the relative path matches the pattern
+        bool match(const unicode_string_view _Path) const;
+
+        // returns the state before any path component was matched
+        state_type initial_state() const noexcept;
+
+        // returns the state after matching the next path component
+        state_type advance(const state_type _State, const unicode_string_view _Name) const;
+
+        // checks whether the path components matched so far match the whole pattern
+        bool accepts(const state_type _State) const noexcept;
+
+        // checks whether more path components can still lead to a match
+        bool can_continue(const state_type _State) const noexcept;
+
+    private:
+        enum _Token_kind : unsigned char {
+            _Literal,
+            _Any_char,
+            _Any_sequence,
+            _Char_set,
+            _Negated_char_set
+        };
+
+        struct _Token {
+            _Token_kind _Kind;
+            wchar_t _Ch; // folded character, only for literals
+            uint32_t _First_range; // index of the first range, only for sets
+            uint32_t _Range_count; // number of ranges, only for sets
+        };
+
+        struct _Segment {
+            uint32_t _First_token; // index of the first token
+            uint32_t _Token_count; // number of tokens
+            bool _Globstar; // true if the segment is "**"
+        };
+
+        // compiles a single segment of the pattern
+        void _Compile_segment(const unicode_string_view _Segment_str);
+
+        // applies the globstar transitions, which don't consume any path component
+        state_type _Closure(state_type _State) const noexcept;
+
+        // checks whether the folded name matches the segment
+        bool _Match_segment(
+            const _Segment& _Target, const wchar_t* const _Name, const size_t _Size) const noexcept;
+
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<_Token> _Mytokens;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<_Segment> _Mysegments;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<wchar_t> _Myranges; // pairs of folded range bounds
+        bool _Myvalid;
+    };
+} // namespace mjx
+
+#endif // _MJFS_GLOB_HPP_
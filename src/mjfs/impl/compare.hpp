@@ -0,0 +1,135 @@
+// compare.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_COMPARE_HPP_
+#define _MJFS_IMPL_COMPARE_HPP_
+#include <algorithm>
+#include <cstddef>
+#include <emmintrin.h>
+#include <intrin.h>
+#include <mjfs/impl/path.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline size_t _Find_mismatch(
+            const wchar_t* const _Left, const wchar_t* const _Right, const size_t _Count) noexcept {
+            // compares 8 code units at once, returns the length of the common prefix
+            size_t _Off = 0;
+            for (; _Off + 8 <= _Count; _Off += 8) {
+                const __m128i _Left_block  = ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Left + _Off));
+                const __m128i _Right_block =
+                    ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Right + _Off));
+                const int _Mask = ::_mm_movemask_epi8(::_mm_cmpeq_epi16(_Left_block, _Right_block));
+                if (_Mask != 0xFFFF) {
+                    unsigned long _Bit;
+                    ::_BitScanForward(&_Bit, static_cast<unsigned long>(~_Mask & 0xFFFF));
+                    return _Off + _Bit / 2; // each code unit has 2 bits in the mask
+                }
+            }
+
+            while (_Off < _Count && _Left[_Off] == _Right[_Off]) {
+                ++_Off;
+            }
+
+            return _Off;
+        }
+
+        inline size_t _Skip_slashes(const wchar_t* const _Str, const size_t _Size, size_t _Off) noexcept {
+            while (_Off < _Size && _Is_slash(_Str[_Off])) {
+                ++_Off;
+            }
+
+            return _Off;
+        }
+
+        inline int _Compare_relative_paths(const wchar_t* const _Left, const size_t _Left_size,
+            const wchar_t* const _Right, const size_t _Right_size) noexcept {
+            // Note: Comparing the strings with every separator treated as a character lower than any
+            //       other gives the same result as comparing the elements one by one, because an element
+            //       that is a prefix of another ends with a separator (or the end of the path) where
+            //       the other one continues. Consecutive separators are treated as one.
+            size_t _Left_off  = 0;
+            size_t _Right_off = 0;
+            for (;;) {
+                const size_t _Count = (::std::min)(_Left_size - _Left_off, _Right_size - _Right_off);
+                const size_t _Same  = _Find_mismatch(_Left + _Left_off, _Right + _Right_off, _Count);
+                _Left_off          += _Same;
+                _Right_off         += _Same;
+                if (_Left_off > 0 && _Is_slash(_Left[_Left_off - 1])) { // collapse separators
+                    const size_t _New_left_off  = _Skip_slashes(_Left, _Left_size, _Left_off);
+                    const size_t _New_right_off = _Skip_slashes(_Right, _Right_size, _Right_off);
+                    if (_New_left_off != _Left_off || _New_right_off != _Right_off) {
+                        _Left_off  = _New_left_off;
+                        _Right_off = _New_right_off;
+                        continue;
+                    }
+                }
+
+                if (_Left_off == _Left_size || _Right_off == _Right_size) { // the shorter path is less
+                    if (_Left_off == _Left_size) {
+                        return _Right_off == _Right_size ? 0 : -1;
+                    } else {
+                        return 1;
+                    }
+                }
+
+                const wchar_t _Left_ch  = _Left[_Left_off];
+                const wchar_t _Right_ch = _Right[_Right_off];
+                if (_Is_slash(_Left_ch)) {
+                    if (_Is_slash(_Right_ch)) { // different, but equivalent separators
+                        ++_Left_off;
+                        ++_Right_off;
+                        continue;
+                    }
+
+                    return -1; // the left element is a prefix of the right one
+                } else if (_Is_slash(_Right_ch)) {
+                    return 1; // the right element is a prefix of the left one
+                } else {
+                    return _Left_ch < _Right_ch ? -1 : 1;
+                }
+            }
+        }
+
+        inline size_t _Root_name_length(const wchar_t* const _Str, const size_t _Size) noexcept {
+            return _Size >= 2 && _Is_drive_prefix(_Str[0]) && _Str[1] == L':' ? 2 : 0;
+        }
+
+        inline int _Compare_paths(const unicode_string_view _Left, const unicode_string_view _Right) noexcept {
+            // Note: The root names are compared first, then the presence of the root directories and
+            //       then the remaining elements. The strings are accessed through raw pointers only,
+            //       so the comparison doesn't call into the string library in the inner loop.
+            const wchar_t* const _Left_data  = _Left.data();
+            const size_t _Left_size          = _Left.size();
+            const wchar_t* const _Right_data = _Right.data();
+            const size_t _Right_size         = _Right.size();
+            const size_t _Left_root          = _Root_name_length(_Left_data, _Left_size);
+            const size_t _Right_root         = _Root_name_length(_Right_data, _Right_size);
+            if (_Left_root != _Right_root) {
+                return _Left_root < _Right_root ? -1 : 1;
+            } else if (_Left_root > 0 && _Left_data[0] != _Right_data[0]) { // compare the drive letters
+                return _Left_data[0] < _Right_data[0] ? -1 : 1;
+            }
+
+            const bool _Left_has_root_dir  = _Left_root < _Left_size && _Is_slash(_Left_data[_Left_root]);
+            const bool _Right_has_root_dir = _Right_root < _Right_size && _Is_slash(_Right_data[_Right_root]);
+            if (_Left_has_root_dir != _Right_has_root_dir) {
+                return _Left_has_root_dir ? 1 : -1;
+            }
+
+            // redundant separators after the root directory are ignored
+            const size_t _Left_off  = _Left_has_root_dir
+                ? _Skip_slashes(_Left_data, _Left_size, _Left_root) : _Left_root;
+            const size_t _Right_off = _Right_has_root_dir
+                ? _Skip_slashes(_Right_data, _Right_size, _Right_root) : _Right_root;
+            return _Compare_relative_paths(_Left_data + _Left_off, _Left_size - _Left_off,
+                _Right_data + _Right_off, _Right_size - _Right_off);
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_COMPARE_HPP_
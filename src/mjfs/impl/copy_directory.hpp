@@ -0,0 +1,477 @@
+// copy_directory.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_COPY_DIRECTORY_HPP_
+#define _MJFS_IMPL_COPY_DIRECTORY_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/bitmask.hpp>
+#include <mjfs/directory.hpp>
+#include <mjfs/impl/file.hpp>
+#include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/parallel.hpp>
+#include <mjfs/impl/path.hpp>
+#include <mjfs/impl/remove_all.hpp>
+#include <mjfs/impl/status.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/impl/work_queue.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        // the attributes that can be set on an existing file or directory
+        inline constexpr unsigned long _Settable_attributes = FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_HIDDEN
+            | FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_ARCHIVE | FILE_ATTRIBUTE_TEMPORARY
+            | FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_NOT_CONTENT_INDEXED;
+
+        // the largest range cloned at once, a multiple of any cluster size
+        inline constexpr uint64_t _Clone_chunk_size = uint64_t{1} << 30;
+
+        inline int64_t _Filetime_to_int64(const FILETIME& _Time) noexcept {
+            return static_cast<int64_t>(_Make_uint64(_Time.dwHighDateTime, _Time.dwLowDateTime));
+        }
+
+        inline unsigned long _Get_clone_cluster_size(const wchar_t* const _Dir) noexcept {
+            // Note: Block cloning needs a volume that counts the references to its blocks (e.g. ReFS).
+            //       The cloned ranges must be aligned to the cluster size, which is returned,
+            //       or 0 if the volume cannot clone.
+            _Close_handle_guard _Guard = {::CreateFileW(_Dir, FILE_READ_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+            if (!_Guard._Holds_valid_handle()) {
+                return 0;
+            }
+
+            unsigned long _Flags = 0;
+            if (::GetVolumeInformationByHandleW(
+                _Guard._Handle, nullptr, 0, nullptr, nullptr, &_Flags, nullptr, 0) == 0
+                || (_Flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) == 0) {
+                return 0;
+            }
+
+            ::std::vector<wchar_t> _Volume(::wcslen(_Dir) + 2);
+            unsigned long _Sectors_per_cluster;
+            unsigned long _Bytes_per_sector;
+            unsigned long _Free_clusters;
+            unsigned long _Total_clusters;
+            if (::GetVolumePathNameW(_Dir, _Volume.data(), static_cast<unsigned long>(_Volume.size())) == 0
+                || ::GetDiskFreeSpaceW(_Volume.data(), &_Sectors_per_cluster, &_Bytes_per_sector,
+                    &_Free_clusters, &_Total_clusters) == 0) {
+                return 0;
+            }
+
+            return _Sectors_per_cluster * _Bytes_per_sector;
+        }
+
+        inline void _Preserve_basic_info(FILE_BASIC_INFO& _Info, const bool _All_times) noexcept {
+            // Note: The zero values are left unchanged by SetFileInformationByHandle().
+            _Info.ChangeTime.QuadPart = 0;
+            if (!_All_times) { // keep only the last write time, like CopyFileExW()
+                _Info.CreationTime.QuadPart   = 0;
+                _Info.LastAccessTime.QuadPart = 0;
+            }
+
+            _Info.FileAttributes &= _Settable_attributes;
+            if (_Info.FileAttributes == 0) {
+                _Info.FileAttributes = FILE_ATTRIBUTE_NORMAL;
+            }
+        }
+
+        enum class _Clone_result : unsigned char {
+            _Success,
+            _Failure, // the target cannot be created, the error is set
+            _Unsupported // the file cannot be cloned, it must be copied
+        };
+
+        inline _Clone_result _Clone_file(const wchar_t* const _From, const wchar_t* const _To,
+            const unsigned long _Disposition, const uint64_t _Cluster_size, const bool _All_times) noexcept {
+            _Close_handle_guard _Source = {::CreateFileW(_From, GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr)};
+            if (!_Source._Holds_valid_handle()) {
+                return _Clone_result::_Failure;
+            }
+
+            FILE_BASIC_INFO _Info = _Get_file_basic_info(_Source._Handle);
+            FILE_END_OF_FILE_INFO _Size;
+            if (_Info.FileAttributes == 0 || ::GetFileSizeEx(_Source._Handle, &_Size.EndOfFile) == 0) {
+                return _Clone_result::_Failure;
+            }
+
+            _Close_handle_guard _Target = {::CreateFileW(_To, GENERIC_READ | GENERIC_WRITE | DELETE, 0,
+                nullptr, _Disposition, FILE_ATTRIBUTE_NORMAL, nullptr)};
+            if (!_Target._Holds_valid_handle()) {
+                return _Clone_result::_Failure;
+            }
+
+            unsigned long _Bytes = 0;
+            if ((_Info.FileAttributes & FILE_ATTRIBUTE_SPARSE_FILE) != 0) { // keep the holes unallocated
+                ::DeviceIoControl(_Target._Handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &_Bytes, nullptr);
+            }
+
+            bool _Cloned = _Set_file_information<FileEndOfFileInfo>(_Target._Handle, _Size);
+            const uint64_t _File_size = static_cast<uint64_t>(_Size.EndOfFile.QuadPart);
+            for (uint64_t _Offset = 0; _Cloned && _Offset < _File_size; _Offset += _Clone_chunk_size) {
+                // the last range is rounded up to the cluster size, the end of the file is kept
+                uint64_t _Count = _File_size - _Offset;
+                if (_Count > _Clone_chunk_size) {
+                    _Count = _Clone_chunk_size;
+                } else {
+                    _Count = (_Count + _Cluster_size - 1) / _Cluster_size * _Cluster_size;
+                }
+
+                DUPLICATE_EXTENTS_DATA _Extents;
+                _Extents.FileHandle                = _Source._Handle;
+                _Extents.SourceFileOffset.QuadPart = static_cast<int64_t>(_Offset);
+                _Extents.TargetFileOffset.QuadPart = static_cast<int64_t>(_Offset);
+                _Extents.ByteCount.QuadPart        = static_cast<int64_t>(_Count);
+                _Cloned = ::DeviceIoControl(_Target._Handle, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &_Extents,
+                    sizeof(_Extents), nullptr, 0, &_Bytes, nullptr) != 0;
+            }
+
+            if (!_Cloned) { // remove the incomplete target once its handle is closed
+                _Set_delete_flag(_Target._Handle);
+                return _Clone_result::_Unsupported;
+            }
+
+            _Preserve_basic_info(_Info, _All_times);
+            _Set_file_information<FileBasicInfo>(_Target._Handle, _Info);
+            return _Clone_result::_Success;
+        }
+
+        inline bool _Copy_basic_info(const wchar_t* const _From, const wchar_t* const _To,
+            const bool _All_times, const bool _Attributes) noexcept {
+            WIN32_FILE_ATTRIBUTE_DATA _Data;
+            if (::GetFileAttributesExW(_From, GetFileExInfoStandard, &_Data) == 0) {
+                return false;
+            }
+
+            _Close_handle_guard _Guard = {::CreateFileW(_To, FILE_WRITE_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, nullptr)};
+            if (!_Guard._Holds_valid_handle()) {
+                return false;
+            }
+
+            FILE_BASIC_INFO _Info        = {};
+            _Info.FileAttributes         = _Data.dwFileAttributes;
+            _Info.LastWriteTime.QuadPart = _Filetime_to_int64(_Data.ftLastWriteTime);
+            if (_All_times) {
+                _Info.CreationTime.QuadPart   = _Filetime_to_int64(_Data.ftCreationTime);
+                _Info.LastAccessTime.QuadPart = _Filetime_to_int64(_Data.ftLastAccessTime);
+            }
+
+            _Preserve_basic_info(_Info, _All_times);
+            if (!_Attributes) {
+                _Info.FileAttributes = 0;
+            }
+
+            return _Set_file_information<FileBasicInfo>(_Guard._Handle, _Info);
+        }
+
+        inline bool _Get_full_path(const wchar_t* const _Target, path::string_type& _Full) {
+            // the first call returns the length including the null-terminator, the second one without it
+            const unsigned long _Length = ::GetFullPathNameW(_Target, 0, nullptr, nullptr);
+            if (_Length == 0) {
+                return false;
+            }
+
+            _Full.resize(_Length - 1);
+            return ::GetFullPathNameW(_Target, _Length, _Full.data(), nullptr) == _Length - 1;
+        }
+
+        inline bool _Is_inside_source(const path& _From, const path& _To) {
+            // Note: A target inside the source would be enumerated as a part of the source, so it would be
+            //       copied into itself until the path becomes too long. The target and its parents are
+            //       compared with the source by their file IDs, which also covers other spellings of the same
+            //       path and links. The parts of the target that don't exist yet are skipped.
+            _File_id _Source;
+            unsigned long _Links;
+            path::string_type _Full;
+            if (!_Get_file_id(_From.c_str(), _Source, _Links) || !_Get_full_path(_To.c_str(), _Full)) {
+                return false;
+            }
+
+            const size_t _Root   = _Get_root_path(_Full).size();
+            wchar_t* const _Data = _Full.data();
+            size_t _Size         = _Skip_trailing_slashes(_Full, _Full.size(), _Root);
+            for (;;) {
+                if (_Size > 1) { // the leading slash of a UNC path is not a directory
+                    const wchar_t _Old = _Data[_Size];
+                    _Data[_Size]       = L'\0';
+                    _File_id _Id;
+                    const bool _Found = _Get_file_id(_Data, _Id, _Links);
+                    _Data[_Size]      = _Old;
+                    if (_Found && _Id == _Source) {
+                        return true;
+                    }
+                }
+
+                if (_Size <= _Root) {
+                    return false;
+                }
+
+                _Size = _Get_parent_prefix_size(_Full, _Size, _Root);
+            }
+        }
+
+        struct _Copy_task {
+            path _From;
+            path _To;
+            bool _Link; // a link to a file, copied as a link
+        };
+
+        struct _Copy_node { // a directory whose entries are being copied
+            path _From;
+            path _To;
+            size_t _Depth; // the depth below the source directory, 0 for the source directory itself
+        };
+
+        class _Tree_copier { // copies a directory tree, the directories are read by multiple threads
+        public:
+            explicit _Tree_copier(const copy_options _Options) noexcept
+                : _Myoptions(_Options), _Myqueue(), _Mymtx(), _Mydirs(), _Myfiles(), _Mycluster_size(0),
+                _Mycan_clone(false), _Mycopied(0), _Mycloned(0), _Myskipped(0), _Mycreated(0), _Myerror() {}
+
+            _Tree_copier(const _Tree_copier&)            = delete;
+            _Tree_copier& operator=(const _Tree_copier&) = delete;
+
+            bool _Copy(const path& _From, const path& _To, copy_directory_stats& _Stats) {
+                const unsigned long _Attributes = ::GetFileAttributesW(_From.c_str());
+                if (_Attributes == INVALID_FILE_ATTRIBUTES) {
+                    _Myerror._Set(_From, ::GetLastError());
+                } else if (!_Is_directory_not_link(_Attributes)) {
+                    _Myerror._Set(_From, ERROR_DIRECTORY);
+                } else if (_Is_inside_source(_From, _To)) { // nothing is created
+                    _Myerror._Set(_To, ERROR_INVALID_PARAMETER);
+                } else if (_Create_directory(_To, true)) {
+                    _Check_cloning(_From, _To);
+                    _Create_skeleton(_From, _To);
+                    _Parallel_for(_Myfiles.size(), [this](const size_t _Idx) {
+                        _Copy_file(_Myfiles[_Idx]);
+                    });
+                    _Copy_directory_info();
+                }
+
+                _Stats.copied_files        = _Mycopied.load(::std::memory_order_relaxed);
+                _Stats.cloned_files        = _Mycloned.load(::std::memory_order_relaxed);
+                _Stats.skipped_files       = _Myskipped.load(::std::memory_order_relaxed);
+                _Stats.created_directories = _Mycreated.load(::std::memory_order_relaxed);
+                _Myerror._Report(_Stats.error, _Stats.failed_path);
+                return _Stats.error == 0;
+            }
+
+        private:
+            bool _Create_directory(const path& _Dir, const bool _With_parents) {
+                if (::mjx::create_directory(_Dir)) {
+                    _Mycreated.fetch_add(1, ::std::memory_order_relaxed);
+                    return true;
+                }
+
+                unsigned long _Error = ::GetLastError();
+                if (_Error == ERROR_ALREADY_EXISTS
+                    && _Is_directory_not_link(::GetFileAttributesW(_Dir.c_str()))) {
+                    return true; // merge with the existing directory
+                }
+
+                if (_Error == ERROR_PATH_NOT_FOUND && _With_parents) { // some of the parents are missing
+                    if (::mjx::create_directories(_Dir)) {
+                        _Mycreated.fetch_add(1, ::std::memory_order_relaxed);
+                        return true;
+                    }
+
+                    _Error = ::GetLastError();
+                }
+
+                _Myerror._Set(_Dir, _Error);
+                return false;
+            }
+
+            void _Check_cloning(const path& _From, const path& _To) {
+                // Note: Only the files on the same volume can be cloned. The links to directories are not
+                //       followed, so all sources are on the volume of the source directory.
+                _Mycluster_size = _Get_clone_cluster_size(_To.c_str());
+                if (_Mycluster_size == 0) {
+                    return;
+                }
+
+                _File_id _Source;
+                _File_id _Target;
+                unsigned long _Links;
+                _Mycan_clone = _Get_file_id(_From.c_str(), _Source, _Links)
+                            && _Get_file_id(_To.c_str(), _Target, _Links)
+                            && _Source._Volume == _Target._Volume;
+            }
+
+            void _Create_skeleton(const path& _From, const path& _To) {
+                // Note: The whole directory structure is created before any file is copied, so the copying
+                //       threads never wait for a parent directory. A directory is queued only once it has
+                //       been created, so its subdirectories can be created by any thread. The source
+                //       directory is read by the calling thread before any thread is started.
+                _Mydirs.push_back(_Copy_node{_From, _To, 0});
+                _Myqueue._Begin();
+                _Process(_Copy_node{_From, _To, 0});
+                if (_Myqueue._Finish_one()) {
+                    return;
+                }
+
+                const size_t _Workers = _Get_worker_count(_Max_worker_count);
+                _Thread_group _Group;
+                if (_Workers > 1) {
+                    _Group._Start(_Workers - 1, [this] { _Work(); });
+                }
+
+                _Group._Run([this] { _Work(); });
+                _Group._Join();
+            }
+
+            void _Work() {
+                _Myqueue._Work([this](const _Copy_node& _Node) { _Process(_Node); });
+            }
+
+            void _Process(const _Copy_node& _Node) {
+                ::std::vector<_Copy_node> _Subdirs;
+                ::std::vector<_Copy_task> _Files;
+                const auto _Func = [this, &_Node, &_Subdirs, &_Files](
+                    const unicode_string_view _Name, const FILE_FULL_DIR_INFO& _Info) {
+                    if (_Is_directory_not_link(_Info.FileAttributes)) {
+                        path _Target = _Node._To / _Name;
+                        if (_Create_directory(_Target, false)) {
+                            _Subdirs.push_back(
+                                _Copy_node{_Node._From / _Name, ::std::move(_Target), _Node._Depth + 1});
+                        }
+                    } else if ((_Info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) { // a file or its link
+                        _Files.push_back(_Copy_task{_Node._From / _Name, _Node._To / _Name,
+                            (_Info.FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0});
+                    } // the links to directories are not copied
+                };
+                if (!_For_each_directory_info<FILE_FULL_DIR_INFO>(
+                    _Node._From.c_str(), FileFullDirectoryInfo, _Func)) {
+                    _Myerror._Set(_Node._From, ::GetLastError());
+                }
+
+                if (!_Subdirs.empty() || !_Files.empty()) {
+                    ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                    _Mydirs.insert(_Mydirs.end(), _Subdirs.begin(), _Subdirs.end());
+                    for (_Copy_task& _File : _Files) {
+                        _Myfiles.push_back(::std::move(_File));
+                    }
+                }
+
+                _Myqueue._Push(_Subdirs);
+            }
+
+            bool _Should_skip(const path& _From, const path& _To) noexcept {
+                // checks whether the existing target is at least as new as its source
+                WIN32_FILE_ATTRIBUTE_DATA _Source;
+                WIN32_FILE_ATTRIBUTE_DATA _Target;
+                if (::GetFileAttributesExW(_To.c_str(), GetFileExInfoStandard, &_Target) == 0
+                    || ::GetFileAttributesExW(_From.c_str(), GetFileExInfoStandard, &_Source) == 0) {
+                    return false;
+                }
+
+                return _Filetime_to_int64(_Target.ftLastWriteTime)
+                    >= _Filetime_to_int64(_Source.ftLastWriteTime);
+            }
+
+            void _Copy_file(const _Copy_task& _Task) {
+                const path& _From     = _Task._From;
+                const path& _To       = _Task._To;
+                const bool _Replace   = _Has_bits(_Myoptions, copy_options::overwrite_existing)
+                                     || _Has_bits(_Myoptions, copy_options::update_existing);
+                const bool _All_times = _Has_bits(_Myoptions, copy_options::preserve_times);
+                if (_Has_bits(_Myoptions, copy_options::update_existing) && _Should_skip(_From, _To)) {
+                    _Myskipped.fetch_add(1, ::std::memory_order_relaxed);
+                    return;
+                }
+
+                if (!_Task._Link && _Mycan_clone) {
+                    switch (_Clone_file(_From.c_str(), _To.c_str(), _Replace ? CREATE_ALWAYS : CREATE_NEW,
+                        _Mycluster_size, _All_times)) {
+                    case _Clone_result::_Success:
+                        _Mycopied.fetch_add(1, ::std::memory_order_relaxed);
+                        _Mycloned.fetch_add(1, ::std::memory_order_relaxed);
+                        return;
+                    case _Clone_result::_Failure:
+                        _Copy_failed(_From, _To, ::GetLastError());
+                        return;
+                    default: // the volume refused to clone this file, copy it instead
+                        break;
+                    }
+                }
+
+                // Note: CopyFileExW() copies the data within the system (and clones it where possible),
+                //       along with the attributes and the last write time. The links are copied as links.
+                unsigned long _Flags = COPY_FILE_COPY_SYMLINK;
+                if (!_Replace) {
+                    _Flags |= COPY_FILE_FAIL_IF_EXISTS;
+                }
+
+                if (::CopyFileExW(_From.c_str(), _To.c_str(), nullptr, nullptr, nullptr, _Flags) == 0) {
+                    _Copy_failed(_From, _To, ::GetLastError());
+                    return;
+                }
+
+                if (_All_times) {
+                    _Copy_basic_info(_From.c_str(), _To.c_str(), true, false);
+                }
+
+                _Mycopied.fetch_add(1, ::std::memory_order_relaxed);
+            }
+
+            void _Copy_failed(const path& _From, const path& _To, const unsigned long _Error) {
+                if (_Has_bits(_Myoptions, copy_options::skip_existing)
+                    && (_Error == ERROR_FILE_EXISTS || _Error == ERROR_ALREADY_EXISTS)) {
+                    _Myskipped.fetch_add(1, ::std::memory_order_relaxed);
+                } else {
+                    const bool _Exists = _Error == ERROR_FILE_EXISTS || _Error == ERROR_ALREADY_EXISTS;
+                    _Myerror._Set(_Exists ? _To : _From, _Error);
+                }
+            }
+
+            void _Copy_directory_info() {
+                // Note: Copying the files changes the last write times of the directories, so they are set
+                //       once all files are copied, from the deepest directories up.
+                const bool _All_times  = _Has_bits(_Myoptions, copy_options::preserve_times);
+                const bool _Attributes = _Has_bits(_Myoptions, copy_options::preserve_attributes);
+                if (!_All_times && !_Attributes) {
+                    return;
+                }
+
+                const auto _Deeper = [](const _Copy_node& _Left, const _Copy_node& _Right) noexcept {
+                    return _Left._Depth > _Right._Depth;
+                };
+                ::std::stable_sort(_Mydirs.begin(), _Mydirs.end(), _Deeper);
+                for (const _Copy_node& _Dir : _Mydirs) {
+                    if (!_Copy_basic_info(_Dir._From.c_str(), _Dir._To.c_str(), _All_times, _Attributes)) {
+                        _Myerror._Set(_Dir._To, ::GetLastError());
+                    }
+                }
+            }
+
+            copy_options _Myoptions;
+            _Work_queue<_Copy_node> _Myqueue;
+            ::std::mutex _Mymtx; // guards the directories and the files
+            ::std::vector<_Copy_node> _Mydirs; // the copied directories, in no particular order
+            ::std::vector<_Copy_task> _Myfiles;
+            uint64_t _Mycluster_size; // the cluster size of the target volume, 0 if it cannot clone
+            bool _Mycan_clone; // true if the files can be cloned, a single file may still be refused
+            ::std::atomic<uint64_t> _Mycopied;
+            ::std::atomic<uint64_t> _Mycloned;
+            ::std::atomic<uint64_t> _Myskipped;
+            ::std::atomic<uint64_t> _Mycreated;
+            _First_error _Myerror;
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_COPY_DIRECTORY_HPP_
@@ -6,12 +6,22 @@
 #pragma once
 #ifndef _MJFS_IMPL_DIRECTORY_HPP_
 #define _MJFS_IMPL_DIRECTORY_HPP_
+#include <algorithm>
+#include <cstddef>
 #include <cwchar>
 #include <mjfs/directory.hpp>
+#include <mjfs/glob.hpp>
+#include <mjfs/impl/directory_listing.hpp>
+#include <mjfs/impl/file.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/hash.hpp>
 #include <mjfs/impl/path.hpp>
 #include <mjfs/impl/tinywin.hpp>
 #include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace mjx {
@@ -51,6 +61,82 @@ namespace mjx {
             _Path = ::std::move(_Str);
         }
 
+        inline bool _Is_existing_directory(const wchar_t* const _Target) noexcept {
+            const unsigned long _Attributes = ::GetFileAttributesW(_Target);
+            return _Attributes != INVALID_FILE_ATTRIBUTES && (_Attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        }
+
+        inline unsigned long _Create_directory_prefix(path::string_type& _Buf, const size_t _Size) noexcept {
+            // creates the directory named by the first _Size characters, returns the error code
+            if (_Size == _Buf.size()) { // already null-terminated
+                return ::CreateDirectoryW(_Buf.c_str(), nullptr) != 0 ? ERROR_SUCCESS : ::GetLastError();
+            }
+
+            const wchar_t _Old = _Buf[_Size];
+            _Buf[_Size]        = L'\0';
+            const unsigned long _Error =
+                ::CreateDirectoryW(_Buf.c_str(), nullptr) != 0 ? ERROR_SUCCESS : ::GetLastError();
+            _Buf[_Size] = _Old;
+            return _Error;
+        }
+
+        inline size_t _Skip_trailing_slashes(
+            const unicode_string_view _Str, size_t _Size, const size_t _Root) noexcept {
+            // returns the size of the first _Size characters without the trailing slashes, keeps the root
+            while (_Size > _Root && _Is_slash(_Str[_Size - 1])) {
+                --_Size;
+            }
+
+            return _Size;
+        }
+
+        inline size_t _Get_parent_prefix_size(
+            const unicode_string_view _Str, size_t _Size, const size_t _Root) noexcept {
+            // returns the size of the parent directory of the first _Size characters, _Root if there is none
+            while (_Size > _Root && !_Is_slash(_Str[_Size - 1])) {
+                --_Size;
+            }
+
+            return _Skip_trailing_slashes(_Str, _Size, _Root);
+        }
+
+        inline bool _Create_missing_directories(path::string_type& _Buf) {
+            // Note: The deepest directory has already been found to be missing, so the path is walked back
+            //       until a directory can be created or already exists, then created forward from there.
+            //       A directory created by someone else in the meantime counts as created.
+            const size_t _Root = _Get_root_path(_Buf).size();
+            size_t _Size       = _Skip_trailing_slashes(_Buf, _Buf.size(), _Root);
+            ::std::vector<size_t> _Missing; // the sizes of the missing prefixes, the deepest first
+            unsigned long _Error = ERROR_PATH_NOT_FOUND;
+            for (;;) {
+                _Missing.push_back(_Size);
+                _Size = _Get_parent_prefix_size(_Buf, _Size, _Root);
+                if (_Size <= _Root) { // the first directory below the root is missing, and was already tried
+                    return false;
+                }
+
+                _Error = _Create_directory_prefix(_Buf, _Size);
+                if (_Error != ERROR_PATH_NOT_FOUND) {
+                    // Note: Other errors are expected for prefixes that cannot be created, but may exist
+                    //       (e.g. "\\server\share"). The next directory reveals whether the prefix exists.
+                    break;
+                }
+            }
+
+            while (!_Missing.empty()) {
+                _Error = _Create_directory_prefix(_Buf, _Missing.back());
+                if (_Error != ERROR_SUCCESS && _Error != ERROR_ALREADY_EXISTS) {
+                    ::SetLastError(_Error);
+                    return false;
+                }
+
+                _Missing.pop_back();
+            }
+
+            // an existing entry with the same name as the target may be a file
+            return _Error == ERROR_SUCCESS || _Is_existing_directory(_Buf.c_str());
+        }
+
         class _Copied_filename { // temporary buffer for filename
         public:
             wchar_t _Raw[260]; // must fit cFileName from WIN32_FIND_DATAW
@@ -61,21 +147,210 @@ namespace mjx {
             }
         };
 
+        // the size of the buffer for the directory information, fits a few hundred typical entries
+        inline constexpr size_t _Directory_info_buffer_size = 32 * 1024;
+
+        template <class _Info, class _Fn>
+        inline bool _For_each_directory_info(
+            const wchar_t* const _Dir, const FILE_INFO_BY_HANDLE_CLASS _Class, _Fn&& _Func) {
+            // Note: The entries are read straight into a local buffer, so no memory is allocated.
+            //       The names in the buffer are not null-terminated, the dots are skipped. The class
+            //       must be FileFullDirectoryInfo, FileIdBothDirectoryInfo or FileIdExtdDirectoryInfo,
+            //       matching the info type.
+            _Close_handle_guard _Guard = {::CreateFileW(_Dir, FILE_LIST_DIRECTORY,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+            if (!_Guard._Holds_valid_handle()) {
+                return false;
+            }
+
+            alignas(8) unsigned char _Buf[_Directory_info_buffer_size];
+            constexpr unsigned long _Size = static_cast<unsigned long>(_Directory_info_buffer_size);
+            while (::GetFileInformationByHandleEx(_Guard._Handle, _Class, _Buf, _Size) != 0) {
+                const unsigned char* _Ptr = _Buf;
+                for (;;) {
+                    const _Info* const _Entry = reinterpret_cast<const _Info*>(_Ptr);
+                    const unicode_string_view _Name(
+                        _Entry->FileName, _Entry->FileNameLength / sizeof(wchar_t));
+                    if (!_Is_dot_or_dot_dot(_Name)) {
+                        _Func(_Name, *_Entry);
+                    }
+
+                    if (_Entry->NextEntryOffset == 0) { // the last entry in the buffer
+                        break;
+                    }
+
+                    _Ptr += _Entry->NextEntryOffset;
+                }
+            }
+
+            return ::GetLastError() == ERROR_NO_MORE_FILES;
+        }
+
+        template <class _Fn>
+        inline bool _For_each_directory_id_info(const wchar_t* const _Dir, bool& _Extended_ids, _Fn&& _Func) {
+            // Note: The entries are passed as FILE_ID_EXTD_DIR_INFO, whose 128-bit IDs are required on ReFS,
+            //       or as FILE_ID_BOTH_DIR_INFO if the volume doesn't support them. Such a volume rejects
+            //       the first read, so no entry is passed twice. The flag is cleared then, so the following
+            //       directories are read with the 64-bit IDs right away.
+            if (_Extended_ids) {
+                if (_For_each_directory_info<FILE_ID_EXTD_DIR_INFO>(_Dir, FileIdExtdDirectoryInfo, _Func)) {
+                    return true;
+                }
+
+                const unsigned long _Error = ::GetLastError();
+                if (_Error != ERROR_INVALID_PARAMETER && _Error != ERROR_NOT_SUPPORTED) {
+                    return false;
+                }
+
+                _Extended_ids = false;
+            }
+
+            return _For_each_directory_info<FILE_ID_BOTH_DIR_INFO>(_Dir, FileIdBothDirectoryInfo, _Func);
+        }
+
+        class _Entry_batch { // entries read ahead from a directory, the names share a single buffer
+        public:
+            _Entry_batch() noexcept : _Myrecords(), _Mynames(), _Mynext(0) {}
+
+            bool _Empty() const noexcept {
+                return _Mynext == _Myrecords.size();
+            }
+
+            void _Clear() noexcept {
+                _Myrecords.clear();
+                _Mynames.clear();
+                _Mynext = 0;
+            }
+
+            void _Append(const WIN32_FIND_DATAW& _Data) {
+                const size_t _Length = ::wcslen(_Data.cFileName);
+                _Myrecords.push_back(
+                    _Record{_Data.dwFileAttributes, _Data.dwReserved0, _Mynames.size(), _Length});
+                _Mynames.insert(_Mynames.end(), _Data.cFileName, _Data.cFileName + _Length);
+            }
+
+            bool _Append_remaining(void* const _Handle) {
+                WIN32_FIND_DATAW _Data;
+                while (_Advance_directory_iterator(_Handle, &_Data)) {
+                    _Append(_Data);
+                }
+
+                return _Assume_no_more_files();
+            }
+
+            void _Sort() {
+                // Note: The names are folded to upper case once, so the entries are ordered like
+                //       directory_listing::sort() orders them, with plain code unit comparisons.
+                //       Only the records are moved.
+                ::std::vector<wchar_t> _Folded(_Mynames.size());
+                for (size_t _Idx = _Mynext; _Idx < _Myrecords.size(); ++_Idx) {
+                    const _Record& _Rec = _Myrecords[_Idx];
+                    _Fold_path_chunk(
+                        _Mynames.data() + _Rec._Offset, _Rec._Length, _Folded.data() + _Rec._Offset);
+                }
+
+                const wchar_t* const _Names = _Folded.data();
+                ::std::sort(_Myrecords.begin() + static_cast<ptrdiff_t>(_Mynext), _Myrecords.end(),
+                    [_Names](const _Record& _Left, const _Record& _Right) noexcept {
+                        return _Compare_names(_Names + _Left._Offset, _Left._Length,
+                            _Names + _Right._Offset, _Right._Length) < 0;
+                    });
+            }
+
+            void _Load_next(WIN32_FIND_DATAW& _Data) noexcept {
+                const _Record& _Next   = _Myrecords[_Mynext++];
+                _Data                  = WIN32_FIND_DATAW{};
+                _Data.dwFileAttributes = _Next._Attributes;
+                _Data.dwReserved0      = _Next._Reparse_tag;
+                ::wmemcpy(_Data.cFileName, _Mynames.data() + _Next._Offset, _Next._Length);
+            }
+
+        private:
+            struct _Record {
+                unsigned long _Attributes;
+                unsigned long _Reparse_tag;
+                size_t _Offset; // the position of the name in the buffer
+                size_t _Length;
+            };
+
+            ::std::vector<_Record> _Myrecords;
+            ::std::vector<wchar_t> _Mynames; // the names without the null terminators
+            size_t _Mynext; // the position of the next record to load
+        };
+
+        class _Directory_queue { // directories waiting to be visited, the paths share a single buffer
+        public:
+            _Directory_queue() noexcept : _Myrecords(), _Mypaths(), _Myhead(0) {}
+
+            bool _Empty() const noexcept {
+                return _Myhead == _Myrecords.size();
+            }
+
+            void _Push(const path& _Dir, const size_t _Depth, const glob_pattern::state_type _State) {
+                const path::string_type& _Str = _Dir.native();
+                _Myrecords.push_back(_Record{_Mypaths.size(), _Str.size(), _Depth, _State});
+                _Mypaths.insert(_Mypaths.end(), _Str.data(), _Str.data() + _Str.size());
+            }
+
+            path _Pop(size_t& _Depth, glob_pattern::state_type& _State) {
+                const _Record& _Front = _Myrecords[_Myhead++];
+                path _Result(unicode_string{_Mypaths.data() + _Front._Offset, _Front._Length});
+                _Depth = _Front._Depth;
+                _State = _Front._State;
+                _Compact();
+                return _Result;
+            }
+
+        private:
+            struct _Record {
+                size_t _Offset; // the position of the path in the buffer
+                size_t _Length;
+                size_t _Depth;
+                glob_pattern::state_type _State;
+            };
+
+            void _Compact() noexcept {
+                // Note: The visited paths are dropped once they take at least half of the queue,
+                //       so the memory is proportional to the number of waiting directories.
+                if (_Empty()) {
+                    _Myrecords.clear();
+                    _Mypaths.clear();
+                    _Myhead = 0;
+                } else if (_Myhead >= 64 && _Myhead * 2 >= _Myrecords.size()) {
+                    const size_t _Shift = _Myrecords[_Myhead]._Offset;
+                    _Mypaths.erase(_Mypaths.begin(), _Mypaths.begin() + static_cast<ptrdiff_t>(_Shift));
+                    _Myrecords.erase(_Myrecords.begin(), _Myrecords.begin() + static_cast<ptrdiff_t>(_Myhead));
+                    for (_Record& _Rec : _Myrecords) {
+                        _Rec._Offset -= _Shift;
+                    }
+
+                    _Myhead = 0;
+                }
+            }
+
+            ::std::vector<_Record> _Myrecords;
+            ::std::vector<wchar_t> _Mypaths;
+            size_t _Myhead; // the position of the next directory to visit
+        };
+
         class _Dir_iter_base { // base class for all directory iterators
         public:
             WIN32_FIND_DATAW _Data;
             void* _Handle;
             directory_entry _Entry;
             path _Path;
-            
+            glob_pattern _Pattern;
+            bool _Filtered; // true if the entries are filtered with the pattern
+
             _Dir_iter_base() = delete;
 
             explicit _Dir_iter_base(const path& _Target)
-                : _Data(), _Handle(_Open(_Target)), _Entry(), _Path(_Target) {
-                if (_Valid()) {
-                    _Assign();
-                }
-            }
+                : _Data(), _Handle(_Open(_Target)), _Entry(), _Path(_Target), _Pattern(), _Filtered(false) {}
+
+            _Dir_iter_base(const path& _Target, const glob_pattern& _Pattern)
+                : _Data(), _Handle(_Open(_Target)), _Entry(), _Path(_Target),
+                _Pattern(_Pattern), _Filtered(true) {}
 
             ~_Dir_iter_base() noexcept {
                 if (_Valid()) {
@@ -103,23 +378,45 @@ namespace mjx {
 
         class _Dir_iter : public _Any_dir_iter, public _Dir_iter_base {
         public:
+            directory_name_entry _Name_entry;
+            bool _Names_only; // true if only _Name_entry is assigned
+
             _Dir_iter() = delete;
 
-            explicit _Dir_iter(const path& _Target) : _Dir_iter_base(_Target) {}
+            explicit _Dir_iter(const path& _Target, const bool _Names_only = false)
+                : _Dir_iter_base(_Target), _Name_entry(), _Names_only(_Names_only) {}
+
+            _Dir_iter(const path& _Target, const glob_pattern& _Pattern, const bool _Names_only = false)
+                : _Dir_iter_base(_Target, _Pattern), _Name_entry(), _Names_only(_Names_only) {}
 
             ~_Dir_iter() noexcept override {}
 
             _Dir_iter(const _Dir_iter&)     = default;
             _Dir_iter(_Dir_iter&&) noexcept = default;
 
-            bool _Skip_dots() {
-                while (_Is_dot_or_dot_dot(_Data.cFileName)) {
+            bool _Should_report() const {
+                // Note: The pattern is matched against the raw name, so no path is built for entries
+                //       that are filtered out.
+                if (_Is_dot_or_dot_dot(_Data.cFileName)) {
+                    return false;
+                }
+
+                return _Filtered
+                    ? _Pattern.accepts(_Pattern.advance(_Pattern.initial_state(), _Data.cFileName)) : true;
+            }
+
+            bool _Start() {
+                if (!_Valid()) { // failed to open the directory
+                    return false;
+                }
+
+                while (!_Should_report()) {
                     if (!_Advance_directory_iterator(_Handle, &_Data)) {
                         return false;
                     }
                 }
 
-                _Assign();
+                _Assign_current();
                 return true;
             }
 
@@ -128,12 +425,21 @@ namespace mjx {
                     if (!_Advance_directory_iterator(_Handle, &_Data)) {
                         return false;
                     }
-                } while (_Is_dot_or_dot_dot(_Data.cFileName));
+                } while (!_Should_report());
 
-                _Assign();
+                _Assign_current();
                 return true;
             }
 
+            void _Assign_current() {
+                if (_Names_only) { // the name stays in the find data, so nothing is copied
+                    _Name_entry.name       = unicode_string_view{_Data.cFileName, ::wcslen(_Data.cFileName)};
+                    _Name_entry.attributes = static_cast<file_attribute>(_Data.dwFileAttributes);
+                } else {
+                    _Assign();
+                }
+            }
+
             _Dir_iter* _Normal() noexcept override {
                 return this;
             }
@@ -153,16 +459,45 @@ namespace mjx {
 
         class _Recursive_dir_iter : public _Any_dir_iter, public _Dir_iter_base {
         public:
-            ::std::vector<void*> _Stack;
+            ::std::vector<void*> _Stack; // null if the parent directory was read into memory
+            ::std::vector<_Entry_batch> _Remainders; // cached entries of the parent directories
+            _Entry_batch _Remainder; // cached entries of the current directory
+            _Directory_queue _Queue; // the directories to visit, used only with breadth_first
+            ::std::vector<glob_pattern::state_type> _States; // pattern states of the parent directories
+            glob_pattern::state_type _State; // pattern state of the current directory
+            glob_pattern::state_type _Entry_state; // pattern state of the current entry
             directory_options _Options;
             bool _Recursion_pending;
+            _File_id_set _Visited; // the entered directories, used only with skip_visited_directories
+            _File_id_set _Linked; // the reported hard-linked files, used only with report_hard_links_once
+            size_t _Max_handles; // the maximum number of open handles, 0 if unlimited
+            size_t _Open_handles; // the number of open handles, always the innermost directories
+            size_t _Depth;
+            int _Max_depth; // the maximum depth of the entered directories, negative if unlimited
 
             _Recursive_dir_iter() = delete;
 
-            explicit _Recursive_dir_iter(const path& _Target, const directory_options _Options)
-                : _Dir_iter_base(_Target), _Stack(), _Options(_Options), _Recursion_pending(false) {}
-
-            ~_Recursive_dir_iter() noexcept override {}
+            explicit _Recursive_dir_iter(const path& _Target, const directory_options _Options,
+                const recursive_directory_limits& _Limits = {})
+                : _Dir_iter_base(_Target), _Stack(), _Remainders(), _Remainder(), _Queue(), _States(),
+                _State(0), _Entry_state(0), _Options(_Options), _Recursion_pending(false), _Visited(),
+                _Linked(), _Max_handles(_Limits.max_open_handles), _Open_handles(_Valid() ? 1 : 0), _Depth(0),
+                _Max_depth(_Limits.max_depth) {}
+
+            _Recursive_dir_iter(const path& _Target, const glob_pattern& _Pattern,
+                const directory_options _Options, const recursive_directory_limits& _Limits = {})
+                : _Dir_iter_base(_Target, _Pattern), _Stack(), _Remainders(), _Remainder(), _Queue(),
+                _States(), _State(_Pattern.initial_state()), _Entry_state(0), _Options(_Options),
+                _Recursion_pending(false), _Visited(), _Linked(), _Max_handles(_Limits.max_open_handles),
+                _Open_handles(_Valid() ? 1 : 0), _Depth(0), _Max_depth(_Limits.max_depth) {}
+
+            ~_Recursive_dir_iter() noexcept override {
+                for (void* _Parent : _Stack) { // the current handle is closed by _Dir_iter_base
+                    if (_Is_directory_iterator_handle_valid(_Parent)) {
+                        _Close_directory_iterator(_Parent);
+                    }
+                }
+            }
 
             _Recursive_dir_iter(const _Recursive_dir_iter&)     = default;
             _Recursive_dir_iter(_Recursive_dir_iter&&) noexcept = default;
@@ -177,88 +512,269 @@ namespace mjx {
                     return false;
                 }
 
+                if (_Max_depth >= 0 && _Depth >= static_cast<size_t>(_Max_depth)) { // too deep
+                    return false;
+                }
+
                 return (_Data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0
                     ? _Has_bits(_Options, directory_options::follow_directory_symlink) : true;
             }
 
-            bool _Skip_dots() {
-                while (_Is_dot_or_dot_dot(_Data.cFileName)) {
-                    if (!_Advance_directory_iterator(_Handle, &_Data)) {
-                        return _Assume_no_more_files() ? _Pop() : false;
-                    }
+            bool _Mark_visited(const path& _Dir) {
+                // Note: Returns false if the directory has already been entered, which happens when a link
+                //       points to an ancestor (a cycle) or to a directory reachable in another way.
+                //       A directory whose ID can't be retrieved is always entered.
+                _File_id _Id;
+                unsigned long _Links;
+                return _Get_file_id(_Dir.c_str(), _Id, _Links) ? _Visited._Insert(_Id) : true;
+            }
+
+            bool _Is_first_visit() {
+                return _Has_bits(_Options, directory_options::skip_visited_directories)
+                    ? _Mark_visited(_Path / _Data.cFileName) : true;
+            }
+
+            bool _Is_first_link() {
+                // Note: The number of links is known only after the file is opened, so each regular file
+                //       is opened once, but only the files with multiple links are stored in the set.
+                constexpr unsigned long _Not_file = FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT;
+                if (!_Has_bits(_Options, directory_options::report_hard_links_once)
+                    || (_Data.dwFileAttributes & _Not_file) != 0) {
+                    return true;
                 }
 
-                _Assign();
-                if (_Should_recurse()) {
-                    _Recursion_pending = true; // recurse on next iteration
+                _File_id _Id;
+                unsigned long _Links;
+                if (!_Get_file_id((_Path / _Data.cFileName).c_str(), _Id, _Links) || _Links <= 1) {
+                    return true;
+                }
+
+                return _Linked._Insert(_Id);
+            }
+
+            bool _Release_outermost_handle() {
+                // Note: The open handles always belong to the innermost directories, so the outermost one
+                //       is found by counting from the current directory. Its remaining entries are read
+                //       into memory, so the iteration continues from the same position once it's resumed.
+                const size_t _Level    = _Stack.size() + 1 - _Open_handles;
+                const bool _Is_parent  = _Level < _Stack.size();
+                void*& _Target         = _Is_parent ? _Stack[_Level] : _Handle;
+                _Entry_batch& _Entries = _Is_parent ? _Remainders[_Level] : _Remainder;
+                if (!_Entries._Append_remaining(_Target)) {
+                    return false;
                 }
 
+                _Close_directory_iterator(_Target);
+                --_Open_handles;
                 return true;
             }
 
-            bool _Advance() {
-                if (_Recursion_pending) {
-                    _Copied_filename _Filename(_Data.cFileName); // use separate buffer to avoid data loss
-                    void* const _New_handle = _Open(_Path / _Filename._Raw);
-                    if (_Is_directory_iterator_handle_valid(_New_handle)) { // success, recurse
-                        _Stack.push_back(_Handle);
-                        _Handle            = _New_handle;
-                        _Path             /= _Filename._Raw;
-                        _Recursion_pending = false;
-                        return _Skip_dots();
-                    } else { // failure, skip directory or report an error
-                        if (_Assume_access_denied()
-                            && _Has_bits(_Options, directory_options::skip_permission_denied)) {
-                            _Recursion_pending = false;
-                            return _Advance();
-                        } else {
-                            return false;
-                        }
-                    }
+            bool _Next_entry() {
+                if (_Handle != nullptr) {
+                    return _Advance_directory_iterator(_Handle, &_Data);
                 }
 
-                do {
-                    if (!_Advance_directory_iterator(_Handle, &_Data)) {
+                if (_Remainder._Empty()) { // behave like an exhausted handle
+                    ::SetLastError(ERROR_NO_MORE_FILES);
+                    return false;
+                }
+
+                _Remainder._Load_next(_Data);
+                return true;
+            }
+
+            void _Close_current() noexcept {
+                if (_Handle != nullptr) {
+                    _Close_directory_iterator(_Handle);
+                    --_Open_handles;
+                }
+
+                _Remainder._Clear();
+            }
+
+            bool _Sort_current() {
+                // Note: The whole directory is read at once and its handle is closed, so the sorted
+                //       iteration keeps no handles open. The first entry is already loaded.
+                _Remainder._Clear();
+                _Remainder._Append(_Data);
+                const bool _Succeeded = _Remainder._Append_remaining(_Handle);
+                _Close_directory_iterator(_Handle);
+                --_Open_handles;
+                if (!_Succeeded) {
+                    return false;
+                }
+
+                _Remainder._Sort();
+                _Remainder._Load_next(_Data);
+                return true;
+            }
+
+            void _Defer() { // queues the current entry, so that it's visited after the current level
+                _Queue._Push(_Path / _Data.cFileName, _Depth + 1, _Entry_state);
+            }
+
+            bool _Visit_next() {
+                _Close_current();
+                _Path   = _Queue._Pop(_Depth, _State);
+                _Handle = _Open(_Path);
+                if (!_Is_directory_iterator_handle_valid(_Handle)) { // the next call reports the end
+                    _Handle = nullptr;
+                    return false;
+                }
+
+                ++_Open_handles;
+                return _Has_bits(_Options, directory_options::sorted_by_name) ? _Sort_current() : true;
+            }
+
+            bool _Enter() {
+                _Copied_filename _Filename(_Data.cFileName); // use separate buffer to avoid data loss
+                if (_Max_handles != 0 && _Open_handles >= _Max_handles && !_Release_outermost_handle()) {
+                    return false;
+                }
+
+                void* const _New_handle = _Open(_Path / _Filename._Raw);
+                if (!_Is_directory_iterator_handle_valid(_New_handle)) {
+                    return false;
+                }
+
+                _Stack.push_back(_Handle);
+                _Remainders.push_back(::std::move(_Remainder));
+                _States.push_back(_State);
+                _Remainder._Clear();
+                _Handle = _New_handle;
+                _State  = _Entry_state;
+                _Path  /= _Filename._Raw;
+                ++_Open_handles;
+                ++_Depth;
+                return _Has_bits(_Options, directory_options::sorted_by_name) ? _Sort_current() : true;
+            }
+
+            void _Leave() {
+                _Close_current();
+                _Handle    = _Stack.back();
+                _Remainder = ::std::move(_Remainders.back());
+                _State     = _States.back();
+                _Stack.pop_back();
+                _Remainders.pop_back();
+                _States.pop_back();
+                _Remove_filename_and_slash(_Path);
+                --_Depth;
+            }
+
+            bool _Find_next(bool _Has_entry) {
+                // Note: Scans the entries until one that should be reported is found. Directories that
+                //       are not reported, but may still contain matching entries, are entered immediately.
+                //       Directories that cannot contain any match are skipped without being opened.
+                for (;;) {
+                    if (_Has_entry) { // the entry is already loaded, use it
+                        _Has_entry = false;
+                    } else if (!_Next_entry()) {
                         // Note: The _Advance_directory_iterator() function may encounter failure due to
                         //       various reasons, but we are specifically interested in two scenarios.
                         //       In the first case, if an error occurs, we should simply report the failure.
                         //       In the second case, when the failure reason is ERROR_NO_MORE_FILES,
                         //       we can deduce that we have reached the end of the current directory,
                         //       and therefore, we should navigate back to the parent directory if any exists.
+                        //       In breadth-first order, the stack is always empty and the next queued
+                        //       directory is visited instead.
                         if (!_Assume_no_more_files()) {
                             return false;
                         }
 
-                        if (_Stack.empty()) {
+                        if (!_Stack.empty()) {
+                            _Leave();
+                        } else if (_Queue._Empty()) {
+                            return false;
+                        } else if (_Visit_next()) { // success, the first entry is already loaded
+                            _Has_entry = true;
+                        } else if (!_Assume_access_denied()
+                            || !_Has_bits(_Options, directory_options::skip_permission_denied)) {
                             return false;
                         }
 
-                        _Handle = _Stack.back();
-                        _Stack.pop_back();
-                        _Remove_filename_and_slash(_Path);
-                        return _Advance();
+                        continue;
+                    }
+
+                    if (_Is_dot_or_dot_dot(_Data.cFileName)) {
+                        continue;
+                    }
+
+                    bool _Report  = true;
+                    bool _Descend = _Should_recurse();
+                    if (_Filtered) {
+                        _Entry_state = _Pattern.advance(_State, _Data.cFileName);
+                        _Report      = _Pattern.accepts(_Entry_state);
+                        _Descend     = _Descend && _Pattern.can_continue(_Entry_state);
+                    }
+
+                    _Descend = _Descend && _Is_first_visit();
+                    _Report  = _Report && _Is_first_link();
+
+                    if (_Report) {
+                        _Assign();
+                        _Recursion_pending = _Descend; // recurse on next iteration
+                        return true;
+                    }
+
+                    if (_Descend) { // not reported, but may contain matching entries
+                        if (_Has_bits(_Options, directory_options::breadth_first)) {
+                            _Defer();
+                        } else if (_Enter()) { // success, the first entry is already loaded
+                            _Has_entry = true;
+                        } else if (!_Assume_access_denied()
+                            || !_Has_bits(_Options, directory_options::skip_permission_denied)) {
+                            return false;
+                        }
                     }
-                } while (_Is_dot_or_dot_dot(_Data.cFileName));
+                }
+            }
 
-                if (_Should_recurse()) {
-                    _Recursion_pending = true; // recurse on next iterator
+            bool _Start() {
+                if (!_Valid()) { // failed to open the directory
+                    return false;
                 }
 
-                _Assign();
-                return true;
+                if (_Has_bits(_Options, directory_options::skip_visited_directories)) {
+                    _Mark_visited(_Path); // a link to the root is a cycle as well
+                }
+
+                if (_Has_bits(_Options, directory_options::sorted_by_name) && !_Sort_current()) {
+                    return false;
+                }
+
+                return _Find_next(true);
+            }
+
+            bool _Advance() {
+                if (_Recursion_pending) {
+                    _Recursion_pending = false;
+                    if (_Has_bits(_Options, directory_options::breadth_first)) {
+                        _Defer();
+                    } else if (_Enter()) { // success, recurse
+                        return _Find_next(true);
+                    } else if (!_Assume_access_denied()
+                        || !_Has_bits(_Options, directory_options::skip_permission_denied)) {
+                        return false;
+                    }
+                }
+
+                return _Find_next(false);
             }
 
             bool _Pop() {
+                if (_Has_bits(_Options, directory_options::breadth_first)) { // skip the rest of the level
+                    _Close_current();
+                    _Recursion_pending = false;
+                    return _Find_next(false);
+                }
+
                 if (_Stack.empty()) { // no more levels, do nothing
-                    return false;
+                    return true;
                 }
 
-                _Close_directory_iterator(_Handle);
-                _Handle = _Stack.back();
-                _Stack.pop_back();
-                _Remove_filename_and_slash(_Path);
+                _Leave();
                 _Recursion_pending = false; // reset recursion flag
-                return _Advance(); // skip current entry (always the directory we were in)
+                return _Find_next(false); // skip current entry (always the directory we were in)
             }
 
             _Dir_iter* _Normal() noexcept override {
@@ -0,0 +1,59 @@
+// directory_listing.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_DIRECTORY_LISTING_HPP_
+#define _MJFS_IMPL_DIRECTORY_LISTING_HPP_
+#include <algorithm>
+#include <cstddef>
+#include <cwchar>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline int _Compare_names(const wchar_t* const _Left, const size_t _Left_size,
+            const wchar_t* const _Right, const size_t _Right_size) noexcept {
+            // compares the names by code units, a name that is a prefix of another is less
+            const int _Result = ::wmemcmp(_Left, _Right, (::std::min)(_Left_size, _Right_size));
+            if (_Result != 0) {
+                return _Result;
+            }
+
+            return _Left_size < _Right_size ? -1 : (_Left_size > _Right_size ? 1 : 0);
+        }
+
+        template <class _Ty>
+        inline void _Reorder_column(::std::vector<_Ty>& _Column, const ::std::vector<size_t>& _Order) {
+            ::std::vector<_Ty> _Result;
+            _Result.reserve(_Column.size());
+            for (const size_t _Idx : _Order) {
+                _Result.push_back(_Column[_Idx]);
+            }
+
+            _Column.swap(_Result);
+        }
+
+        inline void _Reorder_names(::std::vector<wchar_t>& _Names,
+            ::std::vector<size_t>& _Offsets, const ::std::vector<size_t>& _Order) {
+            // Note: The offsets array has one more element than there are names, the last one
+            //       is the size of the buffer, so the length of each name is known.
+            ::std::vector<wchar_t> _New_names;
+            ::std::vector<size_t> _New_offsets;
+            _New_names.reserve(_Names.size());
+            _New_offsets.reserve(_Offsets.size());
+            _New_offsets.push_back(0);
+            for (const size_t _Idx : _Order) {
+                _New_names.insert(_New_names.end(), _Names.begin() + static_cast<ptrdiff_t>(_Offsets[_Idx]),
+                    _Names.begin() + static_cast<ptrdiff_t>(_Offsets[_Idx + 1]));
+                _New_offsets.push_back(_New_names.size());
+            }
+
+            _Names.swap(_New_names);
+            _Offsets.swap(_New_offsets);
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_DIRECTORY_LISTING_HPP_
@@ -0,0 +1,414 @@
+// directory_watcher.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_DIRECTORY_WATCHER_HPP_
+#define _MJFS_IMPL_DIRECTORY_WATCHER_HPP_
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/directory_watcher.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Change_watcher { // watches directories with a single thread and a completion port
+        public:
+            _Change_watcher(const directory_watcher_options& _Options, watch_callback&& _Callback)
+                : _Mymtx(), _Myport(::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1)),
+                _Mythread(), _Myoptions(_Options), _Mycallback(::std::move(_Callback)), _Mywatches(),
+                _Myretired(), _Mypending(), _Mypending_ids(), _Mydeadline(0), _Myqueue_mtx(),
+                _Myqueue_cv(), _Myqueue() {
+                // the buffer must hold at least a few notifications, otherwise each change overflows it
+                _Myoptions.buffer_size = (::std::max)(_Myoptions.buffer_size, _Min_buffer_size);
+                if (_Myport != nullptr) {
+                    _Mythread = ::std::thread(&_Change_watcher::_Run, this);
+                }
+            }
+
+            ~_Change_watcher() noexcept {
+                if (_Myport == nullptr) {
+                    return;
+                }
+
+                // a packet without OVERLAPPED stops the thread
+                ::PostQueuedCompletionStatus(_Myport, 0, 0, nullptr);
+                _Mythread.join();
+                for (auto& _Pair : _Mywatches) {
+                    _Watch_entry& _Entry = *_Pair.second;
+                    if (::CancelIoEx(_Entry._Handle, &_Entry._Overlapped) != 0) { // wait for the cancellation
+                        unsigned long _Bytes;
+                        ::GetOverlappedResult(_Entry._Handle, &_Entry._Overlapped, &_Bytes, TRUE);
+                    }
+                }
+
+                for (const unique_smart_ptr<_Watch_entry>& _Entry : _Myretired) { // already cancelled
+                    unsigned long _Bytes;
+                    ::GetOverlappedResult(_Entry->_Handle, &_Entry->_Overlapped, &_Bytes, TRUE);
+                }
+
+                _Mywatches.clear();
+                _Myretired.clear();
+                ::CloseHandle(_Myport);
+            }
+
+            _Change_watcher(const _Change_watcher&)            = delete;
+            _Change_watcher& operator=(const _Change_watcher&) = delete;
+
+            bool _Watch(const path& _Dir) {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                if (_Myport == nullptr) {
+                    return false;
+                }
+
+                if (_Mywatches.find(_Dir.native()) != _Mywatches.end()) {
+                    return true;
+                }
+
+                void* const _Handle = ::CreateFileW(_Dir.c_str(), FILE_LIST_DIRECTORY,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+                if (_Handle == INVALID_HANDLE_VALUE) {
+                    return false;
+                }
+
+                unique_smart_ptr<_Watch_entry> _Entry(::mjx::create_object<_Watch_entry>(
+                    _Dir, _Handle, _Myoptions.buffer_size / sizeof(unsigned long)));
+                if (::CreateIoCompletionPort(_Handle, _Myport, reinterpret_cast<ULONG_PTR>(_Entry.get()), 0)
+                    == nullptr || !_Read_changes(*_Entry)) {
+                    return false;
+                }
+
+                _Mywatches.emplace(unicode_string{_Dir.native()}, ::std::move(_Entry));
+                return true;
+            }
+
+            bool _Unwatch(const path& _Dir) {
+                // Note: The entry is destroyed by the thread once the cancelled read completes, since
+                //       the completion refers to the entry.
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                const auto _Iter = _Mywatches.find(_Dir.native());
+                if (_Iter == _Mywatches.end()) {
+                    return false;
+                }
+
+                _Watch_entry& _Entry = *_Iter->second;
+                _Entry._Cancelled    = true;
+                ::CancelIoEx(_Entry._Handle, &_Entry._Overlapped);
+                _Myretired.push_back(::std::move(_Iter->second));
+                _Mywatches.erase(_Iter);
+                return true;
+            }
+
+            bool _Is_watched(const path& _Dir) const {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                return _Mywatches.find(_Dir.native()) != _Mywatches.end();
+            }
+
+            bool _Poll(::std::vector<watch_event>& _Events) {
+                ::std::lock_guard<::std::mutex> _Guard(_Myqueue_mtx);
+                return _Take_queued(_Events);
+            }
+
+            bool _Wait(::std::vector<watch_event>& _Events, const uint64_t _Timeout) {
+                // Note: The timeout is clamped, since a longer one would overflow the signed milliseconds,
+                //       or the deadline computed from them, and return immediately.
+                ::std::unique_lock<::std::mutex> _Guard(_Myqueue_mtx);
+                _Myqueue_cv.wait_for(_Guard,
+                    ::std::chrono::milliseconds((::std::min)(_Timeout, _Max_wait_timeout)),
+                    [this] { return !_Myqueue.empty(); });
+                return _Take_queued(_Events);
+            }
+
+        private:
+            static constexpr size_t _Min_buffer_size = 1024;
+            static constexpr uint64_t _Max_wait_timeout = uint64_t{1} << 40; // about 35 years
+
+            struct _Watch_entry {
+                path _Dir;
+                void* _Handle;
+                OVERLAPPED _Overlapped;
+                ::std::vector<unsigned long> _Buffer; // DWORD-aligned, as ReadDirectoryChangesW() requires
+                path _Rename_from; // the old name of a rename whose new name was not reported yet
+                bool _Cancelled; // set by _Unwatch(), the next completion destroys the entry
+
+                _Watch_entry(const path& _Dir_path, void* const _Dir_handle, const size_t _Buffer_words)
+                    : _Dir(_Dir_path), _Handle(_Dir_handle), _Overlapped{}, _Buffer(_Buffer_words),
+                    _Rename_from(), _Cancelled(false) {}
+
+                ~_Watch_entry() noexcept {
+                    ::CloseHandle(_Handle);
+                }
+
+                _Watch_entry(const _Watch_entry&)            = delete;
+                _Watch_entry& operator=(const _Watch_entry&) = delete;
+            };
+
+            bool _Read_changes(_Watch_entry& _Entry) noexcept {
+                // Note: The system buffers the changes between the calls, so nothing is lost while
+                //       the previous notifications are processed, unless the buffer overflows.
+                return ::ReadDirectoryChangesW(_Entry._Handle, _Entry._Buffer.data(),
+                    static_cast<unsigned long>(_Entry._Buffer.size() * sizeof(unsigned long)),
+                    _Myoptions.recursive ? TRUE : FALSE,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+                        | FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE
+                        | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
+                    nullptr, &_Entry._Overlapped, nullptr) != 0;
+            }
+
+            bool _Take_queued(::std::vector<watch_event>& _Events) noexcept {
+                if (_Myqueue.empty()) {
+                    return false;
+                }
+
+                _Events.clear();
+                _Events.swap(_Myqueue);
+                return true;
+            }
+
+            void _Push_event(const watch_event_type _Type, path&& _Target, path&& _Old_target) {
+                // Note: A modification of an entry that was already added or modified in the current batch
+                //       is dropped, since the system reports a separate modification for each write.
+                //       The event is stored before it's indexed, so a failed allocation can't leave an index
+                //       that refers to no event.
+                if (_Mypending.empty()) { // the first event of the batch starts the window
+                    _Mydeadline = ::GetTickCount64() + _Myoptions.coalesce_window;
+                }
+
+                auto _Iter = _Mypending_ids.find(_Target.native());
+                if (_Iter != _Mypending_ids.end() && _Type == watch_event_type::modified) {
+                    const watch_event_type _Last = _Mypending[_Iter->second].type;
+                    if (_Last == watch_event_type::added || _Last == watch_event_type::modified) {
+                        return;
+                    }
+                }
+
+                const size_t _Idx = _Mypending.size();
+                _Mypending.push_back(watch_event{_Type, ::std::move(_Target), ::std::move(_Old_target)});
+                const watch_event& _Event = _Mypending.back();
+                if (_Type == watch_event_type::renamed) { // the old path refers to no entry anymore
+                    // the old path may differ from the new one only in case, so the index is found again
+                    _Mypending_ids.erase(_Event.old_target.native());
+                    _Iter = _Mypending_ids.find(_Event.target.native());
+                }
+
+                if (_Iter != _Mypending_ids.end()) {
+                    _Iter->second = _Idx;
+                } else {
+                    _Mypending_ids.emplace(unicode_string{_Event.target.native()}, _Idx);
+                }
+            }
+
+            void _Report(const watch_event_type _Type, const path& _Dir) noexcept {
+                // reports an overflow or a stop of the directory, nothing can be reported if that fails too
+                try {
+                    _Push_event(_Type, path{_Dir}, path{});
+                } catch (...) {
+                }
+            }
+
+            void _Parse_changes(_Watch_entry& _Entry, const unsigned long _Bytes) {
+                if (_Bytes == 0) { // the buffer overflowed, the changes are unknown
+                    _Push_event(watch_event_type::overflow, path{_Entry._Dir}, path{});
+                    return;
+                }
+
+                const unsigned char* _Ptr = reinterpret_cast<const unsigned char*>(_Entry._Buffer.data());
+                for (;;) {
+                    const FILE_NOTIFY_INFORMATION* const _Info =
+                        reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(_Ptr);
+                    const unicode_string_view _Name(_Info->FileName, _Info->FileNameLength / sizeof(wchar_t));
+                    path _Target = _Entry._Dir / _Name;
+                    switch (_Info->Action) {
+                    case FILE_ACTION_ADDED:
+                        _Push_event(watch_event_type::added, ::std::move(_Target), path{});
+                        break;
+                    case FILE_ACTION_REMOVED:
+                        _Push_event(watch_event_type::removed, ::std::move(_Target), path{});
+                        break;
+                    case FILE_ACTION_MODIFIED:
+                        _Push_event(watch_event_type::modified, ::std::move(_Target), path{});
+                        break;
+                    case FILE_ACTION_RENAMED_OLD_NAME:
+                        _Entry._Rename_from = ::std::move(_Target);
+                        break;
+                    case FILE_ACTION_RENAMED_NEW_NAME:
+                        if (_Entry._Rename_from.empty()) { // the old name is outside of the watched directory
+                            _Push_event(watch_event_type::added, ::std::move(_Target), path{});
+                        } else {
+                            _Push_event(watch_event_type::renamed,
+                                ::std::move(_Target), ::std::move(_Entry._Rename_from));
+                            _Entry._Rename_from = path{};
+                        }
+
+                        break;
+                    default:
+                        break;
+                    }
+
+                    if (_Info->NextEntryOffset == 0) { // the last notification in the buffer
+                        break;
+                    }
+
+                    _Ptr += _Info->NextEntryOffset;
+                }
+            }
+
+            void _Retire(_Watch_entry* const _Entry) noexcept {
+                for (auto _Iter = _Myretired.begin(); _Iter != _Myretired.end(); ++_Iter) {
+                    if (_Iter->get() == _Entry) {
+                        _Myretired.erase(_Iter);
+                        break;
+                    }
+                }
+            }
+
+            void _Complete(
+                _Watch_entry* const _Entry, const bool _Succeeded, const unsigned long _Bytes) noexcept {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                if (_Entry->_Cancelled) { // the entry was unwatched, this is its last completion
+                    _Retire(_Entry);
+                    return;
+                }
+
+                if (_Succeeded) {
+                    try {
+                        _Parse_changes(*_Entry, _Bytes);
+                    } catch (...) { // e.g. out of memory, the remaining notifications are lost
+                        _Entry->_Rename_from = path{};
+                        _Report(watch_event_type::overflow, _Entry->_Dir);
+                    }
+                }
+
+                if (!_Succeeded || !_Read_changes(*_Entry)) { // e.g. the directory was removed
+                    _Report(watch_event_type::stopped, _Entry->_Dir);
+                    _Mywatches.erase(_Entry->_Dir.native());
+                }
+            }
+
+            void _Deliver(::std::vector<watch_event>& _Events) {
+                if (_Mycallback) {
+                    _Mycallback(_Events);
+                    _Events.clear();
+                } else {
+                    // Note: The batch is moved as a whole, so the queue is locked once per batch
+                    //       instead of once per event.
+                    ::std::lock_guard<::std::mutex> _Guard(_Myqueue_mtx);
+                    if (_Myqueue.empty()) {
+                        _Myqueue.swap(_Events);
+                    } else {
+                        _Myqueue.insert(_Myqueue.end(), ::std::make_move_iterator(_Events.begin()),
+                            ::std::make_move_iterator(_Events.end()));
+                        _Events.clear();
+                    }
+
+                    _Myqueue_cv.notify_all();
+                }
+            }
+
+            void _Report_lost_batch() noexcept {
+                // Note: A batch that failed to be delivered may have been delivered only in part, so it's
+                //       replaced with an overflow of each watched directory. Nothing is reported if that
+                //       fails as well, otherwise a callback that always throws would never stop failing.
+                try {
+                    ::std::vector<watch_event> _Events;
+                    {
+                        ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                        _Events.reserve(_Mywatches.size());
+                        for (const auto& _Pair : _Mywatches) {
+                            _Events.push_back(
+                                watch_event{watch_event_type::overflow, _Pair.second->_Dir, path{}});
+                        }
+                    }
+
+                    if (!_Events.empty()) {
+                        _Deliver(_Events);
+                    }
+                } catch (...) {
+                }
+            }
+
+            void _Flush() noexcept {
+                if (_Mypending.empty()) {
+                    return;
+                }
+
+                try {
+                    _Deliver(_Mypending);
+                } catch (...) { // e.g. the callback threw or the queue couldn't grow
+                    _Report_lost_batch();
+                }
+
+                _Mypending.clear();
+                _Mypending_ids.clear();
+            }
+
+            void _Run() noexcept {
+                for (;;) {
+                    // Note: Without pending events, the thread waits indefinitely, so it doesn't use
+                    //       any CPU time until something changes.
+                    unsigned long _Timeout = INFINITE;
+                    if (!_Mypending.empty()) {
+                        const uint64_t _Now = ::GetTickCount64();
+                        if (_Now >= _Mydeadline) {
+                            _Flush();
+                            continue;
+                        }
+
+                        _Timeout = static_cast<unsigned long>(_Mydeadline - _Now);
+                    }
+
+                    unsigned long _Bytes;
+                    ULONG_PTR _Key;
+                    OVERLAPPED* _Overlapped;
+                    const BOOL _Succeeded =
+                        ::GetQueuedCompletionStatus(_Myport, &_Bytes, &_Key, &_Overlapped, _Timeout);
+                    if (_Overlapped == nullptr) {
+                        if (_Succeeded == 0 && ::GetLastError() == WAIT_TIMEOUT) { // the window has elapsed
+                            continue;
+                        }
+
+                        break; // a stop request or the port is no longer usable
+                    }
+
+                    _Complete(reinterpret_cast<_Watch_entry*>(_Key), _Succeeded != 0, _Bytes);
+                }
+
+                _Flush(); // deliver the events that were collected before the stop request
+            }
+
+            mutable ::std::mutex _Mymtx; // guards the watches
+            void* _Myport;
+            ::std::thread _Mythread;
+            directory_watcher_options _Myoptions;
+            watch_callback _Mycallback;
+            ::std::unordered_map<unicode_string, unique_smart_ptr<_Watch_entry>,
+                _Insensitive_string_hash, _Insensitive_string_equal> _Mywatches;
+            ::std::vector<unique_smart_ptr<_Watch_entry>> _Myretired; // unwatched, their reads are cancelled
+            ::std::vector<watch_event> _Mypending; // the current batch, used only by the thread
+            ::std::unordered_map<unicode_string, size_t, _Insensitive_string_hash,
+                _Insensitive_string_equal> _Mypending_ids; // maps the paths to their last pending event
+            uint64_t _Mydeadline; // the tick count at which the current batch is delivered
+            ::std::mutex _Myqueue_mtx;
+            ::std::condition_variable _Myqueue_cv;
+            ::std::vector<watch_event> _Myqueue; // the delivered events, used without a callback
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_DIRECTORY_WATCHER_HPP_
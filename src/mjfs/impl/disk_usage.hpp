@@ -0,0 +1,204 @@
+// disk_usage.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_DISK_USAGE_HPP_
+#define _MJFS_IMPL_DISK_USAGE_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/bitmask.hpp>
+#include <mjfs/directory.hpp>
+#include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/parallel.hpp>
+#include <mjfs/impl/remove_all.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/impl/work_queue.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline void _Add_disk_usage(disk_usage_info& _Left, const disk_usage_info& _Right) noexcept {
+            _Left.bytes           += _Right.bytes;
+            _Left.allocated_bytes += _Right.allocated_bytes;
+            _Left.files           += _Right.files;
+            _Left.directories     += _Right.directories;
+        }
+
+        class _Usage_counter { // sums the sizes of a directory tree, the subtrees are read by multiple threads
+        public:
+            explicit _Usage_counter(const disk_usage_options _Options, const bool _Subtotals) noexcept
+                : _Myunique_links(_Has_bits(_Options, disk_usage_options::count_hard_links_once)),
+                _Mysubtotals(_Subtotals), _Myqueue(), _Mymtx(), _Mynames(), _Mytotal(), _Mychildren(),
+                _Myfailed(false), _Myvolume(0), _Myextended_ids(true), _Myids() {}
+
+            _Usage_counter(const _Usage_counter&)            = delete;
+            _Usage_counter& operator=(const _Usage_counter&) = delete;
+
+            bool _Count(
+                const path& _Root, disk_usage_info& _Usage, ::std::vector<disk_usage_subtotal>* const _Out) {
+                // Note: The root is read by the calling thread before any thread is started, its entries
+                //       become the subtotals. Each thread sums the sizes locally, the sums are merged once
+                //       the thread is done, so the threads share only the queue and the set of file IDs.
+                if (_Myunique_links) { // the links are not followed, so all files are on the root's volume
+                    _File_id _Id;
+                    unsigned long _Links;
+                    if (_Get_file_id(_Root.c_str(), _Id, _Links)) {
+                        _Myvolume = _Id._Volume;
+                    }
+                }
+
+                _Local_usage _Local;
+                _Myqueue._Begin();
+                _Process(_Usage_node{path{_Root}, _No_child}, _Local);
+                if (!_Myqueue._Finish_one()) {
+                    const size_t _Workers = _Get_worker_count(_Max_worker_count);
+                    _Thread_group _Group;
+                    if (_Workers > 1) {
+                        _Group._Start(_Workers - 1, [this] {
+                            _Local_usage _Thread_usage;
+                            _Work(_Thread_usage);
+                            _Merge(_Thread_usage);
+                        });
+                    }
+
+                    _Group._Run([this, &_Local] { _Work(_Local); });
+                    _Group._Join();
+                }
+
+                _Merge(_Local);
+                _Usage = _Mytotal;
+                if (_Out != nullptr) {
+                    _Out->clear();
+                    _Out->reserve(_Mynames.size());
+                    for (size_t _Idx = 0; _Idx < _Mynames.size(); ++_Idx) {
+                        _Out->push_back(disk_usage_subtotal{::std::move(_Mynames[_Idx]), _Mychildren[_Idx]});
+                    }
+                }
+
+                return !_Myfailed;
+            }
+
+        private:
+            static constexpr size_t _No_child = static_cast<size_t>(-1);
+
+            struct _Usage_node {
+                path _Dir;
+                size_t _Child; // the index of the root's entry that contains the directory
+            };
+
+            struct _Local_usage {
+                disk_usage_info _Total;
+                ::std::vector<disk_usage_info> _Children;
+            };
+
+            void _Work(_Local_usage& _Local) {
+                _Myqueue._Work([this, &_Local](const _Usage_node& _Node) { _Process(_Node, _Local); });
+            }
+
+            template <class _Info>
+            _File_id _Get_entry_id(const _Info& _Entry) const noexcept {
+                if constexpr (::std::is_same_v<_Info, FILE_FULL_DIR_INFO>) {
+                    return _File_id{}; // never called, the IDs are read only with count_hard_links_once
+                } else {
+                    return _Make_file_id(_Myvolume, _Entry);
+                }
+            }
+
+            template <class _Fn>
+            bool _Read_directory(const path& _Dir, const _Fn& _Func) {
+                // Note: Without count_hard_links_once, the IDs are not read at all.
+                if (!_Myunique_links) {
+                    return _For_each_directory_info<FILE_FULL_DIR_INFO>(
+                        _Dir.c_str(), FileFullDirectoryInfo, _Func);
+                }
+
+                bool _Extended_ids = _Myextended_ids.load(::std::memory_order_relaxed);
+                const bool _Result = _For_each_directory_id_info(_Dir.c_str(), _Extended_ids, _Func);
+                if (!_Extended_ids) {
+                    _Myextended_ids.store(false, ::std::memory_order_relaxed);
+                }
+
+                return _Result;
+            }
+
+            void _Process(const _Usage_node& _Node, _Local_usage& _Local) {
+                // Note: The sizes are taken from the enumeration, so no file is opened. The links are
+                //       counted, but not followed.
+                ::std::vector<_Usage_node> _Subdirs;
+                const auto _Func = [this, &_Node, &_Local, &_Subdirs](
+                    const unicode_string_view _Name, const auto& _Info) {
+                    const size_t _Child = _Node._Child != _No_child ? _Node._Child : _New_child(_Name);
+                    disk_usage_info _Entry;
+                    if ((_Info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+                        _Entry.directories = 1;
+                        if (_Is_directory_not_link(_Info.FileAttributes)) {
+                            _Subdirs.push_back(_Usage_node{_Node._Dir / _Name, _Child});
+                        }
+                    } else if (!_Myunique_links || _Myids._Insert(_Get_entry_id(_Info))) {
+                        _Entry.bytes           = static_cast<uint64_t>(_Info.EndOfFile.QuadPart);
+                        _Entry.allocated_bytes = static_cast<uint64_t>(_Info.AllocationSize.QuadPart);
+                        _Entry.files           = 1;
+                    }
+
+                    _Add_disk_usage(_Local._Total, _Entry);
+                    if (_Mysubtotals) {
+                        if (_Local._Children.size() <= _Child) {
+                            _Local._Children.resize(_Child + 1);
+                        }
+
+                        _Add_disk_usage(_Local._Children[_Child], _Entry);
+                    }
+                };
+                if (!_Read_directory(_Node._Dir, _Func)) {
+                    _Myfailed.store(true, ::std::memory_order_relaxed);
+                }
+
+                _Myqueue._Push(_Subdirs);
+            }
+
+            size_t _New_child(const unicode_string_view _Name) {
+                // called only for the root's entries, before any thread is started
+                if (!_Mysubtotals) {
+                    return 0;
+                }
+
+                _Mynames.push_back(path{_Name});
+                return _Mynames.size() - 1;
+            }
+
+            void _Merge(const _Local_usage& _Local) {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                _Add_disk_usage(_Mytotal, _Local._Total);
+                if (_Mysubtotals) {
+                    _Mychildren.resize(_Mynames.size());
+                    for (size_t _Idx = 0; _Idx < _Local._Children.size(); ++_Idx) {
+                        _Add_disk_usage(_Mychildren[_Idx], _Local._Children[_Idx]);
+                    }
+                }
+            }
+
+            bool _Myunique_links; // true with count_hard_links_once
+            bool _Mysubtotals;
+            _Work_queue<_Usage_node> _Myqueue;
+            ::std::mutex _Mymtx; // guards the merged sums
+            ::std::vector<path> _Mynames; // the names of the root's entries, used only with subtotals
+            disk_usage_info _Mytotal;
+            ::std::vector<disk_usage_info> _Mychildren;
+            ::std::atomic<bool> _Myfailed;
+            uint64_t _Myvolume; // the serial number of the root's volume, used only with count_hard_links_once
+            ::std::atomic<bool> _Myextended_ids; // false if the volume doesn't support the 128-bit IDs
+            _Shared_file_id_set _Myids; // the counted files, used only with count_hard_links_once
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_DISK_USAGE_HPP_
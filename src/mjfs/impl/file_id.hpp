@@ -0,0 +1,197 @@
+// file_id.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_FILE_ID_HPP_
+#define _MJFS_IMPL_FILE_ID_HPP_
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mjfs/impl/file.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/status.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mutex>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        struct _File_id { // identifies a file across all its names, including hard links and junctions
+            uint64_t _Volume = 0; // the volume serial number
+            uint64_t _Low    = 0; // the lower half of the 128-bit file ID
+            uint64_t _High   = 0; // the upper half of the 128-bit file ID
+
+            bool _Is_zero() const noexcept {
+                return _Volume == 0 && _Low == 0 && _High == 0;
+            }
+
+            bool operator==(const _File_id&) const noexcept                   = default;
+            ::std::strong_ordering operator<=>(const _File_id&) const noexcept = default;
+        };
+
+        inline uint64_t _Hash_file_id(const _File_id& _Id) noexcept {
+            // Note: File IDs are often sequential, so they are hashed to spread them across the slots.
+            _Path_hasher _Hasher;
+            return _Hasher._Finish(&_Id, sizeof(_File_id));
+        }
+
+        inline _File_id _Make_file_id(const uint64_t _Volume, const FILE_ID_128& _Id) noexcept {
+            _File_id _Result;
+            _Result._Volume = _Volume;
+            ::memcpy(&_Result._Low, _Id.Identifier, sizeof(uint64_t));
+            ::memcpy(&_Result._High, _Id.Identifier + sizeof(uint64_t), sizeof(uint64_t));
+            return _Result;
+        }
+
+        inline _File_id _Make_file_id(const uint64_t _Volume, const FILE_ID_EXTD_DIR_INFO& _Info) noexcept {
+            return _Make_file_id(_Volume, _Info.FileId);
+        }
+
+        inline _File_id _Make_file_id(const uint64_t _Volume, const FILE_ID_BOTH_DIR_INFO& _Info) noexcept {
+            // the 64-bit ID is the lower half of the 128-bit one, so both kinds of IDs can be compared
+            _File_id _Result;
+            _Result._Volume = _Volume;
+            _Result._Low    = static_cast<uint64_t>(_Info.FileId.QuadPart);
+            return _Result;
+        }
+
+        inline _File_id _Get_file_id_by_handle(
+            const HANDLE _Handle, const BY_HANDLE_FILE_INFORMATION& _Info) noexcept {
+            // Note: The 128-bit ID is required on ReFS, the 64-bit file index is used only if FileIdInfo
+            //       is not supported.
+            FILE_ID_INFO _Id_info;
+            if (::GetFileInformationByHandleEx(_Handle, FileIdInfo, &_Id_info, sizeof(_Id_info)) != 0) {
+                return _Make_file_id(_Id_info.VolumeSerialNumber, _Id_info.FileId);
+            }
+
+            _File_id _Result;
+            _Result._Volume = _Info.dwVolumeSerialNumber;
+            _Result._Low    = _Make_uint64(_Info.nFileIndexHigh, _Info.nFileIndexLow);
+            return _Result;
+        }
+
+        inline bool _Get_file_id(const wchar_t* const _Target, _File_id& _Id, unsigned long& _Links) noexcept {
+            // Note: The system resolves the reparse point, since FILE_FLAG_OPEN_REPARSE_POINT is not
+            //       specified, so a link to a directory has the same ID as the directory.
+            _Close_handle_guard _Guard = {::CreateFileW(_Target, FILE_READ_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+            BY_HANDLE_FILE_INFORMATION _Info;
+            if (!_Guard._Holds_valid_handle() || ::GetFileInformationByHandle(_Guard._Handle, &_Info) == 0) {
+                return false;
+            }
+
+            _Id    = _Get_file_id_by_handle(_Guard._Handle, _Info);
+            _Links = _Info.nNumberOfLinks;
+            return true;
+        }
+
+        class _File_id_set { // open-addressing set of file IDs, the IDs are never removed
+        public:
+            _File_id_set() noexcept : _Myslots(), _Mysize(0), _Myhas_zero(false) {}
+
+            bool _Contains(const _File_id& _Id) const noexcept {
+                if (_Id._Is_zero()) {
+                    return _Myhas_zero;
+                }
+
+                if (_Myslots.empty()) {
+                    return false;
+                }
+
+                const size_t _Mask = _Myslots.size() - 1;
+                size_t _Idx        = _Get_home_slot(_Id);
+                for (; !_Myslots[_Idx]._Is_zero(); _Idx = (_Idx + 1) & _Mask) {
+                    if (_Myslots[_Idx] == _Id) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            bool _Insert(const _File_id& _Id) { // returns false if the ID is already in the set
+                if (_Id._Is_zero()) { // the zero ID marks an empty slot, so it's stored separately
+                    const bool _Inserted = !_Myhas_zero;
+                    _Myhas_zero          = true;
+                    return _Inserted;
+                }
+
+                if ((_Mysize + 1) * 4 > _Myslots.size() * 3) { // keep the load factor below 3/4
+                    _Grow();
+                }
+
+                const size_t _Mask = _Myslots.size() - 1;
+                size_t _Idx        = _Get_home_slot(_Id);
+                for (; !_Myslots[_Idx]._Is_zero(); _Idx = (_Idx + 1) & _Mask) {
+                    if (_Myslots[_Idx] == _Id) {
+                        return false;
+                    }
+                }
+
+                _Myslots[_Idx] = _Id;
+                ++_Mysize;
+                return true;
+            }
+
+        private:
+            static constexpr size_t _Initial_slot_count = 64;
+
+            size_t _Get_home_slot(const _File_id& _Id) const noexcept {
+                return static_cast<size_t>(_Hash_file_id(_Id)) & (_Myslots.size() - 1);
+            }
+
+            void _Grow() {
+                ::std::vector<_File_id> _Old(_Myslots.empty() ? _Initial_slot_count : _Myslots.size() * 2);
+                _Old.swap(_Myslots);
+                const size_t _Mask = _Myslots.size() - 1;
+                for (const _File_id& _Id : _Old) {
+                    if (!_Id._Is_zero()) {
+                        size_t _Idx = _Get_home_slot(_Id);
+                        while (!_Myslots[_Idx]._Is_zero()) {
+                            _Idx = (_Idx + 1) & _Mask;
+                        }
+
+                        _Myslots[_Idx] = _Id;
+                    }
+                }
+            }
+
+            ::std::vector<_File_id> _Myslots; // the number of slots is a power of two
+            size_t _Mysize;
+            bool _Myhas_zero;
+        };
+
+        class _Shared_file_id_set { // set of file IDs that can be shared by multiple threads
+        public:
+            _Shared_file_id_set() noexcept : _Myshards() {}
+
+            _Shared_file_id_set(const _Shared_file_id_set&)            = delete;
+            _Shared_file_id_set& operator=(const _Shared_file_id_set&) = delete;
+
+            bool _Insert(const _File_id& _Id) { // returns false if the ID is already in the set
+                // Note: The IDs are spread across independently locked shards, so the threads rarely wait
+                //       for each other. The shard is selected by the high bits of the hash, the slot within
+                //       the shard by the low ones.
+                _Shard& _Target = _Myshards[static_cast<size_t>(_Hash_file_id(_Id) >> (64 - _Shard_bits))];
+                ::std::lock_guard<::std::mutex> _Guard(_Target._Mtx);
+                return _Target._Ids._Insert(_Id);
+            }
+
+        private:
+            static constexpr size_t _Shard_bits = 6;
+
+            struct _Shard {
+                ::std::mutex _Mtx;
+                _File_id_set _Ids;
+            };
+
+            _Shard _Myshards[size_t{1} << _Shard_bits];
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_FILE_ID_HPP_
@@ -0,0 +1,28 @@
+// glob.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_GLOB_HPP_
+#define _MJFS_IMPL_GLOB_HPP_
+#include <cstddef>
+#include <cstdint>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline bool _Is_in_char_ranges(
+            const wchar_t* const _Ranges, const uint32_t _Count, const wchar_t _Ch) noexcept {
+            // checks whether the character belongs to any of the inclusive ranges (stored as pairs)
+            for (uint32_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                if (_Ch >= _Ranges[2 * _Idx] && _Ch <= _Ranges[2 * _Idx + 1]) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_GLOB_HPP_
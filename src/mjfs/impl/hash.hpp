@@ -0,0 +1,192 @@
+// hash.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_HASH_HPP_
+#define _MJFS_IMPL_HASH_HPP_
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <intrin.h>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline uint64_t _Multiply_and_fold(const uint64_t _Left, const uint64_t _Right) noexcept {
+            // computes the full 128-bit product and folds its halves into 64 bits
+#ifdef _M_X64
+            uint64_t _High;
+            const uint64_t _Low = ::_umul128(_Left, _Right, &_High);
+            return _Low ^ _High;
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+            const uint64_t _Left_low   = _Left & 0xFFFF'FFFF;
+            const uint64_t _Left_high  = _Left >> 32;
+            const uint64_t _Right_low  = _Right & 0xFFFF'FFFF;
+            const uint64_t _Right_high = _Right >> 32;
+            const uint64_t _Low_low    = _Left_low * _Right_low;
+            const uint64_t _Low_high   = _Left_low * _Right_high;
+            const uint64_t _High_low   = _Left_high * _Right_low;
+            const uint64_t _High_high  = _Left_high * _Right_high;
+            const uint64_t _Cross      = (_Low_low >> 32) + (_Low_high & 0xFFFF'FFFF) + _High_low;
+            const uint64_t _Low        = (_Cross << 32) | (_Low_low & 0xFFFF'FFFF);
+            const uint64_t _High       = _High_high + (_Low_high >> 32) + (_Cross >> 32);
+            return _Low ^ _High;
+#endif // _M_X64
+        }
+
+        inline uint64_t _Load_uint64(const unsigned char* const _Ptr) noexcept {
+            uint64_t _Value;
+            ::memcpy(&_Value, _Ptr, sizeof(uint64_t));
+            return _Value;
+        }
+
+        class _Path_hasher { // wyhash-style hasher, consumes the input in 16-byte blocks
+        public:
+            static constexpr size_t _Block_size = 16;
+
+            _Path_hasher() noexcept : _Mystate(_Secrets[0]), _Mysize(0) {}
+
+            explicit _Path_hasher(const uint64_t _Seed) noexcept : _Mystate(_Secrets[0] ^ _Seed), _Mysize(0) {}
+
+            void _Append_blocks(const void* const _Data, const size_t _Size) noexcept {
+                // Note: The size must be a multiple of _Block_size, only the final call to _Finish()
+                //       may receive a partial block. This allows the caller to feed the input in
+                //       chunks without changing the result.
+                const unsigned char* _First      = static_cast<const unsigned char*>(_Data);
+                const unsigned char* const _Last = _First + _Size;
+                for (; _First != _Last; _First += _Block_size) {
+                    _Mystate = _Multiply_and_fold(
+                        _Load_uint64(_First) ^ _Secrets[1], _Load_uint64(_First + 8) ^ _Mystate);
+                }
+
+                _Mysize += _Size;
+            }
+
+            uint64_t _Finish(const void* const _Data, const size_t _Size) noexcept {
+                const size_t _Tail = _Size % _Block_size;
+                _Append_blocks(_Data, _Size - _Tail);
+                if (_Tail > 0) { // process the remaining bytes as a zero-padded block
+                    unsigned char _Block[_Block_size] = {0};
+                    ::memcpy(_Block, static_cast<const unsigned char*>(_Data) + (_Size - _Tail), _Tail);
+                    _Append_blocks(_Block, _Block_size);
+                    _Mysize -= _Block_size - _Tail; // padding doesn't count
+                }
+
+                return _Multiply_and_fold(
+                    _Mystate ^ _Secrets[2], static_cast<uint64_t>(_Mysize) ^ _Secrets[3]);
+            }
+
+        private:
+            static constexpr uint64_t _Secrets[4] = {
+                0xA076'1D64'78BD'642F, 0xE703'7ED1'A0B4'28DB, 0x8EBC'6AF0'9C88'C6E3, 0x5899'65CC'7537'4CC3};
+
+            uint64_t _Mystate;
+            size_t _Mysize;
+        };
+
+        inline uint64_t _Hash_path_string(const unicode_string_view _Str) noexcept {
+            _Path_hasher _Hasher;
+            return _Hasher._Finish(_Str.data(), _Str.size() * sizeof(wchar_t));
+        }
+
+        // the number of characters folded at once, keeps the chunk a multiple of the hasher's block
+        inline constexpr size_t _Fold_chunk_size = 64;
+
+        inline void _Fold_path_chunk(
+            const wchar_t* const _Src, const size_t _Count, wchar_t* const _Dest) noexcept {
+            // Note: Windows file systems compare names case-insensitively, so both slashes are mapped
+            //       to the preferred separator and all letters are mapped to upper case. ASCII letters
+            //       are handled inline, the rest of the chunk is passed to LCMapStringEx() only if it
+            //       contains at least one non-ASCII character.
+            bool _Has_non_ascii = false;
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                const wchar_t _Ch = _Src[_Idx];
+                if (_Ch == L'/') {
+                    _Dest[_Idx] = L'\\';
+                } else if (_Ch >= L'a' && _Ch <= L'z') {
+                    _Dest[_Idx] = static_cast<wchar_t>(_Ch - (L'a' - L'A'));
+                } else {
+                    _Dest[_Idx] = _Ch;
+                    if (_Ch >= 0x80) {
+                        _Has_non_ascii = true;
+                    }
+                }
+            }
+
+            if (_Has_non_ascii) { // the mapping is one-to-one, so it can be done in-place
+                ::LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, _Dest, static_cast<int>(_Count),
+                    _Dest, static_cast<int>(_Count), nullptr, nullptr, 0);
+            }
+        }
+
+        inline uint64_t _Hash_path_string_insensitive(const unicode_string_view _Str) noexcept {
+            _Path_hasher _Hasher;
+            wchar_t _Chunk[_Fold_chunk_size];
+            const wchar_t* _First = _Str.data();
+            size_t _Remaining     = _Str.size();
+            while (_Remaining > _Fold_chunk_size) {
+                _Fold_path_chunk(_First, _Fold_chunk_size, _Chunk);
+                _Hasher._Append_blocks(_Chunk, sizeof(_Chunk));
+                _First     += _Fold_chunk_size;
+                _Remaining -= _Fold_chunk_size;
+            }
+
+            _Fold_path_chunk(_First, _Remaining, _Chunk);
+            return _Hasher._Finish(_Chunk, _Remaining * sizeof(wchar_t));
+        }
+
+        inline bool _Equal_path_strings_insensitive(
+            const unicode_string_view _Left, const unicode_string_view _Right) noexcept {
+            if (_Left.size() != _Right.size()) { // folding never changes the length
+                return false;
+            }
+
+            wchar_t _Left_chunk[_Fold_chunk_size];
+            wchar_t _Right_chunk[_Fold_chunk_size];
+            for (size_t _Off = 0; _Off < _Left.size(); _Off += _Fold_chunk_size) {
+                const size_t _Count = (::std::min)(_Left.size() - _Off, _Fold_chunk_size);
+                if (::memcmp(_Left.data() + _Off, _Right.data() + _Off, _Count * sizeof(wchar_t)) == 0) {
+                    continue; // identical chunks, no need to fold
+                }
+
+                _Fold_path_chunk(_Left.data() + _Off, _Count, _Left_chunk);
+                _Fold_path_chunk(_Right.data() + _Off, _Count, _Right_chunk);
+                if (::memcmp(_Left_chunk, _Right_chunk, _Count * sizeof(wchar_t)) != 0) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        inline size_t _Narrow_hash(const uint64_t _Hash) noexcept {
+#ifdef _M_X64
+            return static_cast<size_t>(_Hash);
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+            return static_cast<size_t>(_Hash ^ (_Hash >> 32));
+#endif // _M_X64
+        }
+
+        struct _Insensitive_string_hash { // hashes strings the same way as path_insensitive_hash
+            using is_transparent = void;
+
+            size_t operator()(const unicode_string_view _Str) const noexcept {
+                return _Narrow_hash(_Hash_path_string_insensitive(_Str));
+            }
+        };
+
+        struct _Insensitive_string_equal { // compares strings the same way as path_insensitive_equal
+            using is_transparent = void;
+
+            bool operator()(const unicode_string_view _Left, const unicode_string_view _Right) const noexcept {
+                return _Equal_path_strings_insensitive(_Left, _Right);
+            }
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_HASH_HPP_
\ No newline at end of file
@@ -0,0 +1,541 @@
+// metadata_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_METADATA_CACHE_HPP_
+#define _MJFS_IMPL_METADATA_CACHE_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/path.hpp>
+#include <mjfs/impl/status.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/metadata_cache.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Directory_watcher { // watches directories, each change increments the directory's generation
+        public:
+            // the identifier of a directory that is not watched
+            static constexpr uint32_t _Unwatched = static_cast<uint32_t>(-1);
+
+            // set in the generation of a directory that is no longer watched
+            static constexpr uint64_t _Stopped = uint64_t{1} << 63;
+
+            explicit _Directory_watcher(const size_t _Max_directories)
+                : _Mymtx(), _Myport(::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1)),
+                _Mythread(), _Mywatches(_Max_directories), _Mycount(0), _Myfree(), _Myids() {
+                _Myfree.reserve(_Max_directories); // releasing a watch must not allocate
+                if (_Myport != nullptr) {
+                    _Mythread = ::std::thread(&_Directory_watcher::_Run, this);
+                }
+            }
+
+            ~_Directory_watcher() noexcept {
+                if (_Myport == nullptr) {
+                    return;
+                }
+
+                // a packet without OVERLAPPED stops the thread
+                ::PostQueuedCompletionStatus(_Myport, 0, 0, nullptr);
+                _Mythread.join();
+                for (size_t _Idx = 0; _Idx < _Mycount; ++_Idx) {
+                    _Watch_entry& _Entry = *_Mywatches[_Idx];
+                    if (_Entry._Handle == nullptr) { // released after a failure
+                        continue;
+                    }
+
+                    if (::CancelIoEx(_Entry._Handle, &_Entry._Overlapped) != 0) { // wait for the cancellation
+                        unsigned long _Bytes;
+                        ::GetOverlappedResult(_Entry._Handle, &_Entry._Overlapped, &_Bytes, TRUE);
+                    }
+                }
+
+                _Mywatches.clear();
+                ::CloseHandle(_Myport);
+            }
+
+            _Directory_watcher(const _Directory_watcher&)            = delete;
+            _Directory_watcher& operator=(const _Directory_watcher&) = delete;
+
+            uint32_t _Watch(const unicode_string_view _Dir) {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                const auto _Iter = _Myids.find(_Dir);
+                if (_Iter != _Myids.end()) {
+                    return _Iter->second;
+                }
+
+                // Note: Directories that couldn't be watched are remembered as well, so that they are not
+                //       opened again on every cache miss. Above the limit, no directory is opened at all.
+                if (_Myport == nullptr || _Myids.size() >= _Mywatches.size()) {
+                    return _Unwatched;
+                }
+
+                unicode_string _Str(_Dir.data(), _Dir.size()); // CreateFileW() requires a null-terminator
+                const uint32_t _Id = _Start_watch(_Str);
+                _Myids.emplace(::std::move(_Str), _Id);
+                return _Id;
+            }
+
+            uint64_t _Generation(const uint32_t _Id) const noexcept {
+                return _Mywatches[_Id]->_Generation.load(::std::memory_order_acquire);
+            }
+
+        private:
+            struct _Watch_entry {
+                void* _Handle; // null while the slot is free
+                OVERLAPPED _Overlapped;
+                unsigned long _Buffer[256]; // must be DWORD-aligned, the notifications are not inspected
+                ::std::atomic<uint64_t> _Generation;
+                uint32_t _Slot; // the position in the watches, used as the directory's identifier
+                unicode_string _Directory; // the key in the identifiers, removed when the watch is released
+
+                explicit _Watch_entry(const uint32_t _Slot_idx) noexcept
+                    : _Handle(nullptr), _Overlapped{}, _Buffer{}, _Generation(0), _Slot(_Slot_idx),
+                    _Directory() {}
+
+                ~_Watch_entry() noexcept {
+                    _Close();
+                }
+
+                void _Close() noexcept {
+                    if (_Handle != nullptr) {
+                        ::CloseHandle(_Handle);
+                        _Handle = nullptr;
+                    }
+                }
+
+                _Watch_entry(const _Watch_entry&)            = delete;
+                _Watch_entry& operator=(const _Watch_entry&) = delete;
+            };
+
+            static bool _Read_changes(_Watch_entry& _Entry) noexcept {
+                // Note: The system buffers the changes between the calls, so nothing is lost while
+                //       the generation is incremented. An overflow is reported as a regular notification.
+                return ::ReadDirectoryChangesW(_Entry._Handle, _Entry._Buffer, sizeof(_Entry._Buffer), FALSE,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+                        | FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE
+                        | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
+                    nullptr, &_Entry._Overlapped, nullptr) != 0;
+            }
+
+            uint32_t _Start_watch(const unicode_string& _Dir) {
+                const bool _Reuse = !_Myfree.empty();
+                if (!_Reuse && _Mycount == _Mywatches.size()) { // all watches are already in use
+                    return _Unwatched;
+                }
+
+                void* const _Handle = ::CreateFileW(_Dir.c_str(), FILE_LIST_DIRECTORY,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+                if (_Handle == INVALID_HANDLE_VALUE) {
+                    return _Unwatched;
+                }
+
+                const uint32_t _Slot = _Reuse ? _Myfree.back() : static_cast<uint32_t>(_Mycount);
+                if (!_Reuse) { // an entry that was never published can be replaced
+                    _Mywatches[_Slot].reset(::mjx::create_object<_Watch_entry>(_Slot));
+                }
+
+                // Note: A released entry stays in place, because the readers may still hold its identifier.
+                //       Its generation continues from the last one, so a status cached for the previous
+                //       directory never matches the new one.
+                _Watch_entry& _Entry = *_Mywatches[_Slot];
+                _Entry._Handle       = _Handle;
+                _Entry._Overlapped   = OVERLAPPED{};
+                const uint64_t _Last = _Entry._Generation.load(::std::memory_order_relaxed);
+                _Entry._Generation.store((_Last & ~_Stopped) + 1, ::std::memory_order_release);
+                if (::CreateIoCompletionPort(_Handle, _Myport, reinterpret_cast<ULONG_PTR>(&_Entry), 0)
+                    == nullptr || !_Read_changes(_Entry)) {
+                    _Entry._Generation.fetch_or(_Stopped, ::std::memory_order_release);
+                    _Entry._Close();
+                    return _Unwatched;
+                }
+
+                _Entry._Directory = _Dir;
+                if (_Reuse) {
+                    _Myfree.pop_back();
+                } else {
+                    ++_Mycount;
+                }
+
+                return _Slot;
+            }
+
+            void _Release_watch(_Watch_entry& _Entry) noexcept {
+                // Note: The handle is closed and the slot is handed to the next directory, so a failed watch
+                //       doesn't hold one of the limited watches forever. The directory is forgotten as well,
+                //       so it's watched again on the next cache miss.
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                _Entry._Generation.fetch_or(_Stopped, ::std::memory_order_release);
+                _Entry._Close();
+                _Myids.erase(_Entry._Directory);
+                _Myfree.push_back(_Entry._Slot); // never allocates, the capacity is reserved
+            }
+
+            void _Run() noexcept {
+                for (;;) {
+                    unsigned long _Bytes;
+                    ULONG_PTR _Key;
+                    OVERLAPPED* _Overlapped;
+                    const BOOL _Succeeded =
+                        ::GetQueuedCompletionStatus(_Myport, &_Bytes, &_Key, &_Overlapped, INFINITE);
+                    if (_Overlapped == nullptr) { // a stop request or the port is no longer usable
+                        break;
+                    }
+
+                    // Note: The whole directory is invalidated instead of the reported names, so the entries
+                    //       can be validated without a lock and a status read before a change is never kept.
+                    _Watch_entry& _Entry = *reinterpret_cast<_Watch_entry*>(_Key);
+                    _Entry._Generation.fetch_add(1, ::std::memory_order_release);
+                    if (_Succeeded == 0 || !_Read_changes(_Entry)) { // from now on, only the TTL applies
+                        _Release_watch(_Entry);
+                    }
+                }
+            }
+
+            ::std::mutex _Mymtx;
+            void* _Myport;
+            ::std::thread _Mythread;
+            ::std::vector<unique_smart_ptr<_Watch_entry>> _Mywatches; // never resized, readers don't lock
+            size_t _Mycount; // the number of slots ever used
+            ::std::vector<uint32_t> _Myfree; // the slots released after a failure
+            ::std::unordered_map<unicode_string, uint32_t, _Insensitive_string_hash, _Insensitive_string_equal>
+                _Myids;
+        };
+
+        struct _Cached_status { // a single kind of status, loaded at once
+            file_status _Value;
+            uint64_t _Loaded_at; // the tick count at the time of loading
+            uint64_t _Generation; // the generation of the parent directory before loading
+            bool _Valid;
+        };
+
+        class _Freshness_policy { // decides whether a cached status can still be used
+        public:
+            _Freshness_policy(const uint64_t _Ttl, const _Directory_watcher* const _Watcher) noexcept
+                : _Myttl(_Ttl), _Mywatcher(_Watcher) {}
+
+            // checks whether an entry of the directory can ever be fresh
+            bool _Can_cache(const uint32_t _Dir) const noexcept {
+                return _Myttl != 0 || _Dir != _Directory_watcher::_Unwatched;
+            }
+
+            bool _Is_fresh(
+                const _Cached_status& _Status, const uint32_t _Dir, const uint64_t _Now) const noexcept {
+                if (!_Status._Valid || (_Myttl != 0 && _Now - _Status._Loaded_at >= _Myttl)) {
+                    return false;
+                }
+
+                if (_Dir == _Directory_watcher::_Unwatched) {
+                    return _Myttl != 0;
+                }
+
+                // Note: The generation is read before the status is loaded, so a change made in the meantime
+                //       makes the entry out of date. A stopped watch falls back to the TTL.
+                const uint64_t _Generation = _Mywatcher->_Generation(_Dir);
+                if (_Generation != _Status._Generation) {
+                    return false;
+                }
+
+                return (_Generation & _Directory_watcher::_Stopped) == 0 || _Myttl != 0;
+            }
+
+        private:
+            uint64_t _Myttl;
+            const _Directory_watcher* _Mywatcher;
+        };
+
+        struct _Metadata_entry { // a cached path, the status is stored with and without following links
+            unicode_string _Key;
+            uint64_t _Hash      = 0;
+            uint32_t _Directory = _Directory_watcher::_Unwatched;
+            bool _Used          = false;
+            _Cached_status _Status[2] = {}; // indexed by the following of links
+            mutable ::std::atomic<bool> _Referenced = false; // set on every hit, cleared by the eviction
+        };
+
+        class _Metadata_shard { // independently locked part of the cache
+        public:
+            explicit _Metadata_shard(const size_t _Capacity)
+                : _Mymtx(), _Myentries(_Capacity), _Myslots(_Get_slot_count(_Capacity), 0),
+                _Mysize(0), _Myhigh_water(0), _Myhand(0) {}
+
+            _Metadata_shard(const _Metadata_shard&)            = delete;
+            _Metadata_shard& operator=(const _Metadata_shard&) = delete;
+
+            bool _Find(const unicode_string_view _Key, const uint64_t _Hash, const size_t _Kind,
+                const _Freshness_policy& _Policy, const uint64_t _Now, file_status& _Result) const {
+                ::std::shared_lock<::std::shared_mutex> _Guard(_Mymtx);
+                const uint32_t _Slot = _Myslots[_Find_slot(_Key, _Hash)];
+                if (_Slot == 0) {
+                    return false;
+                }
+
+                const _Metadata_entry& _Entry = _Myentries[_Slot - 1];
+                if (!_Policy._Is_fresh(_Entry._Status[_Kind], _Entry._Directory, _Now)) {
+                    return false;
+                }
+
+                if (!_Entry._Referenced.load(::std::memory_order_relaxed)) { // write only if necessary
+                    _Entry._Referenced.store(true, ::std::memory_order_relaxed);
+                }
+
+                _Result = _Entry._Status[_Kind]._Value;
+                return true;
+            }
+
+            void _Store(const unicode_string_view _Key, const uint64_t _Hash, const size_t _Kind,
+                const uint32_t _Dir, const _Cached_status& _Status) {
+                ::std::unique_lock<::std::shared_mutex> _Guard(_Mymtx);
+                size_t _Pos = _Find_slot(_Key, _Hash);
+                if (_Myslots[_Pos] == 0) {
+                    const uint32_t _Idx      = _Acquire_entry();
+                    _Metadata_entry& _Entry  = _Myentries[_Idx];
+                    _Entry._Key              = unicode_string(_Key.data(), _Key.size());
+                    _Entry._Hash             = _Hash;
+                    _Entry._Directory        = _Dir;
+                    _Entry._Used             = true;
+                    _Entry._Status[0]._Valid = false;
+                    _Entry._Status[1]._Valid = false;
+                    _Entry._Referenced.store(false, ::std::memory_order_relaxed);
+                    _Pos           = _Find_slot(_Key, _Hash); // the eviction could have moved the slots
+                    _Myslots[_Pos] = _Idx + 1;
+                    ++_Mysize;
+                }
+
+                _Metadata_entry& _Entry = _Myentries[_Myslots[_Pos] - 1];
+                if (_Entry._Directory != _Dir) { // the other status refers to a different generation
+                    _Entry._Directory                = _Dir;
+                    _Entry._Status[_Kind ^ 1]._Valid = false;
+                }
+
+                _Entry._Status[_Kind] = _Status;
+            }
+
+            void _Erase(const unicode_string_view _Key, const uint64_t _Hash) noexcept {
+                ::std::unique_lock<::std::shared_mutex> _Guard(_Mymtx);
+                const size_t _Pos = _Find_slot(_Key, _Hash);
+                if (_Myslots[_Pos] != 0) {
+                    _Unlink(_Pos);
+                }
+            }
+
+            void _Clear() noexcept {
+                ::std::unique_lock<::std::shared_mutex> _Guard(_Mymtx);
+                for (uint32_t& _Slot : _Myslots) {
+                    _Slot = 0;
+                }
+
+                for (_Metadata_entry& _Entry : _Myentries) {
+                    _Entry._Used = false;
+                }
+
+                _Mysize       = 0;
+                _Myhigh_water = 0;
+                _Myhand       = 0;
+            }
+
+            size_t _Size() const noexcept {
+                ::std::shared_lock<::std::shared_mutex> _Guard(_Mymtx);
+                return _Mysize;
+            }
+
+        private:
+            static size_t _Get_slot_count(const size_t _Capacity) noexcept {
+                size_t _Count = 2;
+                while (_Count < _Capacity * 2) { // keep the load factor at most 0.5
+                    _Count <<= 1;
+                }
+
+                return _Count;
+            }
+
+            size_t _Find_slot(const unicode_string_view _Key, const uint64_t _Hash) const noexcept {
+                const size_t _Mask = _Myslots.size() - 1;
+                for (size_t _Pos = static_cast<size_t>(_Hash) & _Mask;; _Pos = (_Pos + 1) & _Mask) {
+                    if (_Myslots[_Pos] == 0) {
+                        return _Pos;
+                    }
+
+                    const _Metadata_entry& _Entry = _Myentries[_Myslots[_Pos] - 1];
+                    if (_Entry._Hash == _Hash && _Equal_path_strings_insensitive(_Entry._Key, _Key)) {
+                        return _Pos;
+                    }
+                }
+            }
+
+            void _Unlink(size_t _Pos) noexcept {
+                _Myentries[_Myslots[_Pos] - 1]._Used = false;
+                --_Mysize;
+
+                // Note: The following slots are shifted back, so the probing sequences stay unbroken
+                //       without tombstones. A slot is moved only if the hole lies on its probing sequence.
+                const size_t _Mask = _Myslots.size() - 1;
+                for (size_t _Next = (_Pos + 1) & _Mask; _Myslots[_Next] != 0; _Next = (_Next + 1) & _Mask) {
+                    const size_t _Home = static_cast<size_t>(_Myentries[_Myslots[_Next] - 1]._Hash) & _Mask;
+                    if (((_Next - _Home) & _Mask) >= ((_Next - _Pos) & _Mask)) {
+                        _Myslots[_Pos] = _Myslots[_Next];
+                        _Pos           = _Next;
+                    }
+                }
+
+                _Myslots[_Pos] = 0;
+            }
+
+            uint32_t _Acquire_entry() noexcept {
+                if (_Myhigh_water < _Myentries.size()) { // some entries were never used
+                    return static_cast<uint32_t>(_Myhigh_water++);
+                }
+
+                // Note: The entries are evicted with the CLOCK algorithm, which approximates LRU. A hit
+                //       only sets a flag, so the readers can share the lock. Every entry is visited at most
+                //       twice.
+                for (;;) {
+                    const size_t _Idx       = _Myhand;
+                    _Metadata_entry& _Entry = _Myentries[_Idx];
+                    _Myhand                 = (_Myhand + 1) % _Myentries.size();
+                    if (!_Entry._Used) {
+                        return static_cast<uint32_t>(_Idx);
+                    }
+
+                    if (!_Entry._Referenced.exchange(false, ::std::memory_order_relaxed)) { // evict the entry
+                        _Unlink(_Find_slot(_Entry._Key, _Entry._Hash));
+                        return static_cast<uint32_t>(_Idx);
+                    }
+                }
+            }
+
+            mutable ::std::shared_mutex _Mymtx;
+            ::std::vector<_Metadata_entry> _Myentries;
+            ::std::vector<uint32_t> _Myslots; // open-addressing index (linear probing), 0 means empty
+            size_t _Mysize;
+            size_t _Myhigh_water; // the number of entries that were ever used
+            size_t _Myhand; // the position of the CLOCK hand
+        };
+
+        class _Metadata_cache {
+        public:
+            explicit _Metadata_cache(const metadata_cache_options& _Options)
+                : _Myttl(_Get_ttl(_Options)), _Mywatcher(), _Myshards(), _Myshard_mask(0) {
+                size_t _Shard_count = 1;
+                while (_Shard_count < _Options.shard_count && _Shard_count < _Options.capacity) {
+                    _Shard_count <<= 1;
+                }
+
+                const size_t _Shard_capacity = _Options.capacity > _Shard_count
+                    ? (_Options.capacity + _Shard_count - 1) / _Shard_count : 1;
+                _Myshards.reserve(_Shard_count);
+                for (size_t _Idx = 0; _Idx < _Shard_count; ++_Idx) {
+                    _Myshards.emplace_back(::mjx::create_object<_Metadata_shard>(_Shard_capacity));
+                }
+
+                _Myshard_mask = _Shard_count - 1;
+                if (_Options.watch_directories && _Options.max_watched_directories > 0) {
+                    _Mywatcher.reset(
+                        ::mjx::create_object<_Directory_watcher>(_Options.max_watched_directories));
+                }
+            }
+
+            _Metadata_cache(const _Metadata_cache&)            = delete;
+            _Metadata_cache& operator=(const _Metadata_cache&) = delete;
+
+            file_status _Get_status(const path& _Target, const bool _Follow) {
+                const unicode_string_view _Key = _Target.native();
+                const uint64_t _Hash           = _Hash_path_string_insensitive(_Key);
+                const size_t _Kind             = _Follow ? 1 : 0;
+                const _Freshness_policy _Policy(_Myttl, _Mywatcher.get());
+                _Metadata_shard& _Shard = _Select_shard(_Hash);
+                file_status _Result;
+                if (_Shard._Find(_Key, _Hash, _Kind, _Policy, ::GetTickCount64(), _Result)) {
+                    return _Result;
+                }
+
+                uint32_t _Dir = _Directory_watcher::_Unwatched;
+                if (_Mywatcher) {
+                    _Dir = _Mywatcher->_Watch(_Split_directory_and_name(_Key)._Directory);
+                }
+
+                if (!_Policy._Can_cache(_Dir)) {
+                    return _Load_status(_Target, _Follow);
+                }
+
+                const uint64_t _Generation =
+                    _Dir != _Directory_watcher::_Unwatched ? _Mywatcher->_Generation(_Dir) : 0;
+
+                // Note: The watch covers only the directory of the link, not the directory of its target.
+                //       Without the TTL, nothing would ever expire the target's status, so it's not cached.
+                const uint64_t _Now = ::GetTickCount64();
+                bool _Followed      = false;
+                if (_Follow) {
+                    _Result = mjfs_impl::_Get_status(_Target.c_str(), _Followed);
+                } else {
+                    _Result = _Get_symlink_status(_Target.c_str());
+                }
+
+                if (_Result.type != file_type::none // failures are not cached, they could be temporary
+                    && (!_Followed || _Myttl != 0)) {
+                    _Shard._Store(_Key, _Hash, _Kind, _Dir, _Cached_status{_Result, _Now, _Generation, true});
+                }
+
+                return _Result;
+            }
+
+            void _Invalidate(const unicode_string_view _Key) noexcept {
+                const uint64_t _Hash = _Hash_path_string_insensitive(_Key);
+                _Select_shard(_Hash)._Erase(_Key, _Hash);
+            }
+
+            void _Clear() noexcept {
+                for (const unique_smart_ptr<_Metadata_shard>& _Shard : _Myshards) {
+                    _Shard->_Clear();
+                }
+            }
+
+            size_t _Size() const noexcept {
+                size_t _Result = 0;
+                for (const unique_smart_ptr<_Metadata_shard>& _Shard : _Myshards) {
+                    _Result += _Shard->_Size();
+                }
+
+                return _Result;
+            }
+
+        private:
+            static uint64_t _Get_ttl(const metadata_cache_options& _Options) noexcept {
+                // Note: A watch covers only the parent directory, so renaming or removing an ancestor
+                //       is never reported. The TTL bounds such a stale entry, so it can't be zero.
+                if (_Options.ttl == 0 && _Options.watch_directories && _Options.max_watched_directories > 0) {
+                    return metadata_cache_options{}.ttl;
+                }
+
+                return _Options.ttl;
+            }
+
+            _Metadata_shard& _Select_shard(const uint64_t _Hash) const noexcept {
+                // the slot is selected by the low bits, so the shard is selected by the high ones
+                return *_Myshards[static_cast<size_t>(_Hash >> 32) & _Myshard_mask];
+            }
+
+            uint64_t _Myttl;
+            unique_smart_ptr<_Directory_watcher> _Mywatcher; // null if the directories are not watched
+            ::std::vector<unique_smart_ptr<_Metadata_shard>> _Myshards;
+            size_t _Myshard_mask;
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_METADATA_CACHE_HPP_
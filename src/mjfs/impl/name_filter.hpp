@@ -0,0 +1,112 @@
+// name_filter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_NAME_FILTER_HPP_
+#define _MJFS_IMPL_NAME_FILTER_HPP_
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        // the number of probes is limited, so a very low false-positive rate doesn't make lookups slow
+        inline constexpr size_t _Max_bloom_hash_count = 16;
+
+        inline size_t _Get_bloom_word_count(const size_t _Count, const double _Rate) noexcept {
+            // Note: The optimal number of bits is -n * ln(p) / ln(2)^2. The result is rounded up to whole
+            //       64-bit words, and at least one word is used, so an empty directory has a valid filter.
+            constexpr double _Ln2_squared = 0.4804530139182014;
+            const double _Bits            = -static_cast<double>(_Count) * ::std::log(_Rate) / _Ln2_squared;
+            return (::std::max)(static_cast<size_t>(::std::ceil(_Bits / 64.0)), size_t{1});
+        }
+
+        inline size_t _Get_bloom_hash_count(const size_t _Word_count, const size_t _Count) noexcept {
+            // the optimal number of hashes is m / n * ln(2)
+            if (_Count == 0) {
+                return 1;
+            }
+
+            constexpr double _Ln2 = 0.6931471805599453;
+            const size_t _Hashes  = static_cast<size_t>(
+                ::std::lround(static_cast<double>(_Word_count * 64) / static_cast<double>(_Count) * _Ln2));
+            return (::std::clamp)(_Hashes, size_t{1}, _Max_bloom_hash_count);
+        }
+
+        class _Bloom_probe { // generates the bit positions of a single hash (double hashing)
+        public:
+            _Bloom_probe(const uint64_t _Hash, const size_t _Bit_count) noexcept
+                : _Mypos(static_cast<uint32_t>(_Hash)), _Mystep(static_cast<uint32_t>(_Hash >> 32) | 1),
+                _Mybits(static_cast<uint64_t>(_Bit_count)) {}
+
+            size_t _Next() noexcept {
+                const size_t _Result = static_cast<size_t>(_Mypos % _Mybits);
+                _Mypos              += _Mystep;
+                return _Result;
+            }
+
+        private:
+            uint64_t _Mypos;
+            uint64_t _Mystep; // odd, so that consecutive positions differ
+            uint64_t _Mybits;
+        };
+
+        inline void _Insert_into_bloom_filter(
+            ::std::vector<uint64_t>& _Words, const size_t _Hash_count, const uint64_t _Hash) noexcept {
+            _Bloom_probe _Probe(_Hash, _Words.size() * 64);
+            for (size_t _Idx = 0; _Idx < _Hash_count; ++_Idx) {
+                const size_t _Bit  = _Probe._Next();
+                _Words[_Bit / 64] |= uint64_t{1} << (_Bit % 64);
+            }
+        }
+
+        inline bool _Test_bloom_filter(
+            const ::std::vector<uint64_t>& _Words, const size_t _Hash_count, const uint64_t _Hash) noexcept {
+            _Bloom_probe _Probe(_Hash, _Words.size() * 64);
+            for (size_t _Idx = 0; _Idx < _Hash_count; ++_Idx) {
+                const size_t _Bit = _Probe._Next();
+                if ((_Words[_Bit / 64] & (uint64_t{1} << (_Bit % 64))) == 0) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        inline bool _Collect_name_hashes(const path& _Dir, ::std::vector<uint64_t>& _Hashes) {
+            // Note: The system resolves the short (8.3) name of an entry as well, so both names are hashed.
+            //       Any enumeration error fails the build, since a partial filter would reject names that
+            //       exist. A path that is not a directory can't be enumerated, so it fails as well.
+            _Hashes.clear();
+            return _For_each_directory_info<FILE_ID_BOTH_DIR_INFO>(_Dir.c_str(), FileIdBothDirectoryInfo,
+                [&_Hashes](const unicode_string_view _Name, const FILE_ID_BOTH_DIR_INFO& _Info) {
+                    _Hashes.push_back(_Hash_path_string_insensitive(_Name));
+                    if (_Info.ShortNameLength > 0) { // the length is in bytes
+                        _Hashes.push_back(_Hash_path_string_insensitive(unicode_string_view{
+                            _Info.ShortName, static_cast<size_t>(_Info.ShortNameLength) / sizeof(wchar_t)}));
+                    }
+                });
+        }
+
+        inline void* _Watch_directory_names(const wchar_t* const _Dir) noexcept {
+            return ::FindFirstChangeNotificationW(
+                _Dir, FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+        }
+
+        inline bool _Has_directory_changed(void* const _Handle) noexcept {
+            // the notification stays signaled until the next FindNextChangeNotification() call
+            return ::WaitForSingleObject(_Handle, 0) != WAIT_TIMEOUT;
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_NAME_FILTER_HPP_
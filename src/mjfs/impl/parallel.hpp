@@ -0,0 +1,126 @@
+// parallel.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_PARALLEL_HPP_
+#define _MJFS_IMPL_PARALLEL_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        // the maximum number of threads used by a single parallel operation
+        inline constexpr size_t _Max_worker_count = 32;
+
+        inline size_t _Get_worker_count(const size_t _Task_count) noexcept {
+            // Note: The tasks wait for the file system most of the time, so there are twice as many threads
+            //       as processors. The calling thread is counted as one of them.
+            const size_t _Processors = (::std::max)(::std::thread::hardware_concurrency(), 1u);
+            return (::std::min)(_Task_count, (::std::min)(_Processors * 2, _Max_worker_count));
+        }
+
+        class _Thread_group { // joins all threads on destruction, even if starting one of them failed
+        public:
+            _Thread_group() noexcept : _Mythreads(), _Mymtx(), _Myexception(), _Mystopped(false) {}
+
+            ~_Thread_group() noexcept {
+                _Join_all();
+            }
+
+            _Thread_group(const _Thread_group&)            = delete;
+            _Thread_group& operator=(const _Thread_group&) = delete;
+
+            template <class _Fn>
+            void _Start(const size_t _Count, const _Fn& _Func) {
+                _Mythreads.reserve(_Count);
+                for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                    _Mythreads.emplace_back([this, _Func] { _Run(_Func); });
+                }
+            }
+
+            template <class _Fn>
+            void _Run(const _Fn& _Func) noexcept {
+                // Note: An exception must not leave a thread, since that terminates the process. The first
+                //       one is kept and rethrown by _Join() on the calling thread, the others are dropped.
+                try {
+                    _Func();
+                } catch (...) {
+                    ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                    if (_Myexception == nullptr) {
+                        _Myexception = ::std::current_exception();
+                    }
+
+                    _Mystopped.store(true, ::std::memory_order_relaxed);
+                }
+            }
+
+            bool _Stopped() const noexcept {
+                // checks whether some function threw, the other threads should stop early
+                return _Mystopped.load(::std::memory_order_relaxed);
+            }
+
+            void _Join() {
+                // waits for all threads, then rethrows the first exception thrown by any of them
+                _Join_all();
+                if (_Myexception != nullptr) {
+                    ::std::rethrow_exception(_Myexception);
+                }
+            }
+
+        private:
+            void _Join_all() noexcept {
+                for (::std::thread& _Thread : _Mythreads) {
+                    if (_Thread.joinable()) {
+                        _Thread.join();
+                    }
+                }
+            }
+
+            ::std::vector<::std::thread> _Mythreads;
+            ::std::mutex _Mymtx;
+            ::std::exception_ptr _Myexception; // the first exception thrown by any thread
+            ::std::atomic<bool> _Mystopped;
+        };
+
+        template <class _Fn>
+        inline void _Parallel_for(const size_t _Count, const _Fn& _Func) {
+            // Note: The tasks are claimed one at a time through a shared counter, so a slow task doesn't
+            //       hold back the ones that follow it. The calling thread takes part in the work.
+            //       Once a task throws, no further tasks are started and the exception is rethrown here.
+            const size_t _Workers = _Get_worker_count(_Count);
+            if (_Workers <= 1) { // not worth starting any thread
+                for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                    _Func(_Idx);
+                }
+
+                return;
+            }
+
+            ::std::atomic<size_t> _Next(0);
+            _Thread_group _Group;
+            const auto _Work = [&_Next, _Count, &_Func, &_Group] {
+                for (size_t _Idx = _Next.fetch_add(1, ::std::memory_order_relaxed); _Idx < _Count;
+                     _Idx = _Next.fetch_add(1, ::std::memory_order_relaxed)) {
+                    if (_Group._Stopped()) { // some task threw
+                        break;
+                    }
+
+                    _Func(_Idx);
+                }
+            };
+
+            _Group._Start(_Workers - 1, _Work);
+            _Group._Run(_Work);
+            _Group._Join();
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_PARALLEL_HPP_
@@ -6,14 +6,17 @@
 #pragma once
 #ifndef _MJFS_IMPL_PATH_HPP_
 #define _MJFS_IMPL_PATH_HPP_
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
 #include <mjstr/string_view.hpp>
 
 namespace mjx {
     namespace mjfs_impl {
-        inline bool _Is_slash(const wchar_t _Ch) noexcept {
-            return _Ch == L'\\' || _Ch == L'/';
+        constexpr bool _Is_slash(const wchar_t _Ch) noexcept {
+            return _Is_path_slash(_Ch);
         }
 
         inline bool _Is_dot_or_dot_dot(const unicode_string_view _Str) noexcept {
@@ -34,18 +37,10 @@ namespace mjx {
         }
 
         inline size_t _Find_last_slash(const unicode_string_view _Str) noexcept {
-            const wchar_t* const _First = _Str.data();
-            const wchar_t* _Last        = _First + _Str.size();
-            for (; _Last != _First - 1; --_Last) {
-                if (_Is_slash(*_Last)) {
-                    return _Last - _First;
-                }
-            }
-
-            return unicode_string_view::npos; // not found
+            return _Find_last_path_slash(_Str.data(), _Str.size());
         }
 
-        inline bool _Is_drive_prefix(const wchar_t _Ch) noexcept {
+        constexpr bool _Is_drive_prefix(const wchar_t _Ch) noexcept {
             return (_Ch >= L'C' && _Ch <= L'Z') || (_Ch >= L'c' && _Ch <= L'z');
         }
 
@@ -119,80 +114,93 @@ namespace mjx {
             }
         }
 
-        inline unicode_string_view _Get_parent_path(const unicode_string_view _Str) noexcept {
-            if (_Str.empty()) {
-                return unicode_string_view{};
+        struct _Directory_and_name { // the directory that contains the target and the target's name in it
+            unicode_string_view _Directory;
+            unicode_string_view _Name; // empty if the target is a root directory
+        };
+
+        inline _Directory_and_name _Split_directory_and_name(unicode_string_view _Str) noexcept {
+            // Note: A path without slashes refers to the current directory. Redundant slashes at the end
+            //       are removed, so "dir\" is split like "dir", but the root directory is kept.
+            const size_t _Root_length = _Has_drive_and_slash(_Str)
+                ? 3 : (_Has_drive(_Str) ? 2 : (!_Str.empty() && _Is_slash(_Str[0]) ? 1 : 0));
+            while (_Str.size() > (::std::max)(_Root_length, size_t{1}) && _Is_slash(_Str.back())) {
+                _Str.remove_suffix(1);
             }
-        
+
             const size_t _Slash = _Find_last_slash(_Str);
-            switch (_Slash) {
-            case 0: // root directory is a parent path
-                return _Str.substr(0, 1);
-            case unicode_string_view::npos: // no parent path
-                return _Str;
-            default:
-                return _Str.substr(0, _Slash);
+            if (_Slash == unicode_string_view::npos) {
+                return _Root_length == 2 ? _Directory_and_name{_Str.substr(0, 2), _Str.substr(2)}
+                                         : _Directory_and_name{unicode_string_view{L".", 1}, _Str};
             }
+
+            const size_t _Directory_length = _Slash + 1 == _Root_length ? _Slash + 1 : _Slash;
+            return _Directory_and_name{_Str.substr(0, _Directory_length), _Str.substr(_Slash + 1)};
         }
 
-        struct _Path_segment {
-            size_t _Offset;
-            size_t _Length;
+        struct _Path_decomposition { // offsets shared by the filename, stem, extension and parent path
+            size_t _Last_slash; // position of the last slash, npos if there is none
+            size_t _Extension_length; // length of the extension, 0 if there is none
+
+            unicode_string_view _Filename(const unicode_string_view _Str) const noexcept {
+                // Note: A slash at the end means that the path ends with a directory, in that case
+                //       the substring is empty.
+                return _Last_slash == unicode_string_view::npos ? _Str : _Str.substr(_Last_slash + 1);
+            }
+
+            unicode_string_view _Extension(const unicode_string_view _Str) const noexcept {
+                return _Extension_length > 0
+                    ? _Str.substr(_Str.size() - _Extension_length) : unicode_string_view{};
+            }
 
-            bool _Found() const noexcept {
-                return _Offset != unicode_string_view::npos && _Length != 0;
+            unicode_string_view _Stem(const unicode_string_view _Str) const noexcept {
+                const unicode_string_view _Name = _Filename(_Str);
+                return _Name.substr(0, _Name.size() - _Extension_length);
+            }
+
+            unicode_string_view _Parent_path(const unicode_string_view _Str) const noexcept {
+                switch (_Last_slash) {
+                case 0: // root directory is a parent path
+                    return _Str.substr(0, 1);
+                case unicode_string_view::npos: // no parent path
+                    return _Str;
+                default:
+                    return _Str.substr(0, _Last_slash);
+                }
             }
         };
 
-        inline _Path_segment _Find_filename(const unicode_string_view _Str) noexcept {
+        inline _Path_decomposition _Decompose_path(const unicode_string_view _Str) noexcept {
             if (_Str.empty()) {
-                return {unicode_string_view::npos, 0};
+                return _Path_decomposition{unicode_string_view::npos, 0};
             }
 
             const size_t _Slash = _Find_last_slash(_Str);
-            if (_Slash == unicode_string_view::npos) { // the whole path is a filename
-                return {0, _Str.size()};
-            } else if (_Slash == _Str.size() - 1) { // slash at the end means that a path ends with a directory
-                return {unicode_string_view::npos, 0};
-            } else { // found a valid filename
-                return {_Slash + 1, _Str.size() - _Slash - 1};
-            }
-        }
-
-        inline unicode_string_view _Get_filename(const unicode_string_view _Str) noexcept {
-            const _Path_segment& _Filename = _Find_filename(_Str);
-            return _Filename._Found()
-                ? _Str.substr(_Filename._Offset, _Filename._Length) : unicode_string_view{};
+            const size_t _Start = _Slash == unicode_string_view::npos ? 0 : _Slash + 1;
+            return _Path_decomposition{
+                _Slash, _Path_extension_length(_Str.data() + _Start, _Str.size() - _Start)};
         }
 
-        inline unicode_string_view _Get_extension_from_filename(const unicode_string_view _Filename) noexcept {
-            if (_Filename.empty()) {
-                return unicode_string_view{};
-            }
-        
-            if (_Is_dot_or_dot_dot(_Filename)) { // skip special filesystem elements
-                return unicode_string_view{};
-            }
+        // the number of bits used to store a single packed offset
+        inline constexpr size_t _Packed_offset_bits   = 31;
+        inline constexpr uint64_t _Packed_offset_mask = (uint64_t{1} << _Packed_offset_bits) - 1;
+        inline constexpr uint64_t _Packed_parts_valid = uint64_t{1} << 63;
 
-            const size_t _Dot = _Filename.rfind(L'.');
-            return _Dot != unicode_string_view::npos && _Dot != 0
-                ? _Filename.substr(_Dot, _Filename.size() - _Dot) : unicode_string_view{};
+        inline bool _Can_pack_path_decomposition(const size_t _Length) noexcept {
+            return _Length < _Packed_offset_mask; // the slash is stored with a bias of 1
         }
 
-        inline unicode_string_view _Get_extension(const unicode_string_view _Str) noexcept {
-            return _Get_extension_from_filename(_Get_filename(_Str));
+        inline uint64_t _Pack_path_decomposition(const _Path_decomposition& _Parts) noexcept {
+            // Note: The last slash is stored with a bias of 1, so npos becomes 0 and doesn't need
+            //       a separate bit. The valid bit distinguishes the packed value from an empty cache.
+            const uint64_t _Slash = static_cast<uint64_t>(_Parts._Last_slash + 1) & _Packed_offset_mask;
+            return _Packed_parts_valid | _Slash
+                | (static_cast<uint64_t>(_Parts._Extension_length) << _Packed_offset_bits);
         }
 
-        inline unicode_string_view _Get_stem(const unicode_string_view _Str) noexcept {
-            const unicode_string_view _Filename  = _Get_filename(_Str);
-            const unicode_string_view _Extension = _Get_extension_from_filename(_Filename);
-            if (_Filename.empty()) { // no filename so no stem
-                return unicode_string_view{};
-            } else if (_Extension.empty()) { // filename without extension (filename is a stem)
-                return _Filename;
-            } else { // found a valid stem
-                return _Filename.substr(0, _Filename.size() - _Extension.size());
-            }
+        inline _Path_decomposition _Unpack_path_decomposition(const uint64_t _Packed) noexcept {
+            return _Path_decomposition{static_cast<size_t>(_Packed & _Packed_offset_mask) - 1,
+                static_cast<size_t>((_Packed >> _Packed_offset_bits) & _Packed_offset_mask)};
         }
 
         inline size_t _Get_current_path_length() noexcept {
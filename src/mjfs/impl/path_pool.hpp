@@ -0,0 +1,66 @@
+// path_pool.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_PATH_POOL_HPP_
+#define _MJFS_IMPL_PATH_POOL_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/path.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline size_t _Hash_path_node(const uint32_t _Parent, const unicode_string_view _Name) noexcept {
+            _Path_hasher _Hasher(_Parent); // the parent acts as a seed, equal names hash differently
+            return _Narrow_hash(_Hasher._Finish(_Name.data(), _Name.size() * sizeof(wchar_t)));
+        }
+
+        inline bool _Is_unc_device_prefix(const unicode_string_view _Str) noexcept {
+            // checks whether the path after "\\?\" starts with "UNC\" (case-insensitive)
+            return _Str.size() >= 4 && (_Str[0] == L'U' || _Str[0] == L'u')
+                && (_Str[1] == L'N' || _Str[1] == L'n') && (_Str[2] == L'C' || _Str[2] == L'c')
+                && _Is_slash(_Str[3]);
+        }
+
+        inline unicode_string_view _Get_pool_root_name(const unicode_string_view _Str) noexcept {
+            // Note: A UNC path keeps "\\server\share" and a device path keeps "\\?\X:", "\\?\Volume{...}"
+            //       or "\\?\UNC\server\share" as its root name, otherwise the root name is the drive.
+            if (_Str.size() < 2 || !_Is_slash(_Str[0]) || !_Is_slash(_Str[1])) {
+                return _Get_root_name(_Str);
+            }
+
+            size_t _End        = 2;
+            size_t _Components = 2; // the server and the share
+            if (_Str.size() >= 4 && (_Str[2] == L'?' || _Str[2] == L'.') && _Is_slash(_Str[3])) {
+                _End        = 4;
+                _Components = _Is_unc_device_prefix(_Str.substr(4)) ? 3 : 1;
+            }
+
+            for (size_t _Count = 0; _Count < _Components && _End < _Str.size(); ++_Count) {
+                if (_Count != 0) { // skip the separator between the components
+                    ++_End;
+                }
+
+                while (_End < _Str.size() && !_Is_slash(_Str[_End])) {
+                    ++_End;
+                }
+            }
+
+            return _Str.substr(0, _End);
+        }
+
+        inline bool _Needs_path_separator(
+            const unicode_string_view _Parent, const unicode_string_view _Name) noexcept {
+            // Note: No separator is inserted after a root directory, before a root directory
+            //       or after a root name, so "C:foo" stays relative to the drive.
+            const wchar_t _Last = _Parent[_Parent.size() - 1];
+            return !_Is_slash(_Last) && _Last != L':' && !_Is_slash(_Name[0]);
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_PATH_POOL_HPP_
@@ -0,0 +1,297 @@
+// remove_all.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_REMOVE_ALL_HPP_
+#define _MJFS_IMPL_REMOVE_ALL_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mjfs/directory.hpp>
+#include <mjfs/impl/directory.hpp>
+#include <mjfs/impl/parallel.hpp>
+#include <mjfs/impl/path.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/impl/work_queue.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline bool _Is_missing_file_error(const unsigned long _Error) noexcept {
+            return _Error == ERROR_FILE_NOT_FOUND || _Error == ERROR_PATH_NOT_FOUND;
+        }
+
+        inline bool _Is_directory_not_link(const unsigned long _Attributes) noexcept {
+            return (_Attributes & FILE_ATTRIBUTE_DIRECTORY) != 0
+                && (_Attributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0;
+        }
+
+        inline bool _Remove_tree_leaf(const wchar_t* const _Target, const unsigned long _Attributes) noexcept {
+            // Note: Links to directories are removed like empty directories, so their targets are kept.
+            //       The read-only attribute is known from the enumeration, so it costs no extra call
+            //       unless it's set.
+            if ((_Attributes & FILE_ATTRIBUTE_READONLY) != 0) {
+                ::SetFileAttributesW(
+                    _Target, _Attributes & ~static_cast<unsigned long>(FILE_ATTRIBUTE_READONLY));
+            }
+
+            if ((_Attributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+                return ::RemoveDirectoryW(_Target) != 0;
+            } else {
+                return ::DeleteFileW(_Target) != 0;
+            }
+        }
+
+        struct _Remove_node { // a directory whose entries are being removed
+            path _Dir;
+            _Remove_node* _Parent;
+            unsigned long _Attributes;
+
+            // the subdirectories that are not removed yet, plus one until the directory is enumerated
+            ::std::atomic<size_t> _Pending;
+
+            _Remove_node(path&& _Dir, _Remove_node* const _Parent, const unsigned long _Attributes) noexcept
+                : _Dir(::std::move(_Dir)), _Parent(_Parent), _Attributes(_Attributes), _Pending(1) {}
+        };
+
+        class _Tree_remover { // removes a directory tree, the files are removed by multiple threads
+        public:
+            _Tree_remover() noexcept : _Mymtx(), _Mynodes(), _Myqueue(), _Myfiles(0), _Mydirs(0), _Myerror() {}
+
+            _Tree_remover(const _Tree_remover&)            = delete;
+            _Tree_remover& operator=(const _Tree_remover&) = delete;
+
+            bool _Remove(const path& _Target, remove_all_stats& _Stats) {
+                const unsigned long _Attributes = ::GetFileAttributesW(_Target.c_str());
+                if (_Attributes == INVALID_FILE_ATTRIBUTES) {
+                    const unsigned long _Error = ::GetLastError();
+                    if (!_Is_missing_file_error(_Error)) { // nothing to remove otherwise
+                        _Myerror._Set(_Target, _Error);
+                    }
+                } else if (!_Is_directory_not_link(_Attributes)) { // a file or a link, remove it directly
+                    if (_Remove_tree_leaf(_Target.c_str(), _Attributes)) {
+                        _Count_removed(_Attributes);
+                    } else {
+                        _Myerror._Set(_Target, ::GetLastError());
+                    }
+                } else {
+                    _Remove_tree(_Target, _Attributes);
+                }
+
+                _Stats.removed_files       = _Myfiles.load(::std::memory_order_relaxed);
+                _Stats.removed_directories = _Mydirs.load(::std::memory_order_relaxed);
+                _Myerror._Report(_Stats.error, _Stats.failed_path);
+                return _Stats.error == 0;
+            }
+
+        private:
+            void _Remove_tree(const path& _Root, const unsigned long _Attributes) {
+                // Note: The root is enumerated by the calling thread before any thread is started,
+                //       so a directory without subdirectories is removed without starting threads.
+                _Mynodes.emplace_back(path{_Root}, nullptr, _Attributes);
+                _Myqueue._Begin();
+                _Process(&_Mynodes.back());
+                if (_Myqueue._Finish_one()) {
+                    return;
+                }
+
+                const size_t _Workers = _Get_worker_count(_Max_worker_count);
+                _Thread_group _Group;
+                if (_Workers > 1) {
+                    _Group._Start(_Workers - 1, [this] { _Work(); });
+                }
+
+                _Group._Run([this] { _Work(); });
+                _Group._Join();
+            }
+
+            void _Work() {
+                _Myqueue._Work([this](_Remove_node* const _Node) { _Process(_Node); });
+            }
+
+            void _Process(_Remove_node* const _Node) {
+                // Note: Win32 has no equivalent of unlinkat(), so each entry is removed by its full path.
+                //       The files are removed while the directory is being enumerated, only the paths
+                //       of its subdirectories are kept.
+                ::std::vector<::std::pair<path, unsigned long>> _Subdirs;
+                const auto _Func = [this, _Node, &_Subdirs](
+                    const unicode_string_view _Name, const FILE_FULL_DIR_INFO& _Info) {
+                    path _Entry = _Node->_Dir / _Name;
+                    if (_Is_directory_not_link(_Info.FileAttributes)) {
+                        _Subdirs.emplace_back(::std::move(_Entry), _Info.FileAttributes);
+                    } else if (_Remove_tree_leaf(_Entry.c_str(), _Info.FileAttributes)) {
+                        _Count_removed(_Info.FileAttributes);
+                    } else {
+                        _Myerror._Set(_Entry, ::GetLastError());
+                    }
+                };
+                if (!_For_each_directory_info<FILE_FULL_DIR_INFO>(
+                    _Node->_Dir.c_str(), FileFullDirectoryInfo, _Func)) {
+                    _Myerror._Set(_Node->_Dir, ::GetLastError());
+                }
+
+                if (!_Subdirs.empty()) {
+                    _Node->_Pending.fetch_add(_Subdirs.size(), ::std::memory_order_relaxed);
+                    ::std::vector<_Remove_node*> _Children;
+                    _Children.reserve(_Subdirs.size());
+                    {
+                        ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                        for (auto& _Subdir : _Subdirs) {
+                            _Mynodes.emplace_back(::std::move(_Subdir.first), _Node, _Subdir.second);
+                            _Children.push_back(&_Mynodes.back());
+                        }
+                    }
+
+                    _Myqueue._Push(_Children);
+                }
+
+                _Release(_Node);
+            }
+
+            void _Release(_Remove_node* _Node) {
+                // removes the directories that have no pending subdirectories, from the bottom up
+                while (_Node != nullptr && _Node->_Pending.fetch_sub(1, ::std::memory_order_acq_rel) == 1) {
+                    if (_Remove_tree_leaf(_Node->_Dir.c_str(), _Node->_Attributes)) {
+                        _Count_removed(_Node->_Attributes);
+                    } else {
+                        _Myerror._Set(_Node->_Dir, ::GetLastError());
+                    }
+
+                    _Node = _Node->_Parent;
+                }
+            }
+
+            void _Count_removed(const unsigned long _Attributes) noexcept {
+                if ((_Attributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+                    _Mydirs.fetch_add(1, ::std::memory_order_relaxed);
+                } else {
+                    _Myfiles.fetch_add(1, ::std::memory_order_relaxed);
+                }
+            }
+
+            ::std::mutex _Mymtx; // guards the nodes
+            ::std::deque<_Remove_node> _Mynodes; // the nodes must not move, the children point to them
+            _Work_queue<_Remove_node*> _Myqueue;
+            ::std::atomic<uint64_t> _Myfiles;
+            ::std::atomic<uint64_t> _Mydirs;
+            _First_error _Myerror;
+        };
+
+        inline void _Append_hex(path::string_type& _Str, uint64_t _Value) {
+            wchar_t _Buf[16];
+            wchar_t* _Ptr = _Buf + 16;
+            do {
+                *--_Ptr = L"0123456789abcdef"[_Value & 0xF];
+                _Value >>= 4;
+            } while (_Value != 0);
+
+            _Str.append(_Ptr, static_cast<size_t>(_Buf + 16 - _Ptr));
+        }
+
+        inline bool _Move_to_trash(const path& _Target, path& _Trash) {
+            // Note: The target is renamed within its parent directory, so the rename is atomic and never
+            //       copies the data. The name is made unique by a counter and the current tick count.
+            static ::std::atomic<uint64_t> _Counter(0);
+            path::string_type _Str = _Target.native();
+            while (!_Str.empty() && _Is_slash(_Str.back())) {
+                _Str.pop_back();
+            }
+
+            if (_Str.empty()) {
+                return false;
+            }
+
+            const uint64_t _Tick = ::GetTickCount64();
+            for (int _Attempt = 0; _Attempt < 4; ++_Attempt) {
+                path::string_type _Name = _Str;
+                _Name += L".~remove-";
+                _Append_hex(_Name, _Counter.fetch_add(1, ::std::memory_order_relaxed));
+                _Name += L'-';
+                _Append_hex(_Name, _Tick);
+                if (::MoveFileExW(_Str.c_str(), _Name.c_str(), 0) != 0) {
+                    _Trash = ::std::move(_Name);
+                    return true;
+                }
+
+                const unsigned long _Error = ::GetLastError();
+                if (_Error != ERROR_ALREADY_EXISTS && _Error != ERROR_FILE_EXISTS) { // not a name collision
+                    return false;
+                }
+            }
+
+            return false;
+        }
+
+        class _Background_removal { // removes a tree on a separate thread, the thread is joined on destruction
+        public:
+            _Background_removal() noexcept : _Mythread(), _Mystats(), _Myresult(true), _Myexception() {}
+
+            ~_Background_removal() noexcept {
+                _Join();
+            }
+
+            _Background_removal(const _Background_removal&)            = delete;
+            _Background_removal& operator=(const _Background_removal&) = delete;
+
+            void _Start(path&& _Trash) {
+                _Mythread = ::std::thread([this, _Trash = ::std::move(_Trash)] {
+                    // Note: An exception must not leave the thread, since that terminates the process.
+                    //       It's kept and rethrown by _Wait() on the waiting thread.
+                    try {
+                        _Myresult = _Tree_remover{}._Remove(_Trash, _Mystats);
+                    } catch (...) {
+                        _Myresult    = false;
+                        _Myexception = ::std::current_exception();
+                    }
+                });
+            }
+
+            void _Remove_now(const path& _Target) {
+                // used if the target cannot be renamed, the result is kept for _Wait()
+                _Myresult = _Tree_remover{}._Remove(_Target, _Mystats);
+            }
+
+            bool _Pending() const noexcept {
+                return _Mythread.joinable();
+            }
+
+            bool _Wait(remove_all_stats* const _Stats) {
+                _Join();
+                if (_Myexception != nullptr) { // rethrown once, a later wait reports only the result
+                    ::std::exception_ptr _Exception = ::std::move(_Myexception);
+                    _Myexception                    = nullptr;
+                    ::std::rethrow_exception(_Exception);
+                }
+
+                if (_Stats != nullptr) {
+                    *_Stats = _Mystats;
+                }
+
+                return _Myresult;
+            }
+
+        private:
+            void _Join() noexcept {
+                if (_Mythread.joinable()) {
+                    _Mythread.join();
+                }
+            }
+
+            ::std::thread _Mythread;
+            remove_all_stats _Mystats;
+            bool _Myresult;
+            ::std::exception_ptr _Myexception; // thrown by the removal thread
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_REMOVE_ALL_HPP_
@@ -0,0 +1,177 @@
+// space_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_SPACE_CACHE_HPP_
+#define _MJFS_IMPL_SPACE_CACHE_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/status.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
+#include <mjfs/status.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline bool _Get_volume_path(const path& _Target, unicode_string& _Volume) {
+            // Note: The volume path is never longer than the full path, which is the current directory
+            //       followed by the target in the worst case.
+            ::std::vector<wchar_t> _Buf(_Target.native().size() + MAX_PATH + 1);
+            const unsigned long _Size = static_cast<unsigned long>(_Buf.size());
+            if (::GetVolumePathNameW(_Target.c_str(), _Buf.data(), _Size) == 0) {
+                return false;
+            }
+
+            _Volume = unicode_string{_Buf.data()};
+            return true;
+        }
+
+        struct _Volume_space { // the last known space of a volume
+            unicode_string _Volume;
+            ::std::atomic<uint64_t> _Capacity{0};
+            ::std::atomic<uint64_t> _Free{0};
+            ::std::atomic<uint64_t> _Available{0};
+            ::std::atomic<uint64_t> _Updated_at{0}; // the tick count of the last query, 0 if never queried
+            ::std::atomic<uint64_t> _Reserved{0}; // the sum of the active reservations
+
+            explicit _Volume_space(unicode_string&& _Volume_path) noexcept
+                : _Volume(::std::move(_Volume_path)) {}
+
+            _Volume_space(const _Volume_space&)            = delete;
+            _Volume_space& operator=(const _Volume_space&) = delete;
+        };
+
+        class _Space_cache {
+        public:
+            // the maximum number of remembered targets, the mapping is forgotten above that
+            static constexpr size_t _Max_target_count = 4096;
+
+            explicit _Space_cache(const uint64_t _Max_age) noexcept
+                : _Mymtx(), _Mymax_age(_Max_age), _Myvolumes(), _Myvolume_ids(), _Mytargets() {}
+
+            _Space_cache(const _Space_cache&)            = delete;
+            _Space_cache& operator=(const _Space_cache&) = delete;
+
+            smart_ptr<_Volume_space> _Find_volume(const path& _Target) {
+                {
+                    ::std::shared_lock<::std::shared_mutex> _Guard(_Mymtx);
+                    const auto _Iter = _Mytargets.find(_Target.native());
+                    if (_Iter != _Mytargets.end()) {
+                        return _Iter->second;
+                    }
+                }
+
+                unicode_string _Volume;
+                if (!_Get_volume_path(_Target, _Volume)) {
+                    return smart_ptr<_Volume_space>{};
+                }
+
+                ::std::unique_lock<::std::shared_mutex> _Guard(_Mymtx);
+                smart_ptr<_Volume_space> _Space;
+                const auto _Iter = _Myvolume_ids.find(_Volume);
+                if (_Iter != _Myvolume_ids.end()) {
+                    _Space = _Myvolumes[_Iter->second];
+                } else { // a new volume, volumes are never removed from the cache
+                    _Myvolumes.push_back(::mjx::make_smart_ptr<_Volume_space>(unicode_string{_Volume}));
+                    _Myvolume_ids.emplace(::std::move(_Volume), _Myvolumes.size() - 1);
+                    _Space = _Myvolumes.back();
+                }
+
+                if (_Mytargets.size() >= _Max_target_count) {
+                    _Mytargets.clear();
+                }
+
+                _Mytargets.emplace(_Target.native(), _Space);
+                return _Space;
+            }
+
+            bool _Is_stale(const _Volume_space& _Space, const uint64_t _Now) const noexcept {
+                const uint64_t _Updated_at = _Space._Updated_at.load(::std::memory_order_acquire);
+                return _Updated_at == 0 || _Now - _Updated_at >= _Mymax_age;
+            }
+
+            static void _Refresh(_Volume_space& _Space) noexcept {
+                // Note: Concurrent refreshes of the same volume are harmless, each of them stores values
+                //       that were valid at some point, so no lock is needed.
+                space_info _Info;
+                if (!_Get_disk_space_info(_Space._Volume.c_str(), _Info)) {
+                    _Info = space_info{0, 0, 0};
+                }
+
+                _Space._Capacity.store(_Info.capacity, ::std::memory_order_relaxed);
+                _Space._Free.store(_Info.free, ::std::memory_order_relaxed);
+                _Space._Available.store(_Info.available, ::std::memory_order_relaxed);
+                const uint64_t _Now = static_cast<uint64_t>(::GetTickCount64());
+                _Space._Updated_at.store((::std::max)(_Now, uint64_t{1}), ::std::memory_order_release);
+            }
+
+            space_info _Get_space(_Volume_space& _Space) noexcept {
+                if (_Is_stale(_Space, ::GetTickCount64())) {
+                    _Refresh(_Space);
+                }
+
+                return _Get_cached_space(_Space);
+            }
+
+            static space_info _Get_cached_space(const _Volume_space& _Space) noexcept {
+                const uint64_t _Reserved  = _Space._Reserved.load(::std::memory_order_relaxed);
+                const uint64_t _Free      = _Space._Free.load(::std::memory_order_relaxed);
+                const uint64_t _Available = _Space._Available.load(::std::memory_order_relaxed);
+                return space_info{_Space._Capacity.load(::std::memory_order_relaxed),
+                    _Free > _Reserved ? _Free - _Reserved : 0,
+                    _Available > _Reserved ? _Available - _Reserved : 0};
+            }
+
+            bool _Try_reserve(_Volume_space& _Space, const uint64_t _Size, const uint64_t _Headroom) noexcept {
+                if (_Is_stale(_Space, ::GetTickCount64())) {
+                    _Refresh(_Space);
+                }
+
+                const uint64_t _Available = _Space._Available.load(::std::memory_order_relaxed);
+                uint64_t _Reserved        = _Space._Reserved.load(::std::memory_order_relaxed);
+                do {
+                    if (_Available < _Headroom || _Available - _Headroom < _Reserved
+                        || _Available - _Headroom - _Reserved < _Size) { // not enough space
+                        return false;
+                    }
+                } while (!_Space._Reserved.compare_exchange_weak(_Reserved, _Reserved + _Size,
+                    ::std::memory_order_relaxed, ::std::memory_order_relaxed));
+                return true;
+            }
+
+            void _Invalidate() noexcept {
+                ::std::shared_lock<::std::shared_mutex> _Guard(_Mymtx);
+                for (const smart_ptr<_Volume_space>& _Space : _Myvolumes) {
+                    _Space->_Updated_at.store(0, ::std::memory_order_release);
+                }
+            }
+
+        private:
+            mutable ::std::shared_mutex _Mymtx;
+            uint64_t _Mymax_age;
+            // Note: The volumes are shared with the reservations made on them, so a reservation may
+            //       outlive the cache and still release its space safely.
+            ::std::vector<smart_ptr<_Volume_space>> _Myvolumes;
+            ::std::unordered_map<unicode_string, size_t, _Insensitive_string_hash,
+                _Insensitive_string_equal> _Myvolume_ids; // maps the volume paths to their positions
+            ::std::unordered_map<unicode_string, smart_ptr<_Volume_space>, _Insensitive_string_hash,
+                _Insensitive_string_equal> _Mytargets; // maps the queried paths to their volumes
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_SPACE_CACHE_HPP_
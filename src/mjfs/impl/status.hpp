@@ -6,12 +6,21 @@
 #pragma once
 #ifndef _MJFS_IMPL_STATUS_HPP_
 #define _MJFS_IMPL_STATUS_HPP_
+#include <cstddef>
 #include <cstdint>
 #include <mjfs/bitmask.hpp>
 #include <mjfs/directory.hpp>
 #include <mjfs/impl/file.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/parallel.hpp>
+#include <mjfs/impl/path.hpp>
 #include <mjfs/impl/tinywin.hpp>
 #include <mjfs/status.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 namespace mjx {
     namespace mjfs_impl {
@@ -50,6 +59,216 @@ namespace mjx {
             }
         }
 
+        inline uint64_t _Make_uint64(const unsigned long _High, const unsigned long _Low) noexcept {
+            return (static_cast<uint64_t>(_High) << 32) | _Low;
+        }
+
+        inline file_type _Get_file_type(
+            const file_attribute _Attributes, const _File_reparse_tag _Tag) noexcept {
+            if (_Has_bits(_Attributes, file_attribute::reparse_point)) {
+                switch (_Tag) {
+                case _File_reparse_tag::_Symlink:
+                    return file_type::symlink;
+                case _File_reparse_tag::_Mount_point:
+                    return file_type::junction;
+                default: // other reparse points (e.g. cloud files) are classified by their attributes
+                    break;
+                }
+            }
+
+            if (_Has_bits(_Attributes, file_attribute::directory)) {
+                return file_type::directory;
+            } else {
+                return file_type::regular;
+            }
+        }
+
+        inline file_status _Get_failed_status() noexcept {
+            switch (::GetLastError()) {
+            case ERROR_FILE_NOT_FOUND:
+            case ERROR_PATH_NOT_FOUND:
+            case ERROR_INVALID_NAME:
+            case ERROR_BAD_NETPATH:
+                return file_status{file_type::not_found, file_attribute::unknown, 0, 0, 0, 0};
+            default:
+                return file_status{file_type::none, file_attribute::unknown, 0, 0, 0, 0};
+            }
+        }
+
+        inline file_status _Get_status_from_attribute_data(
+            const WIN32_FILE_ATTRIBUTE_DATA& _Data, const _File_reparse_tag _Tag) noexcept {
+            const file_attribute _Attributes = static_cast<file_attribute>(_Data.dwFileAttributes);
+            return file_status{_Get_file_type(_Attributes, _Tag), _Attributes,
+                _Make_uint64(_Data.nFileSizeHigh, _Data.nFileSizeLow),
+                _Make_uint64(_Data.ftCreationTime.dwHighDateTime, _Data.ftCreationTime.dwLowDateTime),
+                _Make_uint64(_Data.ftLastAccessTime.dwHighDateTime, _Data.ftLastAccessTime.dwLowDateTime),
+                _Make_uint64(_Data.ftLastWriteTime.dwHighDateTime, _Data.ftLastWriteTime.dwLowDateTime)};
+        }
+
+        inline file_status _Get_symlink_status(const wchar_t* const _Target) noexcept {
+            WIN32_FILE_ATTRIBUTE_DATA _Data;
+            if (::GetFileAttributesExW(_Target, GetFileExInfoStandard, &_Data) == 0) {
+                return _Get_failed_status();
+            }
+
+            // Note: GetFileAttributesExW() doesn't follow reparse points, so the attributes describe
+            //       the link itself. Only reparse points require a second query, which reads the tag
+            //       to distinguish symbolic links from junctions.
+            const _File_reparse_tag _Tag = (_Data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0
+                ? _Get_reparse_tag(_Target) : _File_reparse_tag::_Unknown;
+            return _Get_status_from_attribute_data(_Data, _Tag);
+        }
+
+        inline file_status _Get_status(const wchar_t* const _Target, bool& _Followed) noexcept {
+            // Note: The reparse tag is not needed, since the link is followed, so a reparse point costs
+            //       one more query that opens its target, and any other file costs only one query.
+            WIN32_FILE_ATTRIBUTE_DATA _Data;
+            if (::GetFileAttributesExW(_Target, GetFileExInfoStandard, &_Data) == 0) {
+                return _Get_failed_status();
+            }
+
+            _Followed = (_Data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+            if (!_Followed) { // nothing to follow
+                return _Get_status_from_attribute_data(_Data, _File_reparse_tag::_Unknown);
+            }
+
+            // the system resolves the reparse point, since FILE_FLAG_OPEN_REPARSE_POINT is not specified
+            _Close_handle_guard _Guard = {::CreateFileW(_Target, FILE_READ_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+            BY_HANDLE_FILE_INFORMATION _Info;
+            if (!_Guard._Holds_valid_handle() || ::GetFileInformationByHandle(_Guard._Handle, &_Info) == 0) {
+                return _Get_failed_status(); // broken link
+            }
+
+            const file_attribute _Attributes = static_cast<file_attribute>(_Info.dwFileAttributes);
+            return file_status{_Get_file_type(_Attributes, _File_reparse_tag::_Unknown), _Attributes,
+                _Make_uint64(_Info.nFileSizeHigh, _Info.nFileSizeLow),
+                _Make_uint64(_Info.ftCreationTime.dwHighDateTime, _Info.ftCreationTime.dwLowDateTime),
+                _Make_uint64(_Info.ftLastAccessTime.dwHighDateTime, _Info.ftLastAccessTime.dwLowDateTime),
+                _Make_uint64(_Info.ftLastWriteTime.dwHighDateTime, _Info.ftLastWriteTime.dwLowDateTime)};
+        }
+
+        inline file_status _Get_status(const wchar_t* const _Target) noexcept {
+            bool _Followed;
+            return _Get_status(_Target, _Followed);
+        }
+
+        inline file_status _Get_status_from_find_data(const WIN32_FIND_DATAW& _Data) noexcept {
+            // Note: The find data describes the entry itself, as symlink_status() does. For reparse points,
+            //       the reserved field holds the reparse tag, so no further query is needed.
+            const file_attribute _Attributes = static_cast<file_attribute>(_Data.dwFileAttributes);
+            const _File_reparse_tag _Tag     = _Has_bits(_Attributes, file_attribute::reparse_point)
+                ? static_cast<_File_reparse_tag>(_Data.dwReserved0) : _File_reparse_tag::_Unknown;
+            return file_status{_Get_file_type(_Attributes, _Tag), _Attributes,
+                _Make_uint64(_Data.nFileSizeHigh, _Data.nFileSizeLow),
+                _Make_uint64(_Data.ftCreationTime.dwHighDateTime, _Data.ftCreationTime.dwLowDateTime),
+                _Make_uint64(_Data.ftLastAccessTime.dwHighDateTime, _Data.ftLastAccessTime.dwLowDateTime),
+                _Make_uint64(_Data.ftLastWriteTime.dwHighDateTime, _Data.ftLastWriteTime.dwLowDateTime)};
+        }
+
+        // groups with fewer paths are queried path by path instead of enumerating the directory
+        inline constexpr size_t _Status_enumeration_threshold = 16;
+
+        struct _Status_group { // paths that share the containing directory
+            unicode_string_view _Directory;
+            ::std::vector<size_t> _Indices;
+        };
+
+        inline file_status _Load_status(const path& _Target, const bool _Follow) noexcept {
+            return _Follow ? _Get_status(_Target.c_str()) : _Get_symlink_status(_Target.c_str());
+        }
+
+        inline void _Load_status_group(const ::std::span<const path> _Targets,
+            const ::std::span<file_status> _Statuses, const _Status_group& _Group, const bool _Follow) {
+            ::std::unordered_multimap<unicode_string_view, size_t, _Insensitive_string_hash,
+                _Insensitive_string_equal> _Names;
+            _Names.reserve(_Group._Indices.size());
+            for (const size_t _Idx : _Group._Indices) {
+                const unicode_string_view _Name = _Split_directory_and_name(_Targets[_Idx].native())._Name;
+                if (_Name.empty() || _Is_dot_or_dot_dot(_Name)) { // not listed in the directory
+                    _Statuses[_Idx] = _Load_status(_Targets[_Idx], _Follow);
+                } else {
+                    _Statuses[_Idx].type = file_type::none; // marks the path as not listed yet
+                    _Names.emplace(_Name, _Idx);
+                }
+            }
+
+            // Note: A bare drive ("X:") stands for the current directory of that drive, so the pattern
+            //       is "X:*", a separator would make it list the root of the drive instead.
+            unicode_string _Pattern(_Group._Directory.data(), _Group._Directory.size());
+            const bool _Bare_drive = _Pattern.size() == 2 && _Has_drive(_Pattern);
+            if (!_Pattern.empty() && !_Is_slash(_Pattern.back()) && !_Bare_drive) {
+                _Pattern.push_back(L'\\');
+            }
+
+            _Pattern.push_back(L'*');
+            WIN32_FIND_DATAW _Data;
+            void* const _Handle = ::FindFirstFileExW(_Pattern.c_str(), FindExInfoBasic, &_Data,
+                FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+            if (_Handle != INVALID_HANDLE_VALUE) {
+                do {
+                    const auto _Range = _Names.equal_range(unicode_string_view{_Data.cFileName});
+                    for (auto _Iter = _Range.first; _Iter != _Range.second; ++_Iter) {
+                        _Statuses[_Iter->second] = _Get_status_from_find_data(_Data);
+                    }
+                } while (::FindNextFileW(_Handle, &_Data) != 0);
+
+                ::FindClose(_Handle);
+            } else if (::GetLastError() == ERROR_PATH_NOT_FOUND) { // none of the paths exists
+                for (const auto& _Pair : _Names) {
+                    _Statuses[_Pair.second] =
+                        file_status{file_type::not_found, file_attribute::unknown, 0, 0, 0, 0};
+                }
+
+                return;
+            }
+
+            // Note: A path that wasn't listed is queried directly, so that short (8.3) names, names that
+            //       differ only by characters the folding doesn't cover and unlistable directories still
+            //       get the exact result. Reparse points are followed the same way as in status().
+            for (const auto& _Pair : _Names) {
+                file_status& _Status = _Statuses[_Pair.second];
+                if (_Status.type == file_type::none
+                    || (_Follow && _Has_bits(_Status.attributes, file_attribute::reparse_point))) {
+                    _Status = _Load_status(_Targets[_Pair.second], _Follow);
+                }
+            }
+        }
+
+        inline bool _Get_status_batch(const ::std::span<const path> _Targets,
+            const ::std::span<file_status> _Statuses, const bool _Follow) {
+            if (_Targets.size() != _Statuses.size()) {
+                return false;
+            }
+
+            // group the paths by their containing directory, so that each directory is enumerated once
+            ::std::unordered_map<unicode_string_view, size_t, _Insensitive_string_hash,
+                _Insensitive_string_equal> _Ids;
+            ::std::vector<_Status_group> _Groups;
+            for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+                const unicode_string_view _Dir = _Split_directory_and_name(_Targets[_Idx].native())._Directory;
+                const auto _Result             = _Ids.try_emplace(_Dir, _Groups.size());
+                if (_Result.second) { // a new directory
+                    _Groups.push_back(_Status_group{_Dir, {}});
+                }
+
+                _Groups[_Result.first->second]._Indices.push_back(_Idx);
+            }
+
+            _Parallel_for(_Groups.size(), [&](const size_t _Idx) {
+                const _Status_group& _Group = _Groups[_Idx];
+                if (_Group._Indices.size() >= _Status_enumeration_threshold) {
+                    _Load_status_group(_Targets, _Statuses, _Group, _Follow);
+                } else {
+                    for (const size_t _Target_idx : _Group._Indices) {
+                        _Statuses[_Target_idx] = _Load_status(_Targets[_Target_idx], _Follow);
+                    }
+                }
+            });
+            return true;
+        }
+
         inline bool _Get_disk_space_info(const wchar_t* const _Disk, space_info& _Info) noexcept {
             ULARGE_INTEGER _Available;
             ULARGE_INTEGER _Capacity;
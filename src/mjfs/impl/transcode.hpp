@@ -0,0 +1,260 @@
+// transcode.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_TRANSCODE_HPP_
+#define _MJFS_IMPL_TRANSCODE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <emmintrin.h>
+#include <intrin.h>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline size_t _Count_leading_ascii(const unsigned char* const _First, const size_t _Count) noexcept {
+            // checks 16 bytes at once, a non-zero sign mask means that the block contains a non-ASCII byte
+            size_t _Off = 0;
+            for (; _Off + 16 <= _Count; _Off += 16) {
+                const __m128i _Block = ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First + _Off));
+                const int _Mask      = ::_mm_movemask_epi8(_Block);
+                if (_Mask != 0) {
+                    unsigned long _Bit;
+                    ::_BitScanForward(&_Bit, static_cast<unsigned long>(_Mask));
+                    return _Off + _Bit;
+                }
+            }
+
+            while (_Off < _Count && _First[_Off] < 0x80) {
+                ++_Off;
+            }
+
+            return _Off;
+        }
+
+        inline size_t _Count_leading_ascii(const wchar_t* const _First, const size_t _Count) noexcept {
+            // checks 8 code units at once, any bit above the lowest 7 means a non-ASCII code unit
+            const __m128i _Non_ascii_bits = ::_mm_set1_epi16(static_cast<short>(0xFF80));
+            const __m128i _Zero           = ::_mm_setzero_si128();
+            size_t _Off                   = 0;
+            for (; _Off + 8 <= _Count; _Off += 8) {
+                const __m128i _Block = ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First + _Off));
+                const int _Mask      = ::_mm_movemask_epi8(
+                    ::_mm_cmpeq_epi16(::_mm_and_si128(_Block, _Non_ascii_bits), _Zero));
+                if (_Mask != 0xFFFF) {
+                    unsigned long _Bit;
+                    ::_BitScanForward(&_Bit, static_cast<unsigned long>(~_Mask & 0xFFFF));
+                    return _Off + _Bit / 2; // each code unit has 2 bits in the mask
+                }
+            }
+
+            while (_Off < _Count && static_cast<uint16_t>(_First[_Off]) < 0x80) {
+                ++_Off;
+            }
+
+            return _Off;
+        }
+
+        inline bool _Is_utf8_continuation(const unsigned char _Ch) noexcept {
+            return (_Ch & 0xC0) == 0x80;
+        }
+
+        inline size_t _Decode_utf8_sequence(
+            const unsigned char* const _First, const size_t _Count, uint32_t& _Code_point) noexcept {
+            // Note: Decodes a single non-ASCII sequence and returns its size, or 0 if it is invalid.
+            //       Overlong forms, surrogates and code points above U+10FFFF are rejected,
+            //       the ranges of the second byte follow the Unicode well-formed byte sequences table.
+            const unsigned char _Lead = _First[0];
+            if (_Lead >= 0xC2 && _Lead <= 0xDF) {
+                if (_Count < 2 || !_Is_utf8_continuation(_First[1])) {
+                    return 0;
+                }
+
+                _Code_point = (static_cast<uint32_t>(_Lead & 0x1F) << 6) | (_First[1] & 0x3F);
+                return 2;
+            } else if (_Lead >= 0xE0 && _Lead <= 0xEF) {
+                if (_Count < 3 || !_Is_utf8_continuation(_First[1]) || !_Is_utf8_continuation(_First[2])) {
+                    return 0;
+                }
+
+                if ((_Lead == 0xE0 && _First[1] < 0xA0) || (_Lead == 0xED && _First[1] > 0x9F)) {
+                    return 0; // overlong form or a surrogate
+                }
+
+                _Code_point = (static_cast<uint32_t>(_Lead & 0x0F) << 12)
+                    | (static_cast<uint32_t>(_First[1] & 0x3F) << 6) | (_First[2] & 0x3F);
+                return 3;
+            } else if (_Lead >= 0xF0 && _Lead <= 0xF4) {
+                if (_Count < 4 || !_Is_utf8_continuation(_First[1])
+                    || !_Is_utf8_continuation(_First[2]) || !_Is_utf8_continuation(_First[3])) {
+                    return 0;
+                }
+
+                if ((_Lead == 0xF0 && _First[1] < 0x90) || (_Lead == 0xF4 && _First[1] > 0x8F)) {
+                    return 0; // overlong form or a code point above U+10FFFF
+                }
+
+                _Code_point = (static_cast<uint32_t>(_Lead & 0x07) << 18)
+                    | (static_cast<uint32_t>(_First[1] & 0x3F) << 12)
+                    | (static_cast<uint32_t>(_First[2] & 0x3F) << 6) | (_First[3] & 0x3F);
+                return 4;
+            } else { // unexpected continuation byte or invalid lead byte
+                return 0;
+            }
+        }
+
+        inline bool _Utf8_to_utf16_length(
+            const char* const _Str, const size_t _Count, size_t& _Length) noexcept {
+            // validates the input and computes the number of UTF-16 code units it requires
+            const unsigned char* const _Data = reinterpret_cast<const unsigned char*>(_Str);
+            size_t _Off                      = 0;
+            size_t _Result                   = 0;
+            while (_Off < _Count) {
+                const size_t _Ascii = _Count_leading_ascii(_Data + _Off, _Count - _Off);
+                _Off    += _Ascii;
+                _Result += _Ascii;
+                if (_Off == _Count) {
+                    break;
+                }
+
+                uint32_t _Code_point;
+                const size_t _Size = _Decode_utf8_sequence(_Data + _Off, _Count - _Off, _Code_point);
+                if (_Size == 0) {
+                    return false;
+                }
+
+                _Off    += _Size;
+                _Result += _Code_point >= 0x10000 ? 2 : 1; // supplementary planes require a surrogate pair
+            }
+
+            _Length = _Result;
+            return true;
+        }
+
+        inline void _Utf8_to_utf16(const char* const _Str, const size_t _Count, wchar_t* _Dest) noexcept {
+            // converts the input, which must be already validated by _Utf8_to_utf16_length()
+            const unsigned char* const _Data = reinterpret_cast<const unsigned char*>(_Str);
+            const __m128i _Zero              = ::_mm_setzero_si128();
+            size_t _Off                      = 0;
+            while (_Off < _Count) {
+                for (; _Off + 16 <= _Count; _Off += 16, _Dest += 16) { // widen 16 ASCII bytes at once
+                    const __m128i _Block = ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Data + _Off));
+                    if (::_mm_movemask_epi8(_Block) != 0) {
+                        break;
+                    }
+
+                    __m128i* const _Target = reinterpret_cast<__m128i*>(_Dest);
+                    ::_mm_storeu_si128(_Target, ::_mm_unpacklo_epi8(_Block, _Zero));
+                    ::_mm_storeu_si128(_Target + 1, ::_mm_unpackhi_epi8(_Block, _Zero));
+                }
+
+                if (_Off == _Count) {
+                    break;
+                }
+
+                if (_Data[_Off] < 0x80) {
+                    *_Dest++ = static_cast<wchar_t>(_Data[_Off++]);
+                    continue;
+                }
+
+                uint32_t _Code_point;
+                _Off += _Decode_utf8_sequence(_Data + _Off, _Count - _Off, _Code_point);
+                if (_Code_point >= 0x10000) { // encode as a surrogate pair
+                    _Code_point -= 0x10000;
+                    *_Dest++     = static_cast<wchar_t>(0xD800 + (_Code_point >> 10));
+                    *_Dest++     = static_cast<wchar_t>(0xDC00 + (_Code_point & 0x3FF));
+                } else {
+                    *_Dest++ = static_cast<wchar_t>(_Code_point);
+                }
+            }
+        }
+
+        inline bool _Is_high_surrogate(const uint16_t _Ch) noexcept {
+            return _Ch >= 0xD800 && _Ch <= 0xDBFF;
+        }
+
+        inline bool _Is_low_surrogate(const uint16_t _Ch) noexcept {
+            return _Ch >= 0xDC00 && _Ch <= 0xDFFF;
+        }
+
+        inline bool _Utf16_to_utf8_length(
+            const wchar_t* const _Str, const size_t _Count, size_t& _Length) noexcept {
+            // validates the input and computes the number of UTF-8 code units it requires
+            size_t _Off    = 0;
+            size_t _Result = 0;
+            while (_Off < _Count) {
+                const size_t _Ascii = _Count_leading_ascii(_Str + _Off, _Count - _Off);
+                _Off    += _Ascii;
+                _Result += _Ascii;
+                if (_Off == _Count) {
+                    break;
+                }
+
+                const uint16_t _Ch = static_cast<uint16_t>(_Str[_Off]);
+                if (_Ch < 0x800) {
+                    _Result += 2;
+                    ++_Off;
+                } else if (_Is_high_surrogate(_Ch)) {
+                    if (_Off + 1 == _Count || !_Is_low_surrogate(static_cast<uint16_t>(_Str[_Off + 1]))) {
+                        return false; // unpaired high surrogate
+                    }
+
+                    _Result += 4;
+                    _Off    += 2;
+                } else if (_Is_low_surrogate(_Ch)) { // unpaired low surrogate
+                    return false;
+                } else {
+                    _Result += 3;
+                    ++_Off;
+                }
+            }
+
+            _Length = _Result;
+            return true;
+        }
+
+        inline void _Utf16_to_utf8(const wchar_t* const _Str, const size_t _Count, char* _Dest) noexcept {
+            // converts the input, which must be already validated by _Utf16_to_utf8_length()
+            const __m128i _Non_ascii_bits = ::_mm_set1_epi16(static_cast<short>(0xFF80));
+            const __m128i _Zero           = ::_mm_setzero_si128();
+            size_t _Off                   = 0;
+            while (_Off < _Count) {
+                for (; _Off + 8 <= _Count; _Off += 8, _Dest += 8) { // narrow 8 ASCII code units at once
+                    const __m128i _Block = ::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Str + _Off));
+                    if (::_mm_movemask_epi8(
+                        ::_mm_cmpeq_epi16(::_mm_and_si128(_Block, _Non_ascii_bits), _Zero)) != 0xFFFF) {
+                        break;
+                    }
+
+                    ::_mm_storel_epi64(reinterpret_cast<__m128i*>(_Dest), ::_mm_packus_epi16(_Block, _Block));
+                }
+
+                if (_Off == _Count) {
+                    break;
+                }
+
+                uint32_t _Code_point = static_cast<uint16_t>(_Str[_Off++]);
+                if (_Code_point < 0x80) {
+                    *_Dest++ = static_cast<char>(_Code_point);
+                } else if (_Code_point < 0x800) {
+                    *_Dest++ = static_cast<char>(0xC0 | (_Code_point >> 6));
+                    *_Dest++ = static_cast<char>(0x80 | (_Code_point & 0x3F));
+                } else if (_Is_high_surrogate(static_cast<uint16_t>(_Code_point))) {
+                    _Code_point = 0x10000 + ((_Code_point - 0xD800) << 10)
+                        + (static_cast<uint16_t>(_Str[_Off++]) - 0xDC00);
+                    *_Dest++ = static_cast<char>(0xF0 | (_Code_point >> 18));
+                    *_Dest++ = static_cast<char>(0x80 | ((_Code_point >> 12) & 0x3F));
+                    *_Dest++ = static_cast<char>(0x80 | ((_Code_point >> 6) & 0x3F));
+                    *_Dest++ = static_cast<char>(0x80 | (_Code_point & 0x3F));
+                } else {
+                    *_Dest++ = static_cast<char>(0xE0 | (_Code_point >> 12));
+                    *_Dest++ = static_cast<char>(0x80 | ((_Code_point >> 6) & 0x3F));
+                    *_Dest++ = static_cast<char>(0x80 | (_Code_point & 0x3F));
+                }
+            }
+        }
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_TRANSCODE_HPP_
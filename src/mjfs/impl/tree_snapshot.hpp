@@ -0,0 +1,595 @@
+// tree_snapshot.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_TREE_SNAPSHOT_HPP_
+#define _MJFS_IMPL_TREE_SNAPSHOT_HPP_
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mjfs/directory_listing.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/impl/file.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/status.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        inline int _Compare_snapshot_paths(
+            const unicode_string_view _Left, const unicode_string_view _Right) noexcept {
+            // Note: The paths are compared case-insensitively, component by component. The separator is
+            //       treated as the lowest character, so a directory is followed by its own entries before
+            //       any of its siblings whose names start with the directory's name.
+            wchar_t _Left_chunk[_Fold_chunk_size];
+            wchar_t _Right_chunk[_Fold_chunk_size];
+            const size_t _Size = (::std::min)(_Left.size(), _Right.size());
+            for (size_t _Off = 0; _Off < _Size; _Off += _Fold_chunk_size) {
+                const size_t _Count = (::std::min)(_Size - _Off, _Fold_chunk_size);
+                _Fold_path_chunk(_Left.data() + _Off, _Count, _Left_chunk);
+                _Fold_path_chunk(_Right.data() + _Off, _Count, _Right_chunk);
+                for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                    const wchar_t _Left_ch  = _Left_chunk[_Idx] == L'\\' ? L'\0' : _Left_chunk[_Idx];
+                    const wchar_t _Right_ch = _Right_chunk[_Idx] == L'\\' ? L'\0' : _Right_chunk[_Idx];
+                    if (_Left_ch != _Right_ch) {
+                        return _Left_ch < _Right_ch ? -1 : 1;
+                    }
+                }
+            }
+
+            return _Left.size() < _Right.size() ? -1 : (_Left.size() > _Right.size() ? 1 : 0);
+        }
+
+        inline bool _Get_directory_stamp(
+            const wchar_t* const _Dir, uint64_t& _Write_time, _File_id& _Id) noexcept {
+            _Close_handle_guard _Guard = {::CreateFileW(_Dir, FILE_READ_ATTRIBUTES,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+            BY_HANDLE_FILE_INFORMATION _Info;
+            if (!_Guard._Holds_valid_handle() || ::GetFileInformationByHandle(_Guard._Handle, &_Info) == 0
+                || (_Info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+                return false;
+            }
+
+            const FILETIME& _Time = _Info.ftLastWriteTime;
+            _Write_time           = _Make_uint64(_Time.dwHighDateTime, _Time.dwLowDateTime);
+            _Id                   = _Get_file_id_by_handle(_Guard._Handle, _Info);
+            return true;
+        }
+
+        inline constexpr uint32_t _Snapshot_magic   = 0x5354'4A4D; // "MJTS" in little-endian order
+        inline constexpr uint32_t _Snapshot_version = 2; // version 1 stored 64-bit file IDs
+
+        struct _Snapshot_header {
+            uint32_t _Magic;
+            uint32_t _Version;
+            uint64_t _Count; // the number of entries
+            uint64_t _Name_size; // the number of characters in all relative paths
+            uint64_t _Root_size; // the number of characters in the root
+            uint64_t _Root_write_time;
+            uint64_t _Root_volume; // the serial number of the root's volume
+            uint64_t _Root_id_low;
+            uint64_t _Root_id_high;
+        };
+
+        inline constexpr size_t _Snapshot_header_words = sizeof(_Snapshot_header) / sizeof(uint64_t);
+
+        inline size_t _Words_for_chars(const size_t _Count) noexcept {
+            return (_Count * sizeof(wchar_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        }
+
+        inline size_t _Snapshot_word_count(
+            const size_t _Count, const size_t _Name_size, const size_t _Root_size) noexcept {
+            // Note: The file consists of the header, followed by the offsets of the relative paths
+            //       (one more than there are entries), five 64-bit columns (sizes, write times, the lower
+            //       and upper halves of the IDs and subtree sizes), the 32-bit attributes, the root and
+            //       the relative paths. Each part starts at an 8-byte boundary, so the columns can be used
+            //       directly from a mapped file.
+            return _Snapshot_header_words + (_Count + 1) + 5 * _Count + (_Count + 1) / 2
+                + _Words_for_chars(_Root_size) + _Words_for_chars(_Name_size);
+        }
+
+        class _Tree_snapshot {
+        public:
+            const _Snapshot_header* _Header = nullptr;
+            const uint64_t* _Offsets        = nullptr;
+            const uint64_t* _Sizes          = nullptr;
+            const uint64_t* _Write_times    = nullptr;
+            const uint64_t* _Id_lows        = nullptr;
+            const uint64_t* _Id_highs       = nullptr;
+            const uint64_t* _Subtrees       = nullptr;
+            const uint32_t* _Attributes     = nullptr;
+            const wchar_t* _Root            = nullptr;
+            const wchar_t* _Names           = nullptr;
+
+            _Tree_snapshot() noexcept : _Mystorage(), _Myview(nullptr), _Mybytes(0) {}
+
+            ~_Tree_snapshot() noexcept {
+                _Reset();
+            }
+
+            _Tree_snapshot(const _Tree_snapshot&)            = delete;
+            _Tree_snapshot& operator=(const _Tree_snapshot&) = delete;
+
+            bool _Valid() const noexcept {
+                return _Header != nullptr;
+            }
+
+            size_t _Size() const noexcept {
+                return _Header != nullptr ? static_cast<size_t>(_Header->_Count) : 0;
+            }
+
+            unicode_string_view _Relative_path(const size_t _Idx) const noexcept {
+                const size_t _Offset = static_cast<size_t>(_Offsets[_Idx]);
+                const size_t _End    = static_cast<size_t>(_Offsets[_Idx + 1]);
+                return unicode_string_view{_Names + _Offset, _End - _Offset};
+            }
+
+            unicode_string_view _Root_path() const noexcept {
+                if (_Header == nullptr) {
+                    return unicode_string_view{};
+                }
+
+                return unicode_string_view{_Root, static_cast<size_t>(_Header->_Root_size)};
+            }
+
+            file_id_128 _File_id_at(const size_t _Idx) const noexcept {
+                return file_id_128{_Id_lows[_Idx], _Id_highs[_Idx]};
+            }
+
+            bool _Is_directory(const size_t _Idx) const noexcept {
+                return (_Attributes[_Idx] & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            }
+
+            const unsigned char* _Data() const noexcept {
+                return _Myview != nullptr
+                    ? static_cast<const unsigned char*>(_Myview)
+                    : reinterpret_cast<const unsigned char*>(_Mystorage.data());
+            }
+
+            size_t _Byte_size() const noexcept {
+                return _Mybytes;
+            }
+
+            size_t _Find(const unicode_string_view _Path, size_t _First, size_t _Last) const noexcept {
+                // finds the entry with the path in [_First, _Last), the range must be in the snapshot order
+                size_t _Count = _Last - _First;
+                while (_Count > 0) {
+                    const size_t _Half = _Count / 2;
+                    const size_t _Mid  = _First + _Half;
+                    if (_Compare_snapshot_paths(_Relative_path(_Mid), _Path) < 0) {
+                        _First  = _Mid + 1;
+                        _Count -= _Half + 1;
+                    } else {
+                        _Count = _Half;
+                    }
+                }
+
+                if (_First == _Last || _Compare_snapshot_paths(_Relative_path(_First), _Path) != 0) {
+                    return static_cast<size_t>(-1);
+                }
+
+                return _First;
+            }
+
+            void _Reset() noexcept {
+                if (_Myview != nullptr) {
+                    ::UnmapViewOfFile(_Myview);
+                    _Myview = nullptr;
+                }
+
+                _Mystorage.clear();
+                _Mybytes = 0;
+                _Unbind();
+            }
+
+            void _Adopt(::std::vector<uint64_t>&& _Storage) noexcept {
+                _Reset();
+                _Mystorage = ::std::move(_Storage);
+                _Mybytes   = _Mystorage.size() * sizeof(uint64_t);
+                _Bind(); // always succeeds, the storage was built by _Snapshot_builder
+            }
+
+            bool _Map(const wchar_t* const _Target) noexcept {
+                _Reset();
+                _Close_handle_guard _File_guard = {::CreateFileW(_Target, GENERIC_READ, FILE_SHARE_READ,
+                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+                if (!_File_guard._Holds_valid_handle()) {
+                    return false;
+                }
+
+                LARGE_INTEGER _File_size;
+                if (::GetFileSizeEx(_File_guard._Handle, &_File_size) == 0 || _File_size.QuadPart <= 0
+                    || static_cast<uint64_t>(_File_size.QuadPart) > static_cast<size_t>(-1)) {
+                    return false;
+                }
+
+                // the view remains valid after both handles are closed
+                _Close_handle_guard _Mapping_guard = {
+                    ::CreateFileMappingW(_File_guard._Handle, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+                if (!_Mapping_guard._Holds_valid_handle()) {
+                    return false;
+                }
+
+                _Myview = ::MapViewOfFile(_Mapping_guard._Handle, FILE_MAP_READ, 0, 0, 0);
+                if (_Myview == nullptr) {
+                    return false;
+                }
+
+                _Mybytes = static_cast<size_t>(_File_size.QuadPart);
+                if (!_Bind()) {
+                    _Reset();
+                    return false;
+                }
+
+                return true;
+            }
+
+        private:
+            void _Unbind() noexcept {
+                _Header      = nullptr;
+                _Offsets     = nullptr;
+                _Sizes       = nullptr;
+                _Write_times = nullptr;
+                _Id_lows     = nullptr;
+                _Id_highs    = nullptr;
+                _Subtrees    = nullptr;
+                _Attributes  = nullptr;
+                _Root        = nullptr;
+                _Names       = nullptr;
+            }
+
+            bool _Bind() noexcept {
+                // Note: A loaded file is not trusted, so the sizes in the header are checked against
+                //       the size of the file and the offsets are checked before any path is accessed.
+                const uint64_t* const _Words = reinterpret_cast<const uint64_t*>(_Data());
+                const size_t _Word_count     = _Mybytes / sizeof(uint64_t);
+                if (_Mybytes % sizeof(uint64_t) != 0 || _Word_count < _Snapshot_header_words) {
+                    return false;
+                }
+
+                const _Snapshot_header* const _Hdr = reinterpret_cast<const _Snapshot_header*>(_Words);
+                if (_Hdr->_Magic != _Snapshot_magic || _Hdr->_Version != _Snapshot_version
+                    || _Hdr->_Count >= _Word_count || _Hdr->_Name_size >= _Mybytes
+                    || _Hdr->_Root_size >= _Mybytes) { // also rules out overflows below
+                    return false;
+                }
+
+                const size_t _Count     = static_cast<size_t>(_Hdr->_Count);
+                const size_t _Name_size = static_cast<size_t>(_Hdr->_Name_size);
+                const size_t _Root_size = static_cast<size_t>(_Hdr->_Root_size);
+                if (_Snapshot_word_count(_Count, _Name_size, _Root_size) != _Word_count) {
+                    return false;
+                }
+
+                const uint64_t* _Column = _Words + _Snapshot_header_words;
+                _Offsets                = _Column;
+                _Sizes                  = _Offsets + (_Count + 1);
+                _Write_times            = _Sizes + _Count;
+                _Id_lows                = _Write_times + _Count;
+                _Id_highs               = _Id_lows + _Count;
+                _Subtrees               = _Id_highs + _Count;
+                _Column                 = _Subtrees + _Count;
+                _Attributes             = reinterpret_cast<const uint32_t*>(_Column);
+                _Column                += (_Count + 1) / 2;
+                _Root                   = reinterpret_cast<const wchar_t*>(_Column);
+                _Column                += _Words_for_chars(_Root_size);
+                _Names                  = reinterpret_cast<const wchar_t*>(_Column);
+                if (_Offsets[0] != 0 || _Offsets[_Count] != _Name_size) {
+                    _Unbind();
+                    return false;
+                }
+
+                for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                    if (_Offsets[_Idx] > _Offsets[_Idx + 1] || _Subtrees[_Idx] >= _Count - _Idx) {
+                        _Unbind();
+                        return false;
+                    }
+                }
+
+                _Header = _Hdr;
+                return true;
+            }
+
+            ::std::vector<uint64_t> _Mystorage; // the snapshot taken by this process, empty if mapped
+            void* _Myview; // the mapped file, null if not mapped
+            size_t _Mybytes;
+        };
+
+        class _Snapshot_builder { // collects the entries column by column, then packs them
+        public:
+            ::std::vector<wchar_t> _Names;
+            ::std::vector<uint64_t> _Offsets;
+            ::std::vector<uint64_t> _Sizes;
+            ::std::vector<uint64_t> _Write_times;
+            ::std::vector<uint64_t> _Id_lows;
+            ::std::vector<uint64_t> _Id_highs;
+            ::std::vector<uint64_t> _Subtrees;
+            ::std::vector<uint32_t> _Attributes;
+
+            _Snapshot_builder() : _Names(), _Offsets(1, 0), _Sizes(), _Write_times(), _Id_lows(), _Id_highs(),
+                _Subtrees(), _Attributes() {}
+
+            size_t _Size() const noexcept {
+                return _Attributes.size();
+            }
+
+            void _Append(const unicode_string_view _Path, const uint32_t _Attrs,
+                const uint64_t _File_size, const uint64_t _Write_time, const file_id_128& _Id) {
+                _Names.insert(_Names.end(), _Path.data(), _Path.data() + _Path.size());
+                _Offsets.push_back(_Names.size());
+                _Sizes.push_back(_File_size);
+                _Write_times.push_back(_Write_time);
+                _Id_lows.push_back(_Id.low);
+                _Id_highs.push_back(_Id.high);
+                _Subtrees.push_back(0);
+                _Attributes.push_back(_Attrs);
+            }
+
+            ::std::vector<uint64_t> _Pack(const unicode_string_view _Root,
+                const uint64_t _Root_write_time, const _File_id& _Root_id) const {
+                const size_t _Count = _Size();
+                ::std::vector<uint64_t> _Words(_Snapshot_word_count(_Count, _Names.size(), _Root.size()), 0);
+                _Snapshot_header _Hdr;
+                _Hdr._Magic           = _Snapshot_magic;
+                _Hdr._Version         = _Snapshot_version;
+                _Hdr._Count           = _Count;
+                _Hdr._Name_size       = _Names.size();
+                _Hdr._Root_size       = _Root.size();
+                _Hdr._Root_write_time = _Root_write_time;
+                _Hdr._Root_volume     = _Root_id._Volume;
+                _Hdr._Root_id_low     = _Root_id._Low;
+                _Hdr._Root_id_high    = _Root_id._High;
+                ::memcpy(_Words.data(), &_Hdr, sizeof(_Snapshot_header));
+                uint64_t* _Column = _Words.data() + _Snapshot_header_words;
+                _Column           = ::std::copy(_Offsets.begin(), _Offsets.end(), _Column);
+                _Column           = ::std::copy(_Sizes.begin(), _Sizes.end(), _Column);
+                _Column           = ::std::copy(_Write_times.begin(), _Write_times.end(), _Column);
+                _Column           = ::std::copy(_Id_lows.begin(), _Id_lows.end(), _Column);
+                _Column           = ::std::copy(_Id_highs.begin(), _Id_highs.end(), _Column);
+                _Column           = ::std::copy(_Subtrees.begin(), _Subtrees.end(), _Column);
+                ::memcpy(_Column, _Attributes.data(), _Count * sizeof(uint32_t));
+                _Column += (_Count + 1) / 2;
+                ::memcpy(_Column, _Root.data(), _Root.size() * sizeof(wchar_t));
+                _Column += _Words_for_chars(_Root.size());
+                ::memcpy(_Column, _Names.data(), _Names.size() * sizeof(wchar_t));
+                return _Words;
+            }
+        };
+
+        class _Tree_scanner {
+        public:
+            _Tree_scanner(const unicode_string_view _Root, const _Tree_snapshot* const _Previous)
+                : _Mybuilder(), _Myframes(), _Mydepth(0), _Myroot(_Root), _Myprev(_Previous), _Mypath(),
+                _Myfull_path() {}
+
+            _Tree_scanner(const _Tree_scanner&)            = delete;
+            _Tree_scanner& operator=(const _Tree_scanner&) = delete;
+
+            bool _Scan(::std::vector<uint64_t>& _Storage) {
+                uint64_t _Root_write_time;
+                _File_id _Root_id;
+                _Set_full_path(0);
+                if (!_Get_directory_stamp(_Myfull_path.data(), _Root_write_time, _Root_id)) {
+                    return false;
+                }
+
+                if (_Myprev != nullptr && (!_Myprev->_Valid()
+                    || !_Equal_path_strings_insensitive(_Myprev->_Root_path(), _Myroot))) {
+                    _Myprev = nullptr; // a snapshot of another directory can't be reused
+                }
+
+                const size_t _Prev_size = _Myprev != nullptr ? _Myprev->_Size() : 0;
+                if (_Myprev != nullptr && _Myprev->_Header->_Root_write_time == _Root_write_time
+                    && _Myprev->_Header->_Root_volume == _Root_id._Volume
+                    && _Myprev->_Header->_Root_id_low == _Root_id._Low
+                    && _Myprev->_Header->_Root_id_high == _Root_id._High) {
+                    _Push_reused(static_cast<size_t>(-1), 0, _Prev_size);
+                } else {
+                    _Push_enumerated(static_cast<size_t>(-1), 0, _Prev_size);
+                }
+
+                while (_Mydepth > 0) {
+                    if (!_Visit_next()) {
+                        _Pop();
+                    }
+                }
+
+                _Storage = _Mybuilder._Pack(_Myroot, _Root_write_time, _Root_id);
+                return true;
+            }
+
+        private:
+            struct _Frame {
+                directory_listing _Listing; // the entries of an enumerated directory
+                size_t _Next; // the next position in the listing or in the previous snapshot
+                size_t _Prev_first; // the first entry inside the directory in the previous snapshot
+                size_t _Prev_last; // the end of the directory in the previous snapshot
+                size_t _Entry; // the position of the directory in the new snapshot, -1 for the root
+                size_t _Path_size; // the length of the directory's relative path
+                bool _Reused; // true if the entries are taken from the previous snapshot
+            };
+
+            void _Set_full_path(const size_t _Path_size) {
+                // Note: The full path is the root, followed by the relative path, with a separator
+                //       between them only if the root doesn't end with one.
+                _Myfull_path.assign(_Myroot.data(), _Myroot.data() + _Myroot.size());
+                if (_Path_size > 0) {
+                    if (!_Myfull_path.empty() && _Myfull_path.back() != L'\\' && _Myfull_path.back() != L'/') {
+                        _Myfull_path.push_back(L'\\');
+                    }
+
+                    _Myfull_path.insert(_Myfull_path.end(), _Mypath.data(), _Mypath.data() + _Path_size);
+                }
+
+                _Myfull_path.push_back(L'\0');
+            }
+
+            _Frame& _Push_frame(const size_t _Entry, const size_t _Prev_first, const size_t _Prev_last) {
+                // the frames are never destroyed, so each listing keeps its memory for the next directory
+                if (_Mydepth == _Myframes.size()) {
+                    _Myframes.emplace_back();
+                }
+
+                _Frame& _New_frame     = _Myframes[_Mydepth++];
+                _New_frame._Next       = 0;
+                _New_frame._Prev_first = _Prev_first;
+                _New_frame._Prev_last  = _Prev_last;
+                _New_frame._Entry      = _Entry;
+                _New_frame._Path_size  = _Mypath.size();
+                _New_frame._Reused     = false;
+                return _New_frame;
+            }
+
+            void _Push_reused(const size_t _Entry, const size_t _Prev_first, const size_t _Prev_last) {
+                _Frame& _New_frame = _Push_frame(_Entry, _Prev_first, _Prev_last);
+                _New_frame._Next   = _Prev_first;
+                _New_frame._Reused = true;
+            }
+
+            void _Push_enumerated(const size_t _Entry, const size_t _Prev_first, const size_t _Prev_last) {
+                // Note: If the directory can't be read (e.g. it was removed or access is denied),
+                //       the listing is left empty, so the directory is stored without its entries.
+                _Frame& _New_frame = _Push_frame(_Entry, _Prev_first, _Prev_last);
+                _Set_full_path(_Mypath.size());
+                if (_New_frame._Listing.read(path{_Myfull_path.data()})) {
+                    _New_frame._Listing.sort();
+                }
+            }
+
+            void _Pop() noexcept {
+                const _Frame& _Top = _Myframes[--_Mydepth];
+                if (_Top._Entry != static_cast<size_t>(-1)) {
+                    _Mybuilder._Subtrees[_Top._Entry] = _Mybuilder._Size() - _Top._Entry - 1;
+                }
+            }
+
+            void _Append_name(const size_t _Path_size, const unicode_string_view _Name) {
+                _Mypath.resize(_Path_size);
+                if (_Path_size > 0) {
+                    _Mypath.push_back(L'\\');
+                }
+
+                _Mypath.insert(_Mypath.end(), _Name.data(), _Name.data() + _Name.size());
+            }
+
+            static unicode_string_view _Last_component(const unicode_string_view _Path) noexcept {
+                size_t _Off = _Path.size();
+                while (_Off > 0 && _Path.data()[_Off - 1] != L'\\') {
+                    --_Off;
+                }
+
+                return unicode_string_view{_Path.data() + _Off, _Path.size() - _Off};
+            }
+
+            static bool _Should_descend(const uint32_t _Attrs) noexcept {
+                // reparse points are stored, but never followed
+                return (_Attrs & FILE_ATTRIBUTE_DIRECTORY) != 0
+                    && (_Attrs & FILE_ATTRIBUTE_REPARSE_POINT) == 0;
+            }
+
+            bool _Visit_next() {
+                // Note: Each call stores one entry. A subdirectory is pushed right after it's stored, so its
+                //       entries follow it immediately, which gives the depth-first order.
+                _Frame& _Top = _Myframes[_Mydepth - 1];
+                if (_Top._Reused) {
+                    return _Visit_next_reused(_Top);
+                } else {
+                    return _Visit_next_enumerated(_Top);
+                }
+            }
+
+            bool _Visit_next_reused(_Frame& _Top) {
+                if (_Top._Next == _Top._Prev_last) {
+                    return false;
+                }
+
+                const size_t _Prev_idx = _Top._Next;
+                const size_t _Subtree  = static_cast<size_t>(_Myprev->_Subtrees[_Prev_idx]);
+                _Top._Next            += _Subtree + 1;
+                _Append_name(_Top._Path_size, _Last_component(_Myprev->_Relative_path(_Prev_idx)));
+                const uint32_t _Attrs = _Myprev->_Attributes[_Prev_idx];
+                uint64_t _Write_time  = _Myprev->_Write_times[_Prev_idx];
+                const file_id_128 _Id = _Myprev->_File_id_at(_Prev_idx);
+                bool _Unchanged       = true;
+                if (_Should_descend(_Attrs)) { // a subdirectory may have changed even if its parent didn't
+                    _Set_full_path(_Mypath.size());
+                    WIN32_FILE_ATTRIBUTE_DATA _Data;
+                    if (::GetFileAttributesExW(_Myfull_path.data(), GetFileExInfoStandard, &_Data) != 0) {
+                        const uint64_t _Current = _Make_uint64(
+                            _Data.ftLastWriteTime.dwHighDateTime, _Data.ftLastWriteTime.dwLowDateTime);
+                        _Unchanged              = _Current == _Write_time;
+                        _Write_time             = _Current;
+                    }
+                }
+
+                const size_t _Entry = _Mybuilder._Size();
+                _Mybuilder._Append(unicode_string_view{_Mypath.data(), _Mypath.size()},
+                    _Attrs, _Myprev->_Sizes[_Prev_idx], _Write_time, _Id);
+                if (_Should_descend(_Attrs)) {
+                    if (_Unchanged) {
+                        _Push_reused(_Entry, _Prev_idx + 1, _Prev_idx + 1 + _Subtree);
+                    } else {
+                        _Push_enumerated(_Entry, _Prev_idx + 1, _Prev_idx + 1 + _Subtree);
+                    }
+                }
+
+                return true;
+            }
+
+            bool _Visit_next_enumerated(_Frame& _Top) {
+                const directory_listing& _Listing = _Top._Listing;
+                if (_Top._Next == _Listing.size()) {
+                    return false;
+                }
+
+                const size_t _Idx = _Top._Next++;
+                _Append_name(_Top._Path_size, _Listing.name(_Idx));
+                const uint32_t _Attrs      = static_cast<uint32_t>(_Listing.attributes(_Idx));
+                const uint64_t _Write_time = _Listing.last_write_time(_Idx);
+                const file_id_128 _Id      = _Listing.file_id(_Idx);
+                const size_t _Entry        = _Mybuilder._Size();
+                const unicode_string_view _Path{_Mypath.data(), _Mypath.size()};
+                _Mybuilder._Append(_Path, _Attrs, _Listing.file_size(_Idx), _Write_time, _Id);
+                if (!_Should_descend(_Attrs)) {
+                    return true;
+                }
+
+                // only the previous entries of the parent directory have to be searched
+                const size_t _Prev_idx = _Myprev != nullptr
+                    ? _Myprev->_Find(_Path, _Top._Prev_first, _Top._Prev_last) : static_cast<size_t>(-1);
+                if (_Prev_idx == static_cast<size_t>(-1) || !_Myprev->_Is_directory(_Prev_idx)) {
+                    _Push_enumerated(_Entry, 0, 0);
+                    return true;
+                }
+
+                const size_t _Prev_last = _Prev_idx + 1 + static_cast<size_t>(_Myprev->_Subtrees[_Prev_idx]);
+                if (_Myprev->_Write_times[_Prev_idx] == _Write_time
+                    && _Myprev->_File_id_at(_Prev_idx) == _Id) {
+                    _Push_reused(_Entry, _Prev_idx + 1, _Prev_last);
+                } else {
+                    _Push_enumerated(_Entry, _Prev_idx + 1, _Prev_last);
+                }
+
+                return true;
+            }
+
+            _Snapshot_builder _Mybuilder;
+            ::std::vector<_Frame> _Myframes;
+            size_t _Mydepth; // the number of used frames
+            unicode_string_view _Myroot;
+            const _Tree_snapshot* _Myprev; // the previous snapshot, null if there is none
+            ::std::vector<wchar_t> _Mypath; // the relative path of the current entry
+            ::std::vector<wchar_t> _Myfull_path; // the null-terminated full path passed to the system
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_TREE_SNAPSHOT_HPP_
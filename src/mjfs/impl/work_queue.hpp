@@ -0,0 +1,132 @@
+// work_queue.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_IMPL_WORK_QUEUE_HPP_
+#define _MJFS_IMPL_WORK_QUEUE_HPP_
+#include <condition_variable>
+#include <cstddef>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/path.hpp>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        template <class _Ty>
+        class _Work_queue { // directories waiting to be processed, shared by the threads that process them
+        public:
+            _Work_queue() noexcept : _Mymtx(), _Mycv(), _Myitems(), _Myactive(0), _Mystopped(false) {}
+
+            _Work_queue(const _Work_queue&)            = delete;
+            _Work_queue& operator=(const _Work_queue&) = delete;
+
+            void _Begin() noexcept {
+                // marks the root as being processed, it's processed before any thread is started
+                _Myactive = 1;
+            }
+
+            void _Push(::std::vector<_Ty>& _Items) {
+                if (_Items.empty()) {
+                    return;
+                }
+
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                _Myactive += _Items.size();
+                for (_Ty& _Item : _Items) {
+                    _Myitems.push_back(::std::move(_Item));
+                }
+
+                _Mycv.notify_all();
+            }
+
+            bool _Finish_one() {
+                // marks a directory as processed, returns true if no directory remains
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                if (--_Myactive == 0) {
+                    _Mycv.notify_all();
+                    return true;
+                }
+
+                return false;
+            }
+
+            template <class _Fn>
+            void _Work(const _Fn& _Process) {
+                // Note: The directories are taken in LIFO order, so the threads go deep first and the queue
+                //       stays short. A thread waits only if the queue is empty, but some directory is still
+                //       being processed, since it may add more.
+                //       If processing throws, the queue is stopped, so the other threads don't wait for
+                //       the directories that will never be added.
+                try {
+                    _Ty _Item;
+                    while (_Pop(_Item)) {
+                        _Process(_Item);
+                        _Finish_one();
+                    }
+                } catch (...) {
+                    _Stop();
+                    throw;
+                }
+            }
+
+            void _Stop() noexcept {
+                // makes all threads return from _Work() without taking further directories
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                _Mystopped = true;
+                _Mycv.notify_all();
+            }
+
+        private:
+            bool _Pop(_Ty& _Item) {
+                ::std::unique_lock<::std::mutex> _Lock(_Mymtx);
+                _Mycv.wait(_Lock, [this] { return !_Myitems.empty() || _Myactive == 0 || _Mystopped; });
+                if (_Myitems.empty() || _Mystopped) { // all directories are done, or some thread failed
+                    return false;
+                }
+
+                _Item = ::std::move(_Myitems.back());
+                _Myitems.pop_back();
+                return true;
+            }
+
+            ::std::mutex _Mymtx;
+            ::std::condition_variable _Mycv;
+            ::std::vector<_Ty> _Myitems;
+            size_t _Myactive; // the directories that are queued or being processed
+            bool _Mystopped;
+        };
+
+        class _First_error { // the first error of an operation that continues after errors
+        public:
+            _First_error() noexcept : _Mymtx(), _Myerror(0), _Mypath() {}
+
+            _First_error(const _First_error&)            = delete;
+            _First_error& operator=(const _First_error&) = delete;
+
+            void _Set(const path& _Target, const unsigned long _Error) {
+                ::std::lock_guard<::std::mutex> _Guard(_Mymtx);
+                if (_Myerror == 0) { // keep only the first error
+                    _Myerror = _Error != 0 ? _Error : ERROR_GEN_FAILURE;
+                    _Mypath  = _Target;
+                }
+            }
+
+            void _Report(unsigned long& _Error, path& _Failed_path) {
+                // called once all threads are done
+                _Error       = _Myerror;
+                _Failed_path = ::std::move(_Mypath);
+            }
+
+        private:
+            ::std::mutex _Mymtx;
+            unsigned long _Myerror;
+            path _Mypath;
+        };
+    } // namespace mjfs_impl
+} // namespace mjx
+
+#endif // _MJFS_IMPL_WORK_QUEUE_HPP_
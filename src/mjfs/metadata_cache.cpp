@@ -0,0 +1,68 @@
+// metadata_cache.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <mjfs/bitmask.hpp>
+#include <mjfs/impl/metadata_cache.hpp>
+#include <mjfs/metadata_cache.hpp>
+#include <mjmem/object_allocator.hpp>
+
+namespace mjx {
+    metadata_cache::metadata_cache() : metadata_cache(metadata_cache_options{}) {}
+
+    metadata_cache::metadata_cache(const metadata_cache_options& _Options)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Metadata_cache>(_Options)) {}
+
+    metadata_cache::metadata_cache(metadata_cache&& _Other) noexcept : _Myimpl(::std::move(_Other._Myimpl)) {}
+
+    metadata_cache::~metadata_cache() noexcept {}
+
+    metadata_cache& metadata_cache::operator=(metadata_cache&& _Other) noexcept {
+        _Myimpl = ::std::move(_Other._Myimpl);
+        return *this;
+    }
+
+    file_status metadata_cache::status(const path& _Target) {
+        return _Myimpl->_Get_status(_Target, true);
+    }
+
+    file_status metadata_cache::symlink_status(const path& _Target) {
+        return _Myimpl->_Get_status(_Target, false);
+    }
+
+    bool metadata_cache::exists(const path& _Target) {
+        return ::mjx::exists(symlink_status(_Target));
+    }
+
+    bool metadata_cache::is_directory(const path& _Target) {
+        // Note: As in mjx::is_directory(), junctions and symbolic links to directories are included,
+        //       because they have the directory attribute.
+        const file_status _Status = symlink_status(_Target);
+        return ::mjx::exists(_Status) && _Has_bits(_Status.attributes, file_attribute::directory);
+    }
+
+    bool metadata_cache::is_regular_file(const path& _Target) {
+        return ::mjx::is_regular_file(status(_Target)); // follows links, like mjx::is_regular_file()
+    }
+
+    bool metadata_cache::is_symlink(const path& _Target) {
+        return ::mjx::is_symlink(symlink_status(_Target));
+    }
+
+    bool metadata_cache::is_junction(const path& _Target) {
+        return ::mjx::is_junction(symlink_status(_Target));
+    }
+
+    void metadata_cache::invalidate(const path& _Target) noexcept {
+        _Myimpl->_Invalidate(_Target.native());
+    }
+
+    void metadata_cache::clear() noexcept {
+        _Myimpl->_Clear();
+    }
+
+    size_t metadata_cache::size() const noexcept {
+        return _Myimpl->_Size();
+    }
+} // namespace mjx
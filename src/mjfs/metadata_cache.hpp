@@ -0,0 +1,81 @@
+// metadata_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_METADATA_CACHE_HPP_
+#define _MJFS_METADATA_CACHE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/path.hpp>
+#include <mjfs/status.hpp>
+#include <mjmem/smart_pointer.hpp>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Metadata_cache;
+    } // namespace mjfs_impl
+
+    // Note: A watch covers only the parent directory, so a change to an ancestor is seen only after
+    //       the TTL. With the directories watched, a zero TTL is replaced by the default one.
+    struct metadata_cache_options {
+        size_t capacity                = 4096; // the maximum number of cached paths
+        size_t shard_count             = 16; // the number of independently locked parts, rounded up to 2^N
+        uint64_t ttl                   = 5000; // the lifetime of an entry in milliseconds, 0 disables caching
+        bool watch_directories         = true; // invalidate the entries when their parent directory changes
+        size_t max_watched_directories = 256; // directories above the limit rely on the TTL only
+    };
+
+    class _MJFS_API metadata_cache { // caches the status of files, safe to use from multiple threads
+    public:
+        metadata_cache();
+        explicit metadata_cache(const metadata_cache_options& _Options);
+        metadata_cache(metadata_cache&& _Other) noexcept;
+        ~metadata_cache() noexcept;
+
+        metadata_cache& operator=(metadata_cache&& _Other) noexcept;
+
+        metadata_cache(const metadata_cache&)            = delete;
+        metadata_cache& operator=(const metadata_cache&) = delete;
+
+        // returns the status of the target, symbolic links and junctions are followed
+        file_status status(const path& _Target);
+
+        // returns the status of the target, symbolic links and junctions are not followed
+        file_status symlink_status(const path& _Target);
+
+        // checks whether the target exists
+        bool exists(const path& _Target);
+
+        // checks whether the target is a directory
+        bool is_directory(const path& _Target);
+
+        // checks whether the target is a regular file
+        bool is_regular_file(const path& _Target);
+
+        // checks whether the target is a symbolic link
+        bool is_symlink(const path& _Target);
+
+        // checks whether the target is a junction
+        bool is_junction(const path& _Target);
+
+        // removes the cached status of the target, including the status followed through it if it's a link
+        // Note: The status followed through a link is cached by the link's path, so invalidating the link's
+        //       target doesn't remove it. With a zero TTL, such a status is never cached.
+        void invalidate(const path& _Target) noexcept;
+
+        // removes all cached entries
+        void clear() noexcept;
+
+        // returns the number of cached paths
+        size_t size() const noexcept;
+
+    private:
+#pragma warning(suppress : 4251) // C4251: unique_smart_ptr<_Metadata_cache> needs to have dll-interface
+        unique_smart_ptr<mjfs_impl::_Metadata_cache> _Myimpl;
+    };
+} // namespace mjx
+
+#endif // _MJFS_METADATA_CACHE_HPP_
@@ -0,0 +1,139 @@
+// name_filter.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <memory>
+#include <mjfs/impl/hash.hpp>
+#include <mjfs/impl/name_filter.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/name_filter.hpp>
+#include <utility>
+
+namespace mjx {
+    directory_name_filter::directory_name_filter() noexcept
+        : _Mydir(), _Mywords(), _Myhashes(0), _Mysize(0), _Myrate(0.01), _Mychange(nullptr) {}
+
+    directory_name_filter::directory_name_filter(directory_name_filter&& _Other) noexcept
+        : _Mydir(::std::move(_Other._Mydir)), _Mywords(::std::move(_Other._Mywords)),
+        _Myhashes(_Other._Myhashes), _Mysize(_Other._Mysize), _Myrate(_Other._Myrate),
+        _Mychange(_Other._Mychange) {
+        _Other._Mychange = nullptr;
+    }
+
+    directory_name_filter::~directory_name_filter() noexcept {
+        _Stop_watching();
+    }
+
+    directory_name_filter::directory_name_filter(
+        const path& _Dir, const name_filter_mode _Mode, const double _False_positive_rate)
+        : _Mydir(_Dir), _Mywords(), _Myhashes(0), _Mysize(0),
+        _Myrate(_False_positive_rate), _Mychange(nullptr) {
+        if (_Myrate <= 0.0 || _Myrate >= 1.0) { // the rate must be a probability other than 0 and 1
+            return;
+        }
+
+        if (_Mode == name_filter_mode::watch) { // must be watched before the enumeration, so no change is lost
+            void* const _Handle = mjfs_impl::_Watch_directory_names(_Mydir.c_str());
+            if (_Handle == INVALID_HANDLE_VALUE) {
+                return;
+            }
+
+            _Mychange = _Handle;
+        }
+
+        if (!_Build()) {
+            _Stop_watching();
+        }
+    }
+
+    directory_name_filter& directory_name_filter::operator=(directory_name_filter&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Stop_watching();
+            _Mydir           = ::std::move(_Other._Mydir);
+            _Mywords         = ::std::move(_Other._Mywords);
+            _Myhashes        = _Other._Myhashes;
+            _Mysize          = _Other._Mysize;
+            _Myrate          = _Other._Myrate;
+            _Mychange        = _Other._Mychange;
+            _Other._Mychange = nullptr;
+        }
+
+        return *this;
+    }
+
+    bool directory_name_filter::_Build() {
+        ::std::vector<uint64_t> _Hashes;
+        if (!mjfs_impl::_Collect_name_hashes(_Mydir, _Hashes)) {
+            _Mywords.clear();
+            _Mysize = 0;
+            return false;
+        }
+
+        _Mywords.assign(mjfs_impl::_Get_bloom_word_count(_Hashes.size(), _Myrate), 0);
+        _Myhashes = mjfs_impl::_Get_bloom_hash_count(_Mywords.size(), _Hashes.size());
+        _Mysize   = _Hashes.size();
+        for (const uint64_t _Hash : _Hashes) {
+            mjfs_impl::_Insert_into_bloom_filter(_Mywords, _Myhashes, _Hash);
+        }
+
+        return true;
+    }
+
+    void directory_name_filter::_Stop_watching() noexcept {
+        if (_Mychange != nullptr) {
+            ::FindCloseChangeNotification(_Mychange);
+            _Mychange = nullptr;
+        }
+    }
+
+    bool directory_name_filter::valid() const noexcept {
+        return !_Mywords.empty();
+    }
+
+    bool directory_name_filter::is_stale() const noexcept {
+        return _Mychange != nullptr ? mjfs_impl::_Has_directory_changed(_Mychange) : false;
+    }
+
+    bool directory_name_filter::refresh() {
+        if (_Mywords.empty()) { // an invalid filter can't be refreshed
+            return false;
+        }
+
+        if (_Mychange != nullptr) {
+            if (!mjfs_impl::_Has_directory_changed(_Mychange)) { // still up to date
+                return true;
+            }
+
+            if (::FindNextChangeNotification(_Mychange) == 0) { // re-arm before the enumeration
+                _Stop_watching();
+                _Mywords.clear();
+                return false;
+            }
+        }
+
+        if (!_Build()) {
+            _Stop_watching();
+            return false;
+        }
+
+        return true;
+    }
+
+    const path& directory_name_filter::directory() const noexcept {
+        return _Mydir;
+    }
+
+    size_t directory_name_filter::size() const noexcept {
+        return _Mysize;
+    }
+
+    bool directory_name_filter::may_contain(const unicode_string_view _Name) const noexcept {
+        if (_Mywords.empty() || (_Mychange != nullptr && mjfs_impl::_Has_directory_changed(_Mychange))) {
+            return true; // nothing is known
+        }
+
+        return mjfs_impl::_Test_bloom_filter(
+            _Mywords, _Myhashes, mjfs_impl::_Hash_path_string_insensitive(_Name));
+    }
+} // namespace mjx
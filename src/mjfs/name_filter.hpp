@@ -0,0 +1,76 @@
+// name_filter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_NAME_FILTER_HPP_
+#define _MJFS_NAME_FILTER_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    enum class name_filter_mode : unsigned char {
+        snapshot, // the filter describes the directory at the time it was built
+        watch // changes of the names in the directory are detected
+    };
+
+    class _MJFS_API directory_name_filter { // Bloom filter over the names in a directory
+    public:
+        directory_name_filter() noexcept;
+        directory_name_filter(directory_name_filter&& _Other) noexcept;
+        ~directory_name_filter() noexcept;
+
+        // Note: The names are enumerated once. The false-positive rate is the probability that
+        //       may_contain() returns true for a name that is not in the directory.
+        explicit directory_name_filter(const path& _Dir,
+            const name_filter_mode _Mode      = name_filter_mode::snapshot,
+            const double _False_positive_rate = 0.01);
+
+        directory_name_filter& operator=(directory_name_filter&& _Other) noexcept;
+
+        directory_name_filter(const directory_name_filter&)            = delete;
+        directory_name_filter& operator=(const directory_name_filter&) = delete;
+
+        // checks whether the filter was built successfully
+        bool valid() const noexcept;
+
+        // checks whether the watched directory has changed since the filter was built
+        bool is_stale() const noexcept;
+
+        // rebuilds the filter if it's stale, a snapshot is always rebuilt and an invalid filter stays invalid
+        bool refresh();
+
+        // returns the directory the filter describes
+        const path& directory() const noexcept;
+
+        // returns the number of names in the filter, the short (8.3) names included
+        size_t size() const noexcept;
+
+        // Note: Returns false only if the directory definitely doesn't contain the name (case-insensitive).
+        //       An invalid or stale filter knows nothing, so it always returns true. Checking a watched
+        //       filter costs a single wait on the change notification, instead of a path lookup.
+        bool may_contain(const unicode_string_view _Name) const noexcept;
+
+    private:
+        // enumerates the directory and fills the filter
+        bool _Build();
+
+        // releases the change notification
+        void _Stop_watching() noexcept;
+
+        path _Mydir;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<uint64_t> _Mywords; // the bits of the filter, empty if the filter is invalid
+        size_t _Myhashes; // the number of bits set for each name
+        size_t _Mysize;
+        double _Myrate;
+        void* _Mychange; // change notification, null if the directory is not watched
+    };
+} // namespace mjx
+
+#endif // _MJFS_NAME_FILTER_HPP_
@@ -3,21 +3,40 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <cstring>
+#include <mjfs/impl/compare.hpp>
+#include <mjfs/impl/hash.hpp>
 #include <mjfs/impl/path.hpp>
+#include <mjfs/impl/transcode.hpp>
 #include <mjfs/path.hpp>
 
 namespace mjx {
-    path::path() noexcept : _Mystr() {}
+    path::path() noexcept : _Mystr(), _Myparts(0) {}
 
-    path::path(const path& _Other) : _Mystr(_Other._Mystr) {}
+    path::path(const path& _Other)
+        : _Mystr(_Other._Mystr), _Myparts(_Other._Myparts.load(::std::memory_order_relaxed)) {}
 
-    path::path(path&& _Other) noexcept : _Mystr(::std::move(_Other._Mystr)) {}
+    path::path(path&& _Other) noexcept
+        : _Mystr(::std::move(_Other._Mystr)), _Myparts(_Other._Myparts.load(::std::memory_order_relaxed)) {
+        _Other._Invalidate_parts();
+    }
+
+    path::path(const value_type* const _Str, format _Fmt) : _Mystr(_Str), _Myparts(0) {
+        _Apply_format(_Fmt);
+    }
 
-    path::path(const value_type* const _Str, format _Fmt) : _Mystr(_Str) {
+    path::path(string_type&& _Str, format _Fmt) noexcept : _Mystr(::std::move(_Str)), _Myparts(0) {
         _Apply_format(_Fmt);
     }
 
-    path::path(string_type&& _Str, format _Fmt) noexcept : _Mystr(::std::move(_Str)) {
+    path::path(const utf8_string_view _Str, format _Fmt) : _Mystr(), _Myparts(0) {
+        size_t _Length;
+        if (!mjfs_impl::_Utf8_to_utf16_length(_Str.data(), _Str.size(), _Length)) {
+            return; // invalid UTF-8, leave the path empty
+        }
+
+        _Mystr.resize(_Length);
+        mjfs_impl::_Utf8_to_utf16(_Str.data(), _Str.size(), _Mystr.data());
         _Apply_format(_Fmt);
     }
 
@@ -26,6 +45,7 @@ namespace mjx {
     path& path::operator=(const path& _Other) {
         if (this != ::std::addressof(_Other)) {
             _Mystr = _Other._Mystr;
+            _Myparts.store(_Other._Myparts.load(::std::memory_order_relaxed), ::std::memory_order_relaxed);
         }
 
         return *this;
@@ -34,6 +54,8 @@ namespace mjx {
     path& path::operator=(path&& _Other) noexcept {
         if (this != ::std::addressof(_Other)) {
             _Mystr = ::std::move(_Other._Mystr);
+            _Myparts.store(_Other._Myparts.load(::std::memory_order_relaxed), ::std::memory_order_relaxed);
+            _Other._Invalidate_parts();
         }
 
         return *this;
@@ -51,6 +73,8 @@ namespace mjx {
     }
 
     void path::_Replace_slashes_with(const wchar_t _Slash, const wchar_t _Replacement) noexcept {
+        // Note: Replacing one slash with another doesn't move any component, so the cached offsets
+        //       remain valid.
         for (value_type& _Ch : _Mystr) {
             if (_Ch == _Slash) {
                 _Ch = _Replacement;
@@ -64,6 +88,7 @@ namespace mjx {
 
     path& path::assign(string_type&& _Str) noexcept {
         _Mystr = ::std::move(_Str);
+        _Invalidate_parts();
         return *this;
     }
 
@@ -72,14 +97,8 @@ namespace mjx {
             return *this;
         }
 
-        if (_Mystr.empty()) { // replace with any path
-            _Mystr = _Other._Mystr;
-            return *this;
-        }
-
-        if (_Other.is_absolute()) { // replace with an absolute path
-            _Mystr = _Other._Mystr;
-            return *this;
+        if (_Mystr.empty() || _Other.is_absolute()) { // replace with the other path
+            return *this = _Other;
         }
 
         if (!mjfs_impl::_Is_slash(_Mystr.back()) && !mjfs_impl::_Is_slash(_Other._Mystr.front())) {
@@ -87,36 +106,43 @@ namespace mjx {
         }
 
         _Mystr += _Other._Mystr;
+        _Invalidate_parts();
         return *this;
     }
 
     path& path::operator+=(const path& _Other) {
         _Mystr += _Other._Mystr;
+        _Invalidate_parts();
         return *this;
     }
 
     path& path::operator+=(const string_type& _Str) {
         _Mystr += _Str;
+        _Invalidate_parts();
         return *this;
     }
 
     path& path::operator+=(const unicode_string_view _Str) {
         _Mystr += _Str;
+        _Invalidate_parts();
         return *this;
     }
 
     path& path::operator+=(const value_type* const _Str) {
         _Mystr += _Str;
+        _Invalidate_parts();
         return *this;
     }
 
     path& path::operator+=(const value_type _Ch) {
         _Mystr.push_back(_Ch);
+        _Invalidate_parts();
         return *this;
     }
 
     void path::clear() noexcept {
         _Mystr.clear();
+        _Invalidate_parts();
     }
 
     path& path::make_preferred() noexcept {
@@ -125,9 +151,10 @@ namespace mjx {
     }
 
     path& path::remove_filename() {
-        const mjfs_impl::_Path_segment& _Filename = mjfs_impl::_Find_filename(_Mystr);
-        if (_Filename._Found()) {
-            _Mystr.erase(_Filename._Offset);
+        const size_t _Length = _Decompose()._Filename(_Mystr).size();
+        if (_Length > 0) {
+            _Mystr.erase(_Mystr.size() - _Length);
+            _Invalidate_parts();
         }
 
         return *this;
@@ -139,9 +166,10 @@ namespace mjx {
     }
 
     path& path::replace_extension(const path& _Replacement) {
-        const size_t _Length = mjfs_impl::_Get_extension(_Mystr).size();
+        const size_t _Length = _Decompose()._Extension_length;
         if (_Length > 0) {
             _Mystr.erase(_Mystr.size() - _Length);
+            _Invalidate_parts();
         }
 
         if (!_Replacement.empty()) { // append new extension
@@ -151,6 +179,7 @@ namespace mjx {
             }
 
             _Mystr.append(_Str);
+            _Invalidate_parts();
         }
 
         return *this;
@@ -158,6 +187,23 @@ namespace mjx {
 
     void path::swap(path& _Other) noexcept {
         _Mystr.swap(_Other._Mystr);
+        const uint64_t _Parts = _Myparts.load(::std::memory_order_relaxed);
+        _Myparts.store(_Other._Myparts.load(::std::memory_order_relaxed), ::std::memory_order_relaxed);
+        _Other._Myparts.store(_Parts, ::std::memory_order_relaxed);
+    }
+
+    mjfs_impl::_Path_decomposition path::_Decompose() const noexcept {
+        const uint64_t _Packed = _Myparts.load(::std::memory_order_relaxed);
+        if (_Packed != 0) { // already computed
+            return mjfs_impl::_Unpack_path_decomposition(_Packed);
+        }
+
+        const mjfs_impl::_Path_decomposition _Parts = mjfs_impl::_Decompose_path(_Mystr);
+        if (mjfs_impl::_Can_pack_path_decomposition(_Mystr.size())) {
+            _Myparts.store(mjfs_impl::_Pack_path_decomposition(_Parts), ::std::memory_order_relaxed);
+        }
+
+        return _Parts;
     }
 
     const path::value_type* path::c_str() const noexcept {
@@ -168,6 +214,57 @@ namespace mjx {
         return _Mystr;
     }
 
+    utf8_string path::u8string() const {
+        size_t _Length;
+        if (!mjfs_impl::_Utf16_to_utf8_length(_Mystr.data(), _Mystr.size(), _Length)) {
+            return utf8_string{};
+        }
+
+        utf8_string _Result(_Length, '\0');
+        mjfs_impl::_Utf16_to_utf8(_Mystr.data(), _Mystr.size(), _Result.data());
+        return _Result;
+    }
+
+    bool path::u8string(utf8_string& _Str) const {
+        size_t _Length;
+        if (!mjfs_impl::_Utf16_to_utf8_length(_Mystr.data(), _Mystr.size(), _Length)) {
+            return false;
+        }
+
+        utf8_string _Result(_Length, '\0');
+        mjfs_impl::_Utf16_to_utf8(_Mystr.data(), _Mystr.size(), _Result.data());
+        _Str = ::std::move(_Result);
+        return true;
+    }
+
+    size_t path::utf8_length() const noexcept {
+        size_t _Length;
+        return mjfs_impl::_Utf16_to_utf8_length(_Mystr.data(), _Mystr.size(), _Length) ? _Length : 0;
+    }
+
+    bool path::to_utf8(char* const _Buf, const size_t _Size) const noexcept {
+        size_t _Length;
+        if (!mjfs_impl::_Utf16_to_utf8_length(_Mystr.data(), _Mystr.size(), _Length) || _Size <= _Length) {
+            return false;
+        }
+
+        mjfs_impl::_Utf16_to_utf8(_Mystr.data(), _Mystr.size(), _Buf);
+        _Buf[_Length] = '\0';
+        return true;
+    }
+
+    int path::compare(const path& _Other) const noexcept {
+        return mjfs_impl::_Compare_paths(_Mystr, _Other._Mystr);
+    }
+
+    int path::compare(const unicode_string_view _Str) const noexcept {
+        return mjfs_impl::_Compare_paths(_Mystr, _Str);
+    }
+
+    int path::compare(const value_type* const _Str) const noexcept {
+        return mjfs_impl::_Compare_paths(_Mystr, unicode_string_view{_Str});
+    }
+
     bool path::empty() const noexcept {
         return _Mystr.empty();
     }
@@ -189,19 +286,19 @@ namespace mjx {
     }
 
     path path::parent_path() const noexcept {
-        return mjfs_impl::_Get_parent_path(_Mystr);
+        return _Decompose()._Parent_path(_Mystr);
     }
 
     path path::filename() const noexcept {
-        return mjfs_impl::_Get_filename(_Mystr);
+        return _Decompose()._Filename(_Mystr);
     }
 
     path path::stem() const noexcept {
-        return mjfs_impl::_Get_stem(_Mystr);
+        return _Decompose()._Stem(_Mystr);
     }
 
     path path::extension() const noexcept {
-        return mjfs_impl::_Get_extension(_Mystr);
+        return _Decompose()._Extension(_Mystr);
     }
 
     bool path::has_root_name() const noexcept {
@@ -221,19 +318,19 @@ namespace mjx {
     }
 
     bool path::has_parent_path() const noexcept {
-        return !mjfs_impl::_Get_parent_path(_Mystr).empty();
+        return !_Mystr.empty(); // a non-empty path is always its own parent if it contains no slashes
     }
 
     bool path::has_filename() const noexcept {
-        return !mjfs_impl::_Get_filename(_Mystr).empty();
+        return !_Decompose()._Filename(_Mystr).empty();
     }
 
     bool path::has_stem() const noexcept {
-        return !mjfs_impl::_Get_stem(_Mystr).empty();
+        return !_Decompose()._Stem(_Mystr).empty();
     }
 
     bool path::has_extension() const noexcept {
-        return !mjfs_impl::_Get_extension(_Mystr).empty();
+        return _Decompose()._Extension_length > 0;
     }
 
     bool path::is_absolute() const noexcept {
@@ -272,16 +369,135 @@ namespace mjx {
         return iterator{nullptr};
     }
 
+    path path::from_utf8(const utf8_string_view _Str, format _Fmt) {
+        return path{_Str, _Fmt};
+    }
+
+    bool path::from_utf8(const utf8_string_view _Str, path& _Path, format _Fmt) {
+        size_t _Length;
+        if (!mjfs_impl::_Utf8_to_utf16_length(_Str.data(), _Str.size(), _Length)) {
+            return false;
+        }
+
+        string_type _Buf(_Length, L'\0');
+        mjfs_impl::_Utf8_to_utf16(_Str.data(), _Str.size(), _Buf.data());
+        _Path = path{::std::move(_Buf), _Fmt};
+        return true;
+    }
+
     bool operator==(const path& _Left, const path& _Right) {
         return _Left.native() == _Right.native();
     }
 
-    path operator/(const path& _Left, const path& _Right) {
-        path _Path = _Left;
-        _Path     /= _Right;
+    ::std::weak_ordering operator<=>(const path& _Left, const path& _Right) noexcept {
+        const int _Result = _Left.compare(_Right);
+        if (_Result < 0) {
+            return ::std::weak_ordering::less;
+        } else if (_Result > 0) {
+            return ::std::weak_ordering::greater;
+        } else {
+            return ::std::weak_ordering::equivalent;
+        }
+    }
+
+    path _Join_paths(const _Path_join_part* const _Parts, const size_t _Count) {
+        // Note: Joining behaves exactly like applying operator/= from left to right, but the final
+        //       length is computed first, so the result is allocated only once. An absolute part
+        //       replaces everything before it, so the parts before the last absolute one are skipped.
+        size_t _First = 0;
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            if (mjfs_impl::_Has_drive_and_slash(_Parts[_Idx]._Str)) {
+                _First = _Idx;
+            }
+        }
+
+        size_t _Length = 0;
+        wchar_t _Last  = L'\0';
+        for (size_t _Idx = _First; _Idx < _Count; ++_Idx) {
+            const unicode_string_view _Str = _Parts[_Idx]._Str;
+            if (_Str.empty()) { // nothing to append
+                continue;
+            }
+
+            if (_Length > 0 && !mjfs_impl::_Is_slash(_Last) && !mjfs_impl::_Is_slash(_Str[0])) {
+                ++_Length; // separator between the parts
+            }
+
+            _Length += _Str.size();
+            _Last    = _Str[_Str.size() - 1];
+        }
+
+        unicode_string _Result(_Length, L'\0');
+        wchar_t* _Dest = _Result.data();
+        for (size_t _Idx = _First; _Idx < _Count; ++_Idx) {
+            const unicode_string_view _Str = _Parts[_Idx]._Str;
+            if (_Str.empty()) {
+                continue;
+            }
+
+            if (_Dest != _Result.data() && !mjfs_impl::_Is_slash(*(_Dest - 1))
+                && !mjfs_impl::_Is_slash(_Str[0])) {
+                *_Dest++ = path::preferred_separator; // separator between the parts
+            }
+
+            if (_Parts[_Idx]._Raw) { // apply the auto format, as if the part was converted to a path
+                for (const wchar_t _Ch : _Str) {
+                    *_Dest++ = _Ch == L'/' ? path::preferred_separator : _Ch;
+                }
+            } else {
+                ::memcpy(_Dest, _Str.data(), _Str.size() * sizeof(wchar_t));
+                _Dest += _Str.size();
+            }
+        }
+
+        path _Path;
+        _Path.assign(::std::move(_Result));
         return _Path;
     }
 
+    path operator/(const path& _Left, const path& _Right) {
+        const _Path_join_part _Parts[2] = {_Make_path_join_part(_Left), _Make_path_join_part(_Right)};
+        return _Join_paths(_Parts, 2);
+    }
+
+    size_t hash_value(const path& _Path) noexcept {
+        return mjfs_impl::_Narrow_hash(mjfs_impl::_Hash_path_string(_Path.native()));
+    }
+
+    size_t path_hash::operator()(const path& _Path) const noexcept {
+        return ::mjx::hash_value(_Path);
+    }
+
+    size_t path_hash::operator()(const unicode_string_view _Str) const noexcept {
+        return mjfs_impl::_Narrow_hash(mjfs_impl::_Hash_path_string(_Str));
+    }
+
+    bool path_equal::operator()(const path& _Left, const path& _Right) const noexcept {
+        return _Left.native().view() == _Right.native().view();
+    }
+
+    bool path_equal::operator()(
+        const unicode_string_view _Left, const unicode_string_view _Right) const noexcept {
+        return _Left == _Right;
+    }
+
+    size_t path_insensitive_hash::operator()(const path& _Path) const noexcept {
+        return mjfs_impl::_Narrow_hash(mjfs_impl::_Hash_path_string_insensitive(_Path.native()));
+    }
+
+    size_t path_insensitive_hash::operator()(const unicode_string_view _Str) const noexcept {
+        return mjfs_impl::_Narrow_hash(mjfs_impl::_Hash_path_string_insensitive(_Str));
+    }
+
+    bool path_insensitive_equal::operator()(const path& _Left, const path& _Right) const noexcept {
+        return mjfs_impl::_Equal_path_strings_insensitive(_Left.native(), _Right.native());
+    }
+
+    bool path_insensitive_equal::operator()(
+        const unicode_string_view _Left, const unicode_string_view _Right) const noexcept {
+        return mjfs_impl::_Equal_path_strings_insensitive(_Left, _Right);
+    }
+
     path_iterator::path_iterator() noexcept : _Mypath(nullptr), _Myelem(), _Myoff(0) {}
 
     path_iterator::path_iterator(const path_iterator& _Other)
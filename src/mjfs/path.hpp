@@ -6,12 +6,47 @@
 #pragma once
 #ifndef _MJFS_PATH_HPP_
 #define _MJFS_PATH_HPP_
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <mjfs/api.hpp>
 #include <mjstr/string.hpp>
 #include <mjstr/string_view.hpp>
 #include <type_traits>
 
 namespace mjx {
+    namespace mjfs_impl {
+        struct _Path_decomposition;
+
+        constexpr bool _Is_path_slash(const wchar_t _Ch) noexcept {
+            return _Ch == L'\\' || _Ch == L'/';
+        }
+
+        constexpr size_t _Find_last_path_slash(const wchar_t* const _Str, size_t _Size) noexcept {
+            while (_Size > 0) {
+                if (_Is_path_slash(_Str[--_Size])) {
+                    return _Size;
+                }
+            }
+
+            return static_cast<size_t>(-1); // not found
+        }
+
+        constexpr size_t _Path_extension_length(const wchar_t* const _Name, const size_t _Size) noexcept {
+            // Note: The extension starts at the last dot of the filename. A dot at the beginning
+            //       of the filename doesn't start an extension, so "." and ".." have no extension either.
+            for (size_t _Idx = _Size; _Idx > 1; --_Idx) {
+                if (_Name[_Idx - 1] == L'.') {
+                    return _Size == 2 && _Name[0] == L'.' ? 0 : _Size - _Idx + 1; // ".." has no extension
+                }
+            }
+
+            return 0;
+        }
+    } // namespace mjfs_impl
+
     template <class _Source>
     inline constexpr bool _Is_valid_path_source = false;
 
@@ -24,8 +59,35 @@ namespace mjx {
     template <class _Source>
     concept path_source = _Is_valid_path_source<_Source>;
 
+    class path;
     class path_iterator;
 
+    struct _Path_join_part { // a single operand of a chained path concatenation
+        unicode_string_view _Str;
+        bool _Raw; // true if the operand is not a path yet and must be formatted
+    };
+
+    _Path_join_part _Make_path_join_part(const path& _Path) noexcept;
+
+    inline _Path_join_part _Make_path_join_part(const unicode_string_view _Str) noexcept {
+        return _Path_join_part{_Str, true};
+    }
+
+    inline _Path_join_part _Make_path_join_part(const unicode_string& _Str) noexcept {
+        return _Path_join_part{_Str, true};
+    }
+
+    inline _Path_join_part _Make_path_join_part(const wchar_t* const _Str) noexcept {
+        return _Path_join_part{unicode_string_view{_Str}, true};
+    }
+
+    template <class _Ty>
+    concept _Path_join_operand = requires(const _Ty& _Val) {
+        _Make_path_join_part(_Val);
+    };
+
+    _MJFS_API path _Join_paths(const _Path_join_part* const _Parts, const size_t _Count);
+
     class _MJFS_API path { // filesystem path representation
     public:
         using value_type     = wchar_t;
@@ -49,8 +111,13 @@ namespace mjx {
         path(const value_type* const _Str, format _Fmt = auto_format);
         path(string_type&& _Str, format _Fmt = auto_format) noexcept;
 
+        // Note: The native encoding is UTF-16, so UTF-8 sources are converted once during construction
+        //       and c_str() can be passed to the system without any further conversion.
+        //       If the source is not valid UTF-8, the path is left empty.
+        explicit path(const utf8_string_view _Str, format _Fmt = auto_format);
+
         template <path_source _Source>
-        path(const _Source& _Src, format _Fmt = auto_format) : _Mystr(_Src.data(), _Src.size()) {
+        path(const _Source& _Src, format _Fmt = auto_format) : _Mystr(_Src.data(), _Src.size()), _Myparts(0) {
             _Apply_format(_Fmt);
         }
 
@@ -60,6 +127,7 @@ namespace mjx {
         template <path_source _Source>
         path& operator=(const _Source& _Src) {
             _Mystr.assign(_Src.data(), _Src.size());
+            _Invalidate_parts();
             return *this;
         }
 
@@ -72,6 +140,7 @@ namespace mjx {
         template <path_source _Source>
         path& assign(const _Source& _Src) {
             _Mystr.assign(_Src.data(), _Src.size());
+            _Invalidate_parts();
             return *this;
         }
 
@@ -96,12 +165,14 @@ namespace mjx {
         template <path_source _Source>
         path& operator+=(const _Source& _Src) {
             _Mystr += _Src;
+            _Invalidate_parts();
             return *this;
         }
 
         template <path_source _Source>
         path& concat(const _Source& _Src) {
             _Mystr += _Src;
+            _Invalidate_parts();
             return *this;
         }
 
@@ -129,6 +200,24 @@ namespace mjx {
         // returns the native version of the path (standard string)
         const string_type& native() const noexcept;
 
+        // returns the path converted to UTF-8, empty if the path is not valid UTF-16
+        utf8_string u8string() const;
+
+        // converts the path to UTF-8, returns false and leaves the string unchanged if the path
+        // is not valid UTF-16 (e.g. contains an unpaired surrogate)
+        bool u8string(utf8_string& _Str) const;
+
+        // returns the length of the path in UTF-8, 0 if the path is not valid UTF-16
+        size_t utf8_length() const noexcept;
+
+        // writes the path as UTF-8 into the buffer, the size must include the null-terminator
+        bool to_utf8(char* const _Buf, const size_t _Size) const noexcept;
+
+        // compares the paths element by element, both slashes are equivalent
+        int compare(const path& _Other) const noexcept;
+        int compare(const unicode_string_view _Str) const noexcept;
+        int compare(const value_type* const _Str) const noexcept;
+
         // checks if the path is empty
         bool empty() const noexcept;
 
@@ -192,6 +281,20 @@ namespace mjx {
         // returns an iterator to the end of the path
         iterator end() const;
 
+        // creates a path from a UTF-8 string, returns an empty path if the string is not valid UTF-8
+        static path from_utf8(const utf8_string_view _Str, format _Fmt = auto_format);
+
+        // creates a path from a UTF-8 string, returns false and leaves the path unchanged if the string
+        // is not valid UTF-8, so an invalid string can be told apart from an empty one
+        static bool from_utf8(const utf8_string_view _Str, path& _Path, format _Fmt = auto_format);
+
+        // joins the parts as if by operator/, the result is allocated exactly once
+        template <_Path_join_operand _Ty, _Path_join_operand... _Types>
+        static path join(const _Ty& _First, const _Types&... _Rest) {
+            const _Path_join_part _Parts[] = {_Make_path_join_part(_First), _Make_path_join_part(_Rest)...};
+            return _Join_paths(_Parts, sizeof...(_Types) + 1);
+        }
+
     private:
         // applies the specified format
         void _Apply_format(const format _Fmt) noexcept;
@@ -199,12 +302,57 @@ namespace mjx {
         // replaces the specifed slashes with a replacement
         void _Replace_slashes_with(const wchar_t _Slash, const wchar_t _Replacement) noexcept;
 
+        // returns the offsets of the path components, computes them only once after each modification
+        mjfs_impl::_Path_decomposition _Decompose() const noexcept;
+
+        // discards the cached offsets, must be called after each modification
+        void _Invalidate_parts() noexcept {
+            _Myparts.store(0, ::std::memory_order_relaxed);
+        }
+
         string_type _Mystr;
+
+        // Note: The offsets are computed lazily by const member functions, so the cache must be mutable.
+        //       It is packed into a single atomic integer, concurrent queries may both compute
+        //       the offsets, but they always store the same value.
+#pragma warning(suppress : 4251) // C4251: std::atomic<uint64_t> needs to have dll-interface
+        mutable ::std::atomic<uint64_t> _Myparts;
     };
 
+    inline _Path_join_part _Make_path_join_part(const path& _Path) noexcept {
+        return _Path_join_part{_Path.native(), false};
+    }
+
     _MJFS_API bool operator==(const path& _Left, const path& _Right);
     _MJFS_API path operator/(const path& _Left, const path& _Right);
 
+    // Note: The ordering is weak, paths that differ only in the kind of separators are equivalent,
+    //       but not equal, because operator== compares the native strings.
+    _MJFS_API ::std::weak_ordering operator<=>(const path& _Left, const path& _Right) noexcept;
+
+    // computes the hash of the path, consistent with operator==
+    _MJFS_API size_t hash_value(const path& _Path) noexcept;
+
+    struct _MJFS_API path_hash { // hashes paths exactly as they are stored
+        size_t operator()(const path& _Path) const noexcept;
+        size_t operator()(const unicode_string_view _Str) const noexcept;
+    };
+
+    struct _MJFS_API path_equal { // compares paths exactly as they are stored
+        bool operator()(const path& _Left, const path& _Right) const noexcept;
+        bool operator()(const unicode_string_view _Left, const unicode_string_view _Right) const noexcept;
+    };
+
+    struct _MJFS_API path_insensitive_hash { // hashes paths ignoring case, both slashes are equivalent
+        size_t operator()(const path& _Path) const noexcept;
+        size_t operator()(const unicode_string_view _Str) const noexcept;
+    };
+
+    struct _MJFS_API path_insensitive_equal { // compares paths ignoring case, both slashes are equivalent
+        bool operator()(const path& _Left, const path& _Right) const noexcept;
+        bool operator()(const unicode_string_view _Left, const unicode_string_view _Right) const noexcept;
+    };
+
     class _MJFS_API path_iterator { // input iterator for path
     public:
         using value_type        = path;
@@ -253,4 +401,13 @@ namespace mjx {
     _MJFS_API bool current_path(const path& _New_path);
 } // namespace mjx
 
+namespace std {
+    template <>
+    struct hash<::mjx::path> {
+        size_t operator()(const ::mjx::path& _Path) const noexcept {
+            return ::mjx::hash_value(_Path);
+        }
+    };
+} // namespace std
+
 #endif // _MJFS_PATH_HPP_
\ No newline at end of file
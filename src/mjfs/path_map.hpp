@@ -0,0 +1,284 @@
+// path_map.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_PATH_MAP_HPP_
+#define _MJFS_PATH_MAP_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    template <class _Hasher, class _Keyeq>
+    class _Path_table { // open-addressing index over keys stored in a contiguous arena
+    public:
+        static constexpr size_t _Npos = static_cast<size_t>(-1);
+
+        _Path_table() noexcept : _Myarena(), _Myentries(), _Myslots(), _Myhasher(), _Mykeyeq() {}
+
+        size_t _Size() const noexcept {
+            return _Myentries.size();
+        }
+
+        unicode_string_view _Key_at(const size_t _Idx) const noexcept {
+            const _Entry& _Target = _Myentries[_Idx];
+            return unicode_string_view{_Myarena.data() + _Target._Offset, _Target._Length};
+        }
+
+        size_t _Find(const unicode_string_view _Key) const noexcept {
+            if (_Myslots.empty()) {
+                return _Npos;
+            }
+
+            const size_t _Hash = _Myhasher(_Key);
+            const size_t _Mask = _Myslots.size() - 1;
+            for (size_t _Pos = _Hash & _Mask;; _Pos = (_Pos + 1) & _Mask) {
+                const _Slot& _Current = _Myslots[_Pos];
+                if (_Current._Index == 0) { // reached an empty slot, the key is not present
+                    return _Npos;
+                }
+
+                if (_Current._Tag == static_cast<uint32_t>(_Hash)
+                    && _Mykeyeq(_Key_at(_Current._Index - 1), _Key)) {
+                    return _Current._Index - 1;
+                }
+            }
+        }
+
+        ::std::pair<size_t, bool> _Insert(const unicode_string_view _Key) {
+            if ((_Myentries.size() + 1) * 4 > _Myslots.size() * 3) { // keep the load factor below 0.75
+                _Rehash(_Myslots.empty() ? _Min_slots : _Myslots.size() * 2);
+            }
+
+            const size_t _Hash = _Myhasher(_Key);
+            const size_t _Mask = _Myslots.size() - 1;
+            size_t _Pos        = _Hash & _Mask;
+            for (;; _Pos = (_Pos + 1) & _Mask) {
+                const _Slot& _Current = _Myslots[_Pos];
+                if (_Current._Index == 0) {
+                    break;
+                }
+
+                if (_Current._Tag == static_cast<uint32_t>(_Hash)
+                    && _Mykeyeq(_Key_at(_Current._Index - 1), _Key)) {
+                    return {_Current._Index - 1, false}; // already present
+                }
+            }
+
+            const size_t _Idx = _Myentries.size();
+            _Myentries.push_back(_Entry{_Hash, _Myarena.size(), _Key.size()});
+            _Myarena.insert(_Myarena.end(), _Key.data(), _Key.data() + _Key.size());
+            _Myslots[_Pos] = _Slot{static_cast<uint32_t>(_Idx + 1), static_cast<uint32_t>(_Hash)};
+            return {_Idx, true};
+        }
+
+        void _Erase_last() noexcept {
+            // Note: The most recently inserted key always occupies the slot that was empty when
+            //       it was inserted, so no other key probes past it and the slot can be cleared.
+            const size_t _Idx  = _Myentries.size() - 1;
+            const size_t _Mask = _Myslots.size() - 1;
+            size_t _Pos        = _Myentries[_Idx]._Hash & _Mask;
+            while (_Myslots[_Pos]._Index != _Idx + 1) {
+                _Pos = (_Pos + 1) & _Mask;
+            }
+
+            _Myslots[_Pos] = _Slot{0, 0};
+            _Myarena.resize(_Myentries[_Idx]._Offset);
+            _Myentries.pop_back();
+        }
+
+        void _Reserve(const size_t _Count) {
+            _Myentries.reserve(_Count);
+            size_t _New_size = _Min_slots;
+            while (_New_size * 3 < _Count * 4) {
+                _New_size *= 2;
+            }
+
+            if (_New_size > _Myslots.size()) {
+                _Rehash(_New_size);
+            }
+        }
+
+        void _Clear() noexcept {
+            _Myarena.clear();
+            _Myentries.clear();
+            _Myslots.clear();
+        }
+
+    private:
+        struct _Entry {
+            size_t _Hash; // cached hash, used when rehashing
+            size_t _Offset; // offset of the key in the arena
+            size_t _Length; // length of the key
+        };
+
+        struct _Slot {
+            uint32_t _Index; // entry index + 1, 0 means an empty slot
+            uint32_t _Tag; // lower bits of the hash, avoids most key comparisons
+        };
+
+        static constexpr size_t _Min_slots = 16;
+
+        void _Rehash(const size_t _New_size) {
+            ::std::vector<_Slot> _New_slots(_New_size, _Slot{0, 0});
+            const size_t _Mask = _New_size - 1;
+            for (size_t _Idx = 0; _Idx < _Myentries.size(); ++_Idx) {
+                const size_t _Hash = _Myentries[_Idx]._Hash;
+                size_t _Pos        = _Hash & _Mask;
+                while (_New_slots[_Pos]._Index != 0) {
+                    _Pos = (_Pos + 1) & _Mask;
+                }
+
+                _New_slots[_Pos] = _Slot{static_cast<uint32_t>(_Idx + 1), static_cast<uint32_t>(_Hash)};
+            }
+
+            _Myslots.swap(_New_slots);
+        }
+
+        ::std::vector<wchar_t> _Myarena; // all keys stored back-to-back
+        ::std::vector<_Entry> _Myentries; // keys in the insertion order
+        ::std::vector<_Slot> _Myslots; // open-addressing index (linear probing)
+        _Hasher _Myhasher;
+        _Keyeq _Mykeyeq;
+    };
+
+    template <class _Hasher = path_hash, class _Keyeq = path_equal>
+    class path_set { // append-only set of paths, keys are stored in a contiguous arena
+    public:
+        using size_type = size_t;
+
+        path_set() noexcept : _Mytable() {}
+
+        // returns the number of stored paths
+        size_type size() const noexcept {
+            return _Mytable._Size();
+        }
+
+        // checks whether the set is empty
+        bool empty() const noexcept {
+            return _Mytable._Size() == 0;
+        }
+
+        // returns the path at the specified position (insertion order), valid until the next insertion
+        unicode_string_view key(const size_type _Idx) const noexcept {
+            return _Mytable._Key_at(_Idx);
+        }
+
+        // checks whether the set contains the path
+        bool contains(const unicode_string_view _Key) const noexcept {
+            return _Mytable._Find(_Key) != _Mytable._Npos;
+        }
+
+        // inserts the path, returns true if it wasn't already present
+        bool insert(const unicode_string_view _Key) {
+            return _Mytable._Insert(_Key).second;
+        }
+
+        // reserves space for at least the specified number of paths
+        void reserve(const size_type _Count) {
+            _Mytable._Reserve(_Count);
+        }
+
+        // removes all paths
+        void clear() noexcept {
+            _Mytable._Clear();
+        }
+
+    private:
+        _Path_table<_Hasher, _Keyeq> _Mytable;
+    };
+
+    template <class _Ty, class _Hasher = path_hash, class _Keyeq = path_equal>
+    class path_map { // append-only map keyed by paths, keys are stored in a contiguous arena
+    public:
+        using size_type   = size_t;
+        using mapped_type = _Ty;
+
+        path_map() noexcept(::std::is_nothrow_default_constructible_v<_Ty>) : _Mytable(), _Myvals() {}
+
+        // returns the number of stored elements
+        size_type size() const noexcept {
+            return _Mytable._Size();
+        }
+
+        // checks whether the map is empty
+        bool empty() const noexcept {
+            return _Mytable._Size() == 0;
+        }
+
+        // returns the key at the specified position (insertion order), valid until the next insertion
+        unicode_string_view key(const size_type _Idx) const noexcept {
+            return _Mytable._Key_at(_Idx);
+        }
+
+        // returns the value at the specified position (insertion order)
+        mapped_type& value(const size_type _Idx) noexcept {
+            return _Myvals[_Idx];
+        }
+
+        const mapped_type& value(const size_type _Idx) const noexcept {
+            return _Myvals[_Idx];
+        }
+
+        // checks whether the map contains the key
+        bool contains(const unicode_string_view _Key) const noexcept {
+            return _Mytable._Find(_Key) != _Mytable._Npos;
+        }
+
+        // returns a pointer to the value associated with the key, or null if the key is not present
+        mapped_type* find(const unicode_string_view _Key) noexcept {
+            const size_t _Idx = _Mytable._Find(_Key);
+            return _Idx != _Mytable._Npos ? &_Myvals[_Idx] : nullptr;
+        }
+
+        const mapped_type* find(const unicode_string_view _Key) const noexcept {
+            const size_t _Idx = _Mytable._Find(_Key);
+            return _Idx != _Mytable._Npos ? &_Myvals[_Idx] : nullptr;
+        }
+
+        // inserts a new element if the key is not present, returns the value and whether it was inserted
+        template <class... _Types>
+        ::std::pair<mapped_type*, bool> emplace(const unicode_string_view _Key, _Types&&... _Args) {
+            const auto [_Idx, _Inserted] = _Mytable._Insert(_Key);
+            if (_Inserted) {
+                try {
+                    _Myvals.emplace_back(::std::forward<_Types>(_Args)...);
+                } catch (...) { // keep the keys and values in sync
+                    _Mytable._Erase_last();
+                    throw;
+                }
+            }
+
+            return {&_Myvals[_Idx], _Inserted};
+        }
+
+        // returns the value associated with the key, inserts a default value if the key is not present
+        mapped_type& operator[](const unicode_string_view _Key) {
+            return *emplace(_Key).first;
+        }
+
+        // reserves space for at least the specified number of elements
+        void reserve(const size_type _Count) {
+            _Mytable._Reserve(_Count);
+            _Myvals.reserve(_Count);
+        }
+
+        // removes all elements
+        void clear() noexcept {
+            _Mytable._Clear();
+            _Myvals.clear();
+        }
+
+    private:
+        _Path_table<_Hasher, _Keyeq> _Mytable;
+        ::std::vector<_Ty> _Myvals;
+    };
+} // namespace mjx
+
+#endif // _MJFS_PATH_MAP_HPP_
\ No newline at end of file
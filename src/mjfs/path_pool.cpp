@@ -0,0 +1,263 @@
+// path_pool.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <mjfs/impl/path.hpp>
+#include <mjfs/impl/path_pool.hpp>
+#include <mjfs/path_pool.hpp>
+
+namespace mjx {
+    path_pool::path_pool() noexcept : _Mynodes(), _Myarena(), _Myslots() {}
+
+    path_pool::path_pool(const path_pool& _Other)
+        : _Mynodes(_Other._Mynodes), _Myarena(_Other._Myarena), _Myslots(_Other._Myslots) {}
+
+    path_pool::path_pool(path_pool&& _Other) noexcept
+        : _Mynodes(::std::move(_Other._Mynodes)), _Myarena(::std::move(_Other._Myarena)),
+        _Myslots(::std::move(_Other._Myslots)) {}
+
+    path_pool::~path_pool() noexcept {}
+
+    path_pool& path_pool::operator=(const path_pool& _Other) {
+        if (this != ::std::addressof(_Other)) {
+            _Mynodes = _Other._Mynodes;
+            _Myarena = _Other._Myarena;
+            _Myslots = _Other._Myslots;
+        }
+
+        return *this;
+    }
+
+    path_pool& path_pool::operator=(path_pool&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Mynodes = ::std::move(_Other._Mynodes);
+            _Myarena = ::std::move(_Other._Myarena);
+            _Myslots = ::std::move(_Other._Myslots);
+        }
+
+        return *this;
+    }
+
+    size_t path_pool::_Find_slot(
+        const handle_type _Parent, const unicode_string_view _Name, const size_t _Hash) const noexcept {
+        const size_t _Mask = _Myslots.size() - 1;
+        for (size_t _Pos = _Hash & _Mask;; _Pos = (_Pos + 1) & _Mask) {
+            if (_Myslots[_Pos] == 0) { // reached an empty slot, the node is not present
+                return _Pos;
+            }
+
+            const _Node& _Current = _Mynodes[_Myslots[_Pos] - 1];
+            if (_Current._Parent == _Parent && _Current._Name_length == _Name.size()
+                && ::memcmp(_Myarena.data() + _Current._Offset,
+                    _Name.data(), _Name.size() * sizeof(wchar_t)) == 0) {
+                return _Pos;
+            }
+        }
+    }
+
+    void path_pool::_Rehash(const size_t _New_size) {
+        // Note: The index stores only handles to keep it small, so the hashes are recomputed here.
+        //       Rehashing happens only when the number of nodes doubles, so the cost is amortized.
+        ::std::vector<handle_type> _New_slots(_New_size, 0);
+        const size_t _Mask = _New_size - 1;
+        for (size_t _Idx = 0; _Idx < _Mynodes.size(); ++_Idx) {
+            const _Node& _Current          = _Mynodes[_Idx];
+            const unicode_string_view _Name = name(static_cast<handle_type>(_Idx));
+            size_t _Pos                     = mjfs_impl::_Hash_path_node(_Current._Parent, _Name) & _Mask;
+            while (_New_slots[_Pos] != 0) {
+                _Pos = (_Pos + 1) & _Mask;
+            }
+
+            _New_slots[_Pos] = static_cast<handle_type>(_Idx + 1);
+        }
+
+        _Myslots.swap(_New_slots);
+    }
+
+    size_t path_pool::size() const noexcept {
+        return _Mynodes.size();
+    }
+
+    bool path_pool::empty() const noexcept {
+        return _Mynodes.empty();
+    }
+
+    void path_pool::reserve(const size_t _Nodes, const size_t _Chars) {
+        _Mynodes.reserve(_Nodes);
+        _Myarena.reserve(_Chars);
+        size_t _New_size = 16;
+        while (_New_size * 3 < _Nodes * 4) { // keep the load factor below 0.75
+            _New_size *= 2;
+        }
+
+        if (_New_size > _Myslots.size()) {
+            _Rehash(_New_size);
+        }
+    }
+
+    void path_pool::clear() noexcept {
+        _Mynodes.clear();
+        _Myarena.clear();
+        _Myslots.clear();
+    }
+
+    path_pool::handle_type path_pool::_Intern(const handle_type _Parent, const unicode_string_view _Name) {
+        if (_Name.empty() || (_Parent != npos && _Parent >= _Mynodes.size())) {
+            return npos;
+        }
+
+        size_t _Path_length = _Name.size();
+        if (_Parent != npos) {
+            const unicode_string_view _Parent_name = name(_Parent);
+            _Path_length += _Mynodes[_Parent]._Path_length;
+            if (mjfs_impl::_Needs_path_separator(_Parent_name, _Name)) {
+                ++_Path_length;
+            }
+        }
+
+        if (_Path_length > 0xFFFF) { // the path is too long to be represented
+            return npos;
+        }
+
+        const size_t _Hash = mjfs_impl::_Hash_path_node(_Parent, _Name);
+        if (!_Myslots.empty()) {
+            const size_t _Pos = _Find_slot(_Parent, _Name, _Hash);
+            if (_Myslots[_Pos] != 0) { // already interned
+                return _Myslots[_Pos] - 1;
+            }
+        }
+
+        if (_Mynodes.size() >= npos - 1 || _Myarena.size() + _Name.size() > 0xFFFF'FFFF) { // pool is full
+            return npos;
+        }
+
+        if ((_Mynodes.size() + 1) * 4 > _Myslots.size() * 3) { // keep the load factor below 0.75
+            _Rehash(_Myslots.empty() ? 16 : _Myslots.size() * 2);
+        }
+
+        const handle_type _Handle = static_cast<handle_type>(_Mynodes.size());
+        _Mynodes.push_back(_Node{_Parent, static_cast<uint32_t>(_Myarena.size()),
+            static_cast<uint16_t>(_Name.size()), static_cast<uint16_t>(_Path_length)});
+        _Myarena.insert(_Myarena.end(), _Name.data(), _Name.data() + _Name.size());
+        _Myslots[_Find_slot(_Parent, _Name, _Hash)] = _Handle + 1;
+        return _Handle;
+    }
+
+    path_pool::handle_type path_pool::intern(const handle_type _Parent, const unicode_string_view _Name) {
+        // Note: A name with a separator would be ambiguous, the root name and the root directory
+        //       are the only nodes that hold separators, and only intern(const path&) creates them.
+        if (mjfs_impl::_Find_first_slash(_Name) != unicode_string_view::npos) {
+            return npos;
+        }
+
+        return _Intern(_Parent, _Name);
+    }
+
+    path_pool::handle_type path_pool::intern(const path& _Path) {
+        const unicode_string_view _Str       = _Path.native();
+        const size_t _Size                   = _Str.size();
+        const unicode_string_view _Root_name = mjfs_impl::_Get_pool_root_name(_Str);
+        handle_type _Handle                  = npos;
+        size_t _Off                          = 0;
+        if (!_Root_name.empty()) {
+            _Handle = _Intern(npos, _Root_name);
+            if (_Handle == npos) {
+                return npos;
+            }
+
+            _Off = _Root_name.size();
+        }
+
+        if (_Off < _Size && mjfs_impl::_Is_slash(_Str[_Off])) { // root directory is always stored as "\"
+            _Handle = _Intern(_Handle, unicode_string_view{L"\\", 1});
+            if (_Handle == npos) {
+                return npos;
+            }
+
+            ++_Off;
+        }
+
+        while (_Off < _Size) {
+            if (mjfs_impl::_Is_slash(_Str[_Off])) { // skip redundant slashes
+                ++_Off;
+                continue;
+            }
+
+            size_t _End = _Off;
+            while (_End < _Size && !mjfs_impl::_Is_slash(_Str[_End])) {
+                ++_End;
+            }
+
+            _Handle = _Intern(_Handle, _Str.substr(_Off, _End - _Off));
+            if (_Handle == npos) {
+                return npos;
+            }
+
+            _Off = _End;
+        }
+
+        return _Handle;
+    }
+
+    path_pool::handle_type path_pool::find(
+        const handle_type _Parent, const unicode_string_view _Name) const noexcept {
+        if (_Myslots.empty()) {
+            return npos;
+        }
+
+        const size_t _Pos = _Find_slot(_Parent, _Name, mjfs_impl::_Hash_path_node(_Parent, _Name));
+        return _Myslots[_Pos] != 0 ? _Myslots[_Pos] - 1 : npos;
+    }
+
+    path_pool::handle_type path_pool::parent(const handle_type _Handle) const noexcept {
+        return _Handle < _Mynodes.size() ? _Mynodes[_Handle]._Parent : npos;
+    }
+
+    unicode_string_view path_pool::name(const handle_type _Handle) const noexcept {
+        if (_Handle >= _Mynodes.size()) {
+            return unicode_string_view{};
+        }
+
+        const _Node& _Target = _Mynodes[_Handle];
+        return unicode_string_view{_Myarena.data() + _Target._Offset, _Target._Name_length};
+    }
+
+    size_t path_pool::length(const handle_type _Handle) const noexcept {
+        return _Handle < _Mynodes.size() ? _Mynodes[_Handle]._Path_length : 0;
+    }
+
+    bool path_pool::copy_path(
+        const handle_type _Handle, wchar_t* const _Buf, const size_t _Size) const noexcept {
+        if (_Handle >= _Mynodes.size() || _Size <= _Mynodes[_Handle]._Path_length) {
+            return false;
+        }
+
+        // Note: The path is built from the end, each node is visited exactly once.
+        size_t _Pos = _Mynodes[_Handle]._Path_length;
+        _Buf[_Pos]  = L'\0';
+        for (handle_type _Current = _Handle; _Current != npos; _Current = _Mynodes[_Current]._Parent) {
+            const unicode_string_view _Name = name(_Current);
+            _Pos -= _Name.size();
+            ::memcpy(_Buf + _Pos, _Name.data(), _Name.size() * sizeof(wchar_t));
+            const handle_type _Parent = _Mynodes[_Current]._Parent;
+            if (_Parent != npos && mjfs_impl::_Needs_path_separator(name(_Parent), _Name)) {
+                _Buf[--_Pos] = path::preferred_separator;
+            }
+        }
+
+        return true;
+    }
+
+    path path_pool::to_path(const handle_type _Handle) const {
+        const size_t _Length = length(_Handle);
+        if (_Length == 0) {
+            return path{};
+        }
+
+        unicode_string _Str(_Length, L'\0');
+        copy_path(_Handle, _Str.data(), _Length + 1); // the string always stores a null-terminator
+        return path{::std::move(_Str), path::native_format};
+    }
+} // namespace mjx
@@ -0,0 +1,96 @@
+// path_pool.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_PATH_POOL_HPP_
+#define _MJFS_PATH_POOL_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    class _MJFS_API path_pool { // interning table that stores each path component once, as (parent, name)
+    public:
+        using handle_type = uint32_t;
+
+        static constexpr handle_type npos = static_cast<handle_type>(-1); // invalid handle / no parent
+
+        path_pool() noexcept;
+        path_pool(const path_pool& _Other);
+        path_pool(path_pool&& _Other) noexcept;
+        ~path_pool() noexcept;
+
+        path_pool& operator=(const path_pool& _Other);
+        path_pool& operator=(path_pool&& _Other) noexcept;
+
+        // returns the number of interned nodes
+        size_t size() const noexcept;
+
+        // checks whether the pool is empty
+        bool empty() const noexcept;
+
+        // reserves space for the specified number of nodes and name characters
+        void reserve(const size_t _Nodes, const size_t _Chars);
+
+        // removes all nodes, invalidates all handles
+        void clear() noexcept;
+
+        // interns a single path component under the parent, returns npos on failure
+        // (a name that contains a separator is rejected)
+        handle_type intern(const handle_type _Parent, const unicode_string_view _Name);
+
+        // interns every component of the path, returns the handle of the last one or npos on failure
+        // (a UNC ("\\server\share") or device ("\\?\X:") prefix is interned as a single root name)
+        handle_type intern(const path& _Path);
+
+        // returns the handle of the component under the parent, or npos if it wasn't interned
+        handle_type find(const handle_type _Parent, const unicode_string_view _Name) const noexcept;
+
+        // returns the handle of the parent node, or npos if the node is a root
+        handle_type parent(const handle_type _Handle) const noexcept;
+
+        // returns the name of the node, valid until the next insertion
+        unicode_string_view name(const handle_type _Handle) const noexcept;
+
+        // returns the length of the full path (null-terminator not included)
+        size_t length(const handle_type _Handle) const noexcept;
+
+        // writes the full path into the buffer, the size must include the null-terminator
+        bool copy_path(const handle_type _Handle, wchar_t* const _Buf, const size_t _Size) const noexcept;
+
+        // returns the full path as a new path object
+        path to_path(const handle_type _Handle) const;
+
+    private:
+        struct _Node {
+            handle_type _Parent; // parent node, npos for roots
+            uint32_t _Offset; // offset of the name in the arena
+            uint16_t _Name_length; // length of the name
+            uint16_t _Path_length; // length of the full path
+        };
+
+        // finds the slot that holds the node or the empty slot where it should be inserted
+        size_t _Find_slot(
+            const handle_type _Parent, const unicode_string_view _Name, const size_t _Hash) const noexcept;
+
+        // interns a single node without validating its name
+        handle_type _Intern(const handle_type _Parent, const unicode_string_view _Name);
+
+        // rebuilds the index with the specified number of slots
+        void _Rehash(const size_t _New_size);
+
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<_Node> _Mynodes;
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<wchar_t> _Myarena; // all names stored back-to-back
+#pragma warning(suppress : 4251) // C4251: std::vector<T> needs to have dll-interface
+        ::std::vector<handle_type> _Myslots; // open-addressing index (linear probing), stores handle + 1
+    };
+} // namespace mjx
+
+#endif // _MJFS_PATH_POOL_HPP_
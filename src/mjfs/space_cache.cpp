@@ -0,0 +1,118 @@
+// space_cache.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <memory>
+#include <mjfs/impl/parallel.hpp>
+#include <mjfs/impl/space_cache.hpp>
+#include <mjfs/space_cache.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    space_reservation::space_reservation() noexcept : _Myvolume(), _Mysize(0) {}
+
+    space_reservation::space_reservation(space_reservation&& _Other) noexcept
+        : _Myvolume(::std::move(_Other._Myvolume)), _Mysize(_Other._Mysize) {
+        _Other._Mysize = 0;
+    }
+
+    space_reservation::~space_reservation() noexcept {
+        release();
+    }
+
+    space_reservation::space_reservation(
+        const smart_ptr<mjfs_impl::_Volume_space>& _Volume, const uint64_t _Size) noexcept
+        : _Myvolume(_Volume), _Mysize(_Size) {}
+
+    space_reservation& space_reservation::operator=(space_reservation&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            release();
+            _Myvolume      = ::std::move(_Other._Myvolume);
+            _Mysize        = _Other._Mysize;
+            _Other._Mysize = 0;
+        }
+
+        return *this;
+    }
+
+    space_reservation::operator bool() const noexcept {
+        return _Myvolume != nullptr;
+    }
+
+    uint64_t space_reservation::size() const noexcept {
+        return _Mysize;
+    }
+
+    void space_reservation::release() noexcept {
+        if (_Myvolume != nullptr) {
+            _Myvolume->_Reserved.fetch_sub(_Mysize, ::std::memory_order_relaxed);
+            _Myvolume.reset();
+            _Mysize = 0;
+        }
+    }
+
+    space_cache::space_cache(const uint64_t _Max_age)
+        : _Myimpl(::mjx::create_object<mjfs_impl::_Space_cache>(_Max_age)) {}
+
+    space_cache::space_cache(space_cache&& _Other) noexcept : _Myimpl(::std::move(_Other._Myimpl)) {}
+
+    space_cache::~space_cache() noexcept {}
+
+    space_cache& space_cache::operator=(space_cache&& _Other) noexcept {
+        _Myimpl = ::std::move(_Other._Myimpl);
+        return *this;
+    }
+
+    space_info space_cache::space(const path& _Target) {
+        const smart_ptr<mjfs_impl::_Volume_space> _Space = _Myimpl->_Find_volume(_Target);
+        return _Space != nullptr ? _Myimpl->_Get_space(*_Space) : space_info{0, 0, 0};
+    }
+
+    bool space_cache::space_batch(
+        const ::std::span<const path> _Targets, const ::std::span<space_info> _Spaces) {
+        if (_Targets.size() != _Spaces.size()) {
+            return false;
+        }
+
+        // resolve the volumes first, so that each stale volume is queried once
+        ::std::vector<smart_ptr<mjfs_impl::_Volume_space>> _Volumes(_Targets.size());
+        ::std::vector<mjfs_impl::_Volume_space*> _Stale;
+        const uint64_t _Now = ::GetTickCount64();
+        for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+            _Volumes[_Idx]                         = _Myimpl->_Find_volume(_Targets[_Idx]);
+            mjfs_impl::_Volume_space* const _Space = _Volumes[_Idx].get();
+            if (_Space != nullptr && _Myimpl->_Is_stale(*_Space, _Now)
+                && ::std::find(_Stale.begin(), _Stale.end(), _Space) == _Stale.end()) {
+                _Stale.push_back(_Space);
+            }
+        }
+
+        mjfs_impl::_Parallel_for(_Stale.size(), [&_Stale](const size_t _Idx) {
+            mjfs_impl::_Space_cache::_Refresh(*_Stale[_Idx]);
+        });
+        for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+            _Spaces[_Idx] = _Volumes[_Idx] != nullptr
+                ? mjfs_impl::_Space_cache::_Get_cached_space(*_Volumes[_Idx]) : space_info{0, 0, 0};
+        }
+
+        return true;
+    }
+
+    space_reservation space_cache::try_reserve(
+        const path& _Target, const uint64_t _Size, const uint64_t _Headroom) {
+        const smart_ptr<mjfs_impl::_Volume_space> _Space = _Myimpl->_Find_volume(_Target);
+        if (_Space == nullptr || !_Myimpl->_Try_reserve(*_Space, _Size, _Headroom)) {
+            return space_reservation{};
+        }
+
+        return space_reservation{_Space, _Size};
+    }
+
+    void space_cache::invalidate() noexcept {
+        _Myimpl->_Invalidate();
+    }
+} // namespace mjx
@@ -0,0 +1,87 @@
+// space_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_SPACE_CACHE_HPP_
+#define _MJFS_SPACE_CACHE_HPP_
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/path.hpp>
+#include <mjfs/status.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <span>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Space_cache;
+        struct _Volume_space;
+    } // namespace mjfs_impl
+
+    class space_cache;
+
+    // Note: A reservation shares the ownership of its volume's counter with the cache, so it may outlive
+    //       the cache that made it. Releasing it afterwards affects no other cache.
+    class _MJFS_API space_reservation { // space reserved on a volume, released on destruction
+    public:
+        space_reservation() noexcept;
+        space_reservation(space_reservation&& _Other) noexcept;
+        ~space_reservation() noexcept;
+
+        space_reservation& operator=(space_reservation&& _Other) noexcept;
+
+        space_reservation(const space_reservation&)            = delete;
+        space_reservation& operator=(const space_reservation&) = delete;
+
+        // checks whether the space was reserved
+        explicit operator bool() const noexcept;
+
+        // returns the number of reserved bytes
+        uint64_t size() const noexcept;
+
+        // gives the reserved space back, should be called once the data has been written
+        void release() noexcept;
+
+    private:
+        friend space_cache;
+
+        space_reservation(const smart_ptr<mjfs_impl::_Volume_space>& _Volume, const uint64_t _Size) noexcept;
+
+#pragma warning(suppress : 4251) // C4251: smart_ptr<_Volume_space> needs to have dll-interface
+        smart_ptr<mjfs_impl::_Volume_space> _Myvolume; // the volume the space is reserved on, null if none
+        uint64_t _Mysize;
+    };
+
+    class _MJFS_API space_cache { // caches the space of volumes, safe to use from multiple threads
+    public:
+        // Note: The maximum age is given in milliseconds. A volume whose space is older than that
+        //       is queried again. The reservations are local to the cache, other processes don't see them.
+        explicit space_cache(const uint64_t _Max_age = 1000);
+        space_cache(space_cache&& _Other) noexcept;
+        ~space_cache() noexcept;
+
+        space_cache& operator=(space_cache&& _Other) noexcept;
+
+        space_cache(const space_cache&)            = delete;
+        space_cache& operator=(const space_cache&) = delete;
+
+        // returns the space of the volume that contains the target, minus the reserved space
+        space_info space(const path& _Target);
+
+        // stores the space of each target's volume at the same position, each volume is queried once
+        bool space_batch(::std::span<const path> _Targets, ::std::span<space_info> _Spaces);
+
+        // reserves the space if the available space, minus the reservations and the headroom, is enough
+        space_reservation try_reserve(const path& _Target, const uint64_t _Size, const uint64_t _Headroom = 0);
+
+        // forces the next query of each volume to access the file system
+        void invalidate() noexcept;
+
+    private:
+#pragma warning(suppress : 4251) // C4251: unique_smart_ptr<_Space_cache> needs to have dll-interface
+        unique_smart_ptr<mjfs_impl::_Space_cache> _Myimpl;
+    };
+} // namespace mjx
+
+#endif // _MJFS_SPACE_CACHE_HPP_
@@ -0,0 +1,132 @@
+// static_path.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_STATIC_PATH_HPP_
+#define _MJFS_STATIC_PATH_HPP_
+#include <cstddef>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    template <size_t _Size>
+    class static_path { // path literal, normalized and decomposed at compile time
+    public:
+        static_assert(_Size > 0, "static_path requires a null-terminated string literal");
+
+        using value_type = wchar_t;
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Note: The size includes the null-terminator, as in the type of a string literal. The separators
+        //       are converted according to the format, and the filename and extension offsets are computed
+        //       once, so neither the conversion to path nor any decomposition query scans the string.
+        consteval static_path(const value_type (&_Str)[_Size], path::format _Fmt = path::auto_format) noexcept
+            : _Mydata{}, _Mylast_slash(npos), _Myext_length(0) {
+            const value_type _Slash       = _Fmt == path::generic_format ? L'\\' : L'/';
+            const value_type _Replacement = _Fmt == path::generic_format ? L'/' : L'\\';
+            for (size_t _Idx = 0; _Idx < _Size - 1; ++_Idx) {
+                _Mydata[_Idx] = _Str[_Idx] == _Slash ? _Replacement : _Str[_Idx];
+            }
+
+            _Mydata[_Size - 1] = L'\0';
+            _Mylast_slash      = mjfs_impl::_Find_last_path_slash(_Mydata, _Size - 1);
+            const size_t _Name = _Mylast_slash == npos ? 0 : _Mylast_slash + 1;
+            _Myext_length      = mjfs_impl::_Path_extension_length(_Mydata + _Name, _Size - 1 - _Name);
+        }
+
+        // returns the path, the string is copied exactly once
+        operator path() const {
+            path _Path;
+            _Path.assign(unicode_string{_Mydata, _Size - 1});
+            return _Path;
+        }
+
+        // returns the native version of the path (C-string)
+        constexpr const value_type* c_str() const noexcept {
+            return _Mydata;
+        }
+
+        // returns the native version of the path (string view)
+        unicode_string_view native() const noexcept {
+            return unicode_string_view{_Mydata, _Size - 1};
+        }
+
+        // returns the length of the path
+        constexpr size_t size() const noexcept {
+            return _Size - 1;
+        }
+
+        // checks if the path is empty
+        constexpr bool empty() const noexcept {
+            return _Size == 1;
+        }
+
+        // returns the offset of the filename, equal to size() if the path has no filename
+        constexpr size_t filename_offset() const noexcept {
+            return _Mylast_slash == npos ? 0 : _Mylast_slash + 1;
+        }
+
+        // returns the offset of the extension, equal to size() if the path has no extension
+        constexpr size_t extension_offset() const noexcept {
+            return _Size - 1 - _Myext_length;
+        }
+
+        // returns the length of the parent path
+        constexpr size_t parent_path_length() const noexcept {
+            // Note: The parent path is computed the same way as in path::parent_path(), a path without
+            //       slashes is its own parent and a slash at the beginning is the parent of the rest.
+            return _Mylast_slash == npos ? _Size - 1 : (_Mylast_slash == 0 ? 1 : _Mylast_slash);
+        }
+
+        // returns the filename path component
+        unicode_string_view filename() const noexcept {
+            return unicode_string_view{_Mydata + filename_offset(), _Size - 1 - filename_offset()};
+        }
+
+        // returns the stem path component (filename without the final extension)
+        unicode_string_view stem() const noexcept {
+            return unicode_string_view{_Mydata + filename_offset(), extension_offset() - filename_offset()};
+        }
+
+        // returns the file extension path component
+        unicode_string_view extension() const noexcept {
+            return unicode_string_view{_Mydata + extension_offset(), _Myext_length};
+        }
+
+        // returns the parent path
+        unicode_string_view parent_path() const noexcept {
+            return unicode_string_view{_Mydata, parent_path_length()};
+        }
+
+        // checks if the path has the filename
+        constexpr bool has_filename() const noexcept {
+            return filename_offset() < _Size - 1;
+        }
+
+        // checks if the path has the stem (filename without the final extension)
+        constexpr bool has_stem() const noexcept {
+            return extension_offset() > filename_offset();
+        }
+
+        // checks if the path has the extension
+        constexpr bool has_extension() const noexcept {
+            return _Myext_length > 0;
+        }
+
+        // checks if the path has the parent path
+        constexpr bool has_parent_path() const noexcept {
+            return _Size > 1;
+        }
+
+    private:
+        value_type _Mydata[_Size];
+        size_t _Mylast_slash; // position of the last slash, npos if there is none
+        size_t _Myext_length; // length of the extension, 0 if there is none
+    };
+} // namespace mjx
+
+#endif // _MJFS_STATIC_PATH_HPP_
@@ -40,6 +40,55 @@ namespace mjx {
         return mjfs_impl::_Get_reparse_tag(_Target.c_str()) == mjfs_impl::_File_reparse_tag::_Mount_point;
     }
 
+    file_status status(const path& _Target) {
+        return mjfs_impl::_Get_status(_Target.c_str());
+    }
+
+    file_status symlink_status(const path& _Target) {
+        return mjfs_impl::_Get_symlink_status(_Target.c_str());
+    }
+
+    bool status_batch(const ::std::span<const path> _Targets, const ::std::span<file_status> _Statuses) {
+        return mjfs_impl::_Get_status_batch(_Targets, _Statuses, true);
+    }
+
+    bool symlink_status_batch(
+        const ::std::span<const path> _Targets, const ::std::span<file_status> _Statuses) {
+        return mjfs_impl::_Get_status_batch(_Targets, _Statuses, false);
+    }
+
+    bool status_known(const file_status& _Status) noexcept {
+        return _Status.type != file_type::none;
+    }
+
+    bool exists(const file_status& _Status) noexcept {
+        return _Status.type != file_type::none && _Status.type != file_type::not_found;
+    }
+
+    bool is_directory(const file_status& _Status) noexcept {
+        return _Status.type == file_type::directory;
+    }
+
+    bool is_regular_file(const file_status& _Status) noexcept {
+        return _Status.type == file_type::regular;
+    }
+
+    bool is_symlink(const file_status& _Status) noexcept {
+        return _Status.type == file_type::symlink;
+    }
+
+    bool is_junction(const file_status& _Status) noexcept {
+        return _Status.type == file_type::junction;
+    }
+
+    bool is_hidden(const file_status& _Status) noexcept {
+        return exists(_Status) && _Has_bits(_Status.attributes, file_attribute::hidden);
+    }
+
+    bool is_readonly(const file_status& _Status) noexcept {
+        return exists(_Status) && _Has_bits(_Status.attributes, file_attribute::readonly);
+    }
+
     space_info space(const path& _Target) {
         if (!_Target.has_root_path()) {
             return space_info{0, 0, 0};
@@ -8,7 +8,9 @@
 #define _MJFS_STATUS_HPP_
 #include <cstdint>
 #include <mjfs/api.hpp>
+#include <mjfs/file.hpp>
 #include <mjfs/path.hpp>
+#include <span>
 
 namespace mjx {
     _MJFS_API bool exists(const path& _Target);
@@ -17,6 +19,46 @@ namespace mjx {
     _MJFS_API bool is_symlink(const path& _Target);
     _MJFS_API bool is_junction(const path& _Target);
 
+    enum class file_type : unsigned char {
+        none, // the status couldn't be obtained
+        not_found,
+        regular,
+        directory,
+        symlink,
+        junction
+    };
+
+    struct file_status { // the type, attributes, size and times of a file, obtained at once
+        file_type type;
+        file_attribute attributes;
+        uint64_t size;
+        uint64_t creation_time; // in 100-nanosecond intervals since January 1, 1601 (UTC)
+        uint64_t last_access_time;
+        uint64_t last_write_time;
+    };
+
+    // returns the status of the target, symbolic links and junctions are followed
+    _MJFS_API file_status status(const path& _Target);
+
+    // returns the status of the target, symbolic links and junctions are not followed
+    _MJFS_API file_status symlink_status(const path& _Target);
+
+    // Note: The batch functions store the status of each target at the same position, and return false
+    //       if the sizes differ. The paths are grouped by their directory, each directory with many
+    //       targets is enumerated once, and the groups are processed concurrently.
+    _MJFS_API bool status_batch(::std::span<const path> _Targets, ::std::span<file_status> _Statuses);
+    _MJFS_API bool symlink_status_batch(::std::span<const path> _Targets, ::std::span<file_status> _Statuses);
+
+    // Note: The following functions only inspect the status, so the file system is not accessed again.
+    _MJFS_API bool status_known(const file_status& _Status) noexcept;
+    _MJFS_API bool exists(const file_status& _Status) noexcept;
+    _MJFS_API bool is_directory(const file_status& _Status) noexcept;
+    _MJFS_API bool is_regular_file(const file_status& _Status) noexcept;
+    _MJFS_API bool is_symlink(const file_status& _Status) noexcept;
+    _MJFS_API bool is_junction(const file_status& _Status) noexcept;
+    _MJFS_API bool is_hidden(const file_status& _Status) noexcept;
+    _MJFS_API bool is_readonly(const file_status& _Status) noexcept;
+
     struct space_info {
         uintmax_t capacity;
         uintmax_t free;
@@ -0,0 +1,255 @@
+// tree_snapshot.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <mjfs/impl/file.hpp>
+#include <mjfs/impl/file_id.hpp>
+#include <mjfs/impl/file_stream.hpp>
+#include <mjfs/impl/tinywin.hpp>
+#include <mjfs/impl/tree_snapshot.hpp>
+#include <mjfs/impl/utils.hpp>
+#include <mjfs/tree_snapshot.hpp>
+#include <mjmem/object_allocator.hpp>
+#include <utility>
+
+namespace mjx {
+    tree_snapshot::tree_snapshot() : _Myimpl(::mjx::create_object<mjfs_impl::_Tree_snapshot>()) {}
+
+    tree_snapshot::tree_snapshot(tree_snapshot&& _Other) noexcept : _Myimpl(::std::move(_Other._Myimpl)) {}
+
+    tree_snapshot::~tree_snapshot() noexcept {}
+
+    tree_snapshot& tree_snapshot::operator=(tree_snapshot&& _Other) noexcept {
+        _Myimpl = ::std::move(_Other._Myimpl);
+        return *this;
+    }
+
+    bool tree_snapshot::scan(const path& _Root) {
+        ::std::vector<uint64_t> _Storage;
+        mjfs_impl::_Tree_scanner _Scanner(_Root.native(), nullptr);
+        if (!_Scanner._Scan(_Storage)) {
+            _Myimpl->_Reset();
+            return false;
+        }
+
+        _Myimpl->_Adopt(::std::move(_Storage));
+        return true;
+    }
+
+    bool tree_snapshot::scan(const path& _Root, const tree_snapshot& _Previous) {
+        // Note: The new snapshot is built separately, so the previous snapshot may be this one.
+        ::std::vector<uint64_t> _Storage;
+        mjfs_impl::_Tree_scanner _Scanner(_Root.native(), _Previous._Myimpl.get());
+        if (!_Scanner._Scan(_Storage)) {
+            _Myimpl->_Reset();
+            return false;
+        }
+
+        _Myimpl->_Adopt(::std::move(_Storage));
+        return true;
+    }
+
+    bool tree_snapshot::save(const path& _Target) const {
+        if (!_Myimpl->_Valid()) {
+            return false;
+        }
+
+        mjfs_impl::_Close_handle_guard _Guard = {::CreateFileW(_Target.c_str(), GENERIC_WRITE, 0,
+            nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+        if (!_Guard._Holds_valid_handle()) {
+            return false;
+        }
+
+        // WriteFile() accepts at most 4 GiB at once, so larger snapshots are written in parts
+        constexpr size_t _Max_chunk_size = size_t{1} << 30;
+        const byte_t* _Data              = _Myimpl->_Data();
+        size_t _Remaining                = _Myimpl->_Byte_size();
+        while (_Remaining > 0) {
+            const size_t _Chunk_size = (::std::min)(_Remaining, _Max_chunk_size);
+            if (!mjfs_impl::_Write_file(_Guard._Handle, _Data, _Chunk_size)) {
+                return false;
+            }
+
+            _Data      += _Chunk_size;
+            _Remaining -= _Chunk_size;
+        }
+
+        return true;
+    }
+
+    bool tree_snapshot::load(const path& _Target) {
+        return _Myimpl->_Map(_Target.c_str());
+    }
+
+    bool tree_snapshot::valid() const noexcept {
+        return _Myimpl->_Valid();
+    }
+
+    path tree_snapshot::root() const {
+        return path{_Myimpl->_Root_path()};
+    }
+
+    uint64_t tree_snapshot::volume_serial() const noexcept {
+        return _Myimpl->_Valid() ? _Myimpl->_Header->_Root_volume : 0;
+    }
+
+    size_t tree_snapshot::size() const noexcept {
+        return _Myimpl->_Size();
+    }
+
+    bool tree_snapshot::empty() const noexcept {
+        return _Myimpl->_Size() == 0;
+    }
+
+    unicode_string_view tree_snapshot::relative_path(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myimpl->_Relative_path(_Idx);
+    }
+
+    file_attribute tree_snapshot::attributes(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return static_cast<file_attribute>(_Myimpl->_Attributes[_Idx]);
+    }
+
+    uint64_t tree_snapshot::file_size(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myimpl->_Sizes[_Idx];
+    }
+
+    uint64_t tree_snapshot::last_write_time(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myimpl->_Write_times[_Idx];
+    }
+
+    file_id_128 tree_snapshot::file_id(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return _Myimpl->_File_id_at(_Idx);
+    }
+
+    size_t tree_snapshot::subtree_size(const size_t _Idx) const noexcept {
+#ifdef _DEBUG
+        _INTERNAL_ASSERT(_Idx < size(), "entry index out of range");
+#endif // _DEBUG
+        return static_cast<size_t>(_Myimpl->_Subtrees[_Idx]);
+    }
+
+    size_t tree_snapshot::find(const unicode_string_view _Relative_path) const noexcept {
+        return _Myimpl->_Find(_Relative_path, 0, size());
+    }
+
+    ::std::vector<snapshot_change> diff(const tree_snapshot& _Old, const tree_snapshot& _New) {
+        // Note: Both snapshots are in the same order, so the entries are matched by merging them.
+        //       The unmatched entries are then matched by their file IDs, sorted once, to find renames.
+        ::std::vector<snapshot_change> _Changes;
+        ::std::vector<size_t> _Removed;
+        ::std::vector<size_t> _Added;
+        const size_t _Old_size = _Old.size();
+        const size_t _New_size = _New.size();
+        size_t _Old_idx        = 0;
+        size_t _New_idx        = 0;
+        while (_Old_idx < _Old_size && _New_idx < _New_size) {
+            const int _Cmp = mjfs_impl::_Compare_snapshot_paths(
+                _Old.relative_path(_Old_idx), _New.relative_path(_New_idx));
+            if (_Cmp < 0) {
+                _Removed.push_back(_Old_idx++);
+            } else if (_Cmp > 0) {
+                _Added.push_back(_New_idx++);
+            } else {
+                const bool _Old_dir = _Has_bits(_Old.attributes(_Old_idx), file_attribute::directory);
+                const bool _New_dir = _Has_bits(_New.attributes(_New_idx), file_attribute::directory);
+                if (_Old_dir != _New_dir) { // replaced by an entry of another type
+                    _Removed.push_back(_Old_idx);
+                    _Added.push_back(_New_idx);
+                } else if (!_New_dir && (_Old.file_size(_Old_idx) != _New.file_size(_New_idx)
+                    || _Old.last_write_time(_Old_idx) != _New.last_write_time(_New_idx))) {
+                    _Changes.push_back(snapshot_change{snapshot_change_type::modified, _Old_idx, _New_idx});
+                }
+
+                ++_Old_idx;
+                ++_New_idx;
+            }
+        }
+
+        for (; _Old_idx < _Old_size; ++_Old_idx) {
+            _Removed.push_back(_Old_idx);
+        }
+
+        for (; _New_idx < _New_size; ++_New_idx) {
+            _Added.push_back(_New_idx);
+        }
+
+        // Note: The file IDs are unique only within a volume, so the volume is a part of each ID and
+        //       entries of snapshots taken from different volumes are never matched. A zero ID means that
+        //       the file system has no IDs.
+        const auto _Get_id = [](const tree_snapshot& _Snapshot, const size_t _Idx) noexcept {
+            const file_id_128 _Id = _Snapshot.file_id(_Idx);
+            mjfs_impl::_File_id _Result;
+            if (_Id != file_id_128{}) {
+                _Result._Volume = _Snapshot.volume_serial();
+                _Result._Low    = _Id.low;
+                _Result._High   = _Id.high;
+            }
+
+            return _Result;
+        };
+
+        // the removed entries sorted by their file IDs
+        ::std::vector<::std::pair<mjfs_impl::_File_id, size_t>> _Removed_ids;
+        for (const size_t _Idx : _Removed) {
+            const mjfs_impl::_File_id _Id = _Get_id(_Old, _Idx);
+            if (!_Id._Is_zero()) {
+                _Removed_ids.emplace_back(_Id, _Idx);
+            }
+        }
+
+        ::std::sort(_Removed_ids.begin(), _Removed_ids.end());
+        ::std::vector<bool> _Renamed(_Old_size, false);
+        ::std::vector<size_t> _Truly_added;
+        for (const size_t _Idx : _Added) {
+            const mjfs_impl::_File_id _Id = _Get_id(_New, _Idx);
+            const bool _Is_dir            = _Has_bits(_New.attributes(_Idx), file_attribute::directory);
+            bool _Found                   = false;
+            auto _Iter                    = ::std::lower_bound(_Removed_ids.begin(), _Removed_ids.end(),
+                ::std::pair<mjfs_impl::_File_id, size_t>{_Id, 0});
+            for (; !_Id._Is_zero() && _Iter != _Removed_ids.end() && _Iter->first == _Id; ++_Iter) {
+                // hard links share the ID, so the first unmatched entry of the same type is taken
+                const size_t _Old_match = _Iter->second;
+                if (!_Renamed[_Old_match]
+                    && _Has_bits(_Old.attributes(_Old_match), file_attribute::directory) == _Is_dir) {
+                    _Renamed[_Old_match] = true;
+                    _Changes.push_back(snapshot_change{snapshot_change_type::renamed, _Old_match, _Idx});
+                    _Found = true;
+                    break;
+                }
+            }
+
+            if (!_Found) {
+                _Truly_added.push_back(_Idx);
+            }
+        }
+
+        for (const size_t _Idx : _Removed) {
+            if (!_Renamed[_Idx]) {
+                _Changes.push_back(snapshot_change{snapshot_change_type::removed, _Idx, tree_snapshot::npos});
+            }
+        }
+
+        for (const size_t _Idx : _Truly_added) {
+            _Changes.push_back(snapshot_change{snapshot_change_type::added, tree_snapshot::npos, _Idx});
+        }
+
+        return _Changes;
+    }
+} // namespace mjx
@@ -0,0 +1,116 @@
+// tree_snapshot.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TREE_SNAPSHOT_HPP_
+#define _MJFS_TREE_SNAPSHOT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/api.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/path.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace mjfs_impl {
+        class _Tree_snapshot;
+    } // namespace mjfs_impl
+
+    enum class snapshot_change_type : unsigned char {
+        added,
+        removed,
+        modified,
+        renamed
+    };
+
+    struct snapshot_change {
+        snapshot_change_type type;
+        size_t old_index; // the position in the old snapshot, npos if the entry was added
+        size_t new_index; // the position in the new snapshot, npos if the entry was removed
+    };
+
+    class _MJFS_API tree_snapshot { // the entries of a directory tree, can be saved and loaded
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        tree_snapshot();
+        tree_snapshot(tree_snapshot&& _Other) noexcept;
+        ~tree_snapshot() noexcept;
+
+        tree_snapshot& operator=(tree_snapshot&& _Other) noexcept;
+
+        tree_snapshot(const tree_snapshot&)            = delete;
+        tree_snapshot& operator=(const tree_snapshot&) = delete;
+
+        // Note: The entries are stored in depth-first order, the entries of each directory sorted
+        //       by their names (case-insensitive). Reparse points are stored, but not followed.
+        bool scan(const path& _Root);
+
+        // Note: A directory whose last write time and file ID are the same as in the previous snapshot
+        //       is not enumerated, its entries are taken from the previous snapshot. Its subdirectories
+        //       are still checked, since a directory's write time changes only when its own entries are
+        //       added, removed or renamed. As a result, a file whose content changed in such a directory
+        //       keeps its previous size and write time. The previous snapshot is ignored if it was taken
+        //       from another root.
+        bool scan(const path& _Root, const tree_snapshot& _Previous);
+
+        // writes the snapshot to the file, the file is overwritten if it exists
+        bool save(const path& _Target) const;
+
+        // Note: The file is mapped into memory and its columns are used in place, nothing is copied.
+        //       The file cannot be modified while the snapshot is loaded.
+        bool load(const path& _Target);
+
+        // checks whether the snapshot was taken or loaded successfully
+        bool valid() const noexcept;
+
+        // returns the directory the snapshot was taken from
+        path root() const;
+
+        // returns the serial number of the root's volume, the file IDs are unique within it
+        uint64_t volume_serial() const noexcept;
+
+        // returns the number of entries
+        size_t size() const noexcept;
+
+        // checks whether there are no entries
+        bool empty() const noexcept;
+
+        // returns the path of the entry relative to the root
+        unicode_string_view relative_path(const size_t _Idx) const noexcept;
+
+        // returns the attributes of the entry
+        file_attribute attributes(const size_t _Idx) const noexcept;
+
+        // returns the size of the entry in bytes
+        uint64_t file_size(const size_t _Idx) const noexcept;
+
+        // returns the last write time, in 100-nanosecond intervals since January 1, 1601 (UTC)
+        uint64_t last_write_time(const size_t _Idx) const noexcept;
+
+        // returns the file ID of the entry, 128-bit where the volume supports it (e.g. ReFS)
+        file_id_128 file_id(const size_t _Idx) const noexcept;
+
+        // returns the number of entries inside the entry, 0 if the entry is not a directory
+        size_t subtree_size(const size_t _Idx) const noexcept;
+
+        // returns the position of the entry with the relative path (case-insensitive), or npos
+        size_t find(const unicode_string_view _Relative_path) const noexcept;
+
+    private:
+#pragma warning(suppress : 4251) // C4251: unique_smart_ptr<_Tree_snapshot> needs to have dll-interface
+        unique_smart_ptr<mjfs_impl::_Tree_snapshot> _Myimpl;
+    };
+
+    // Note: Compares two snapshots in a single pass over both of them. An entry that exists in both
+    //       snapshots is modified if its size or last write time changed, directories are never modified.
+    //       A removed entry and an added entry with the same file ID on the same volume are reported
+    //       as a single rename. The changes are grouped by type: modified, renamed, removed, then added.
+    _MJFS_API ::std::vector<snapshot_change> diff(const tree_snapshot& _Old, const tree_snapshot& _New);
+} // namespace mjx
+
+#endif // _MJFS_TREE_SNAPSHOT_HPP_
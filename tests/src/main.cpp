@@ -3,8 +3,23 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <unit/copy_directory.hpp>
+#include <unit/directory.hpp>
+#include <unit/directory_watcher.hpp>
+#include <unit/disk_usage.hpp>
+#include <unit/glob.hpp>
+#include <unit/metadata_cache.hpp>
+#include <unit/name_filter.hpp>
 #include <unit/path.hpp>
 #include <unit/path_iterator.hpp>
+#include <unit/path_map.hpp>
+#include <unit/path_pool.hpp>
+#include <unit/recursive_directory_iterator.hpp>
+#include <unit/remove_all.hpp>
+#include <unit/space_cache.hpp>
+#include <unit/static_path.hpp>
+#include <unit/status.hpp>
+#include <unit/tree_snapshot.hpp>
 
 int main() {
     ::testing::InitGoogleTest();
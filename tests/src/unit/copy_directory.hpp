@@ -0,0 +1,122 @@
+// copy_directory.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_COPY_DIRECTORY_HPP_
+#define _MJFS_TEST_UNIT_COPY_DIRECTORY_HPP_
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/status.hpp>
+#include <thread>
+#include <unit/test_tree.hpp>
+
+namespace mjx {
+    namespace test {
+        inline void _Create_copy_source(const path& _Root) {
+            // "src" holds a.txt (2 bytes) and sub\b.txt (2 bytes), "dst" holds an older a.txt (1 byte)
+            ASSERT_TRUE(create_directory(_Root / L"src"));
+            ASSERT_TRUE(create_directory(_Root / LR"(src\sub)"));
+            ASSERT_TRUE(create_directory(_Root / L"dst"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(dst\a.txt)", 1));
+            ::std::this_thread::sleep_for(::std::chrono::milliseconds(50)); // the sources are newer
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(src\a.txt)", 2));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(src\sub\b.txt)", 2));
+        }
+
+        TEST(copy_directory, existing_files) {
+            const _Test_tree _Tree(path(L"mjfs_test_copy_existing"));
+            const path& _Root = _Tree.root();
+            ASSERT_NO_FATAL_FAILURE(_Create_copy_source(_Root));
+
+            const path _Src = _Root / L"src";
+            const path _Dst = _Root / L"dst";
+            copy_directory_stats _Stats;
+            EXPECT_FALSE(copy_directory(_Src, _Dst, copy_options::none, &_Stats));
+            EXPECT_EQ(_Stats.error, 80); // ERROR_FILE_EXISTS
+            EXPECT_EQ(_Stats.failed_path, _Root / LR"(dst\a.txt)");
+            EXPECT_EQ(_Stats.copied_files, 1); // the other entries are still copied
+            EXPECT_EQ(status(_Root / LR"(dst\a.txt)").size, 1);
+            EXPECT_EQ(status(_Root / LR"(dst\sub\b.txt)").size, 2);
+
+            ASSERT_TRUE(copy_directory(_Src, _Dst, copy_options::skip_existing, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 0);
+            EXPECT_EQ(_Stats.skipped_files, 2);
+            EXPECT_EQ(status(_Root / LR"(dst\a.txt)").size, 1);
+
+            ASSERT_TRUE(copy_directory(_Src, _Dst, copy_options::overwrite_existing, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 2);
+            EXPECT_EQ(_Stats.skipped_files, 0);
+            EXPECT_EQ(status(_Root / LR"(dst\a.txt)").size, 2);
+        }
+
+        TEST(copy_directory, update_existing) {
+            const _Test_tree _Tree(path(L"mjfs_test_copy_update"));
+            const path& _Root = _Tree.root();
+            ASSERT_NO_FATAL_FAILURE(_Create_copy_source(_Root));
+
+            const path _Src = _Root / L"src";
+            const path _Dst = _Root / L"dst";
+            copy_directory_stats _Stats;
+            ASSERT_TRUE(copy_directory(_Src, _Dst, copy_options::update_existing, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 2); // the older target is replaced
+            EXPECT_EQ(_Stats.skipped_files, 0);
+            EXPECT_EQ(status(_Root / LR"(dst\a.txt)").size, 2);
+
+            ASSERT_TRUE(copy_directory(_Src, _Dst, copy_options::update_existing, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 0); // the targets are as new as their sources
+            EXPECT_EQ(_Stats.skipped_files, 2);
+
+            ::std::this_thread::sleep_for(::std::chrono::milliseconds(50));
+            ASSERT_TRUE(_Resize_test_file(_Root / LR"(src\sub\b.txt)", 3));
+            ASSERT_TRUE(copy_directory(_Src, _Dst, copy_options::update_existing, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 1);
+            EXPECT_EQ(_Stats.skipped_files, 1);
+            EXPECT_EQ(status(_Root / LR"(dst\sub\b.txt)").size, 3);
+        }
+
+        TEST(copy_directory, preserve_times) {
+            const _Test_tree _Tree(path(L"mjfs_test_copy_times"));
+            const path& _Root = _Tree.root();
+            ASSERT_NO_FATAL_FAILURE(_Create_copy_source(_Root));
+            ::std::this_thread::sleep_for(::std::chrono::milliseconds(50)); // the copies are created later
+
+            ASSERT_TRUE(copy_directory(_Root / L"src", _Root / L"plain"));
+            const file_status _Source = status(_Root / LR"(src\sub\b.txt)");
+            const file_status _Plain  = status(_Root / LR"(plain\sub\b.txt)");
+            EXPECT_EQ(_Plain.last_write_time, _Source.last_write_time); // always kept
+            EXPECT_NE(_Plain.creation_time, _Source.creation_time);
+
+            ASSERT_TRUE(copy_directory(_Root / L"src", _Root / L"kept", copy_options::preserve_times));
+            const file_status _Kept = status(_Root / LR"(kept\sub\b.txt)");
+            EXPECT_EQ(_Kept.last_write_time, _Source.last_write_time);
+            EXPECT_EQ(_Kept.creation_time, _Source.creation_time);
+            EXPECT_EQ(
+                status(_Root / LR"(kept\sub)").last_write_time, status(_Root / LR"(src\sub)").last_write_time);
+        }
+
+        TEST(copy_directory, target_inside_source) {
+            const _Test_tree _Tree(path(L"mjfs_test_copy_nested"));
+            const path& _Root = _Tree.root();
+            ASSERT_NO_FATAL_FAILURE(_Create_copy_source(_Root));
+
+            const path _Src    = _Root / L"src";
+            const path _Nested = _Root / LR"(src\sub\copy)";
+            copy_directory_stats _Stats;
+            EXPECT_FALSE(copy_directory(_Src, _Nested, copy_options::none, &_Stats));
+            EXPECT_EQ(_Stats.error, 87); // ERROR_INVALID_PARAMETER
+            EXPECT_EQ(_Stats.failed_path, _Nested);
+            EXPECT_FALSE(exists(_Nested)); // nothing is created
+            EXPECT_FALSE(copy_directory(_Src, _Root / LR"(src\)", copy_options::none, &_Stats));
+            EXPECT_EQ(_Stats.error, 87);
+
+            // a sibling whose name starts with the name of the source is not inside it
+            ASSERT_TRUE(copy_directory(_Src, _Root / L"src_copy", copy_options::none, &_Stats));
+            EXPECT_EQ(_Stats.copied_files, 2);
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_COPY_DIRECTORY_HPP_
@@ -0,0 +1,92 @@
+// directory.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_DIRECTORY_HPP_
+#define _MJFS_TEST_UNIT_DIRECTORY_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/status.hpp>
+#include <string>
+#include <unit/test_tree.hpp>
+
+namespace mjx {
+    namespace test {
+        TEST(create_directories, create) {
+            const _Test_tree _Tree(path(L"mjfs_test_create_directories"));
+            const path& _Root = _Tree.root();
+            EXPECT_TRUE(create_directories(_Root / LR"(a\b\c\)")); // with a trailing separator
+            EXPECT_TRUE(is_directory(_Root / LR"(a\b\c)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(a\b)")); // already exists
+            EXPECT_TRUE(create_directories(_Root / L"a/d//e"));
+            EXPECT_TRUE(is_directory(_Root / LR"(a\d\e)"));
+        }
+
+        TEST(create_directories, existing_file) {
+            const _Test_tree _Tree(path(L"mjfs_test_create_directories_file"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(_Create_test_file(_Root / L"file", 0));
+            EXPECT_FALSE(create_directories(_Root / L"file")); // the target itself is a file
+            EXPECT_FALSE(create_directories(_Root / LR"(file\a)"));
+            EXPECT_FALSE(create_directories(_Root / LR"(file\a\b)"));
+            EXPECT_FALSE(exists(_Root / LR"(file\a)"));
+            EXPECT_TRUE(is_regular_file(_Root / L"file"));
+        }
+
+        TEST(create_directories, trailing_separators) {
+            const _Test_tree _Tree(path(L"mjfs_test_create_directories_separators"));
+            const path& _Root = _Tree.root();
+            EXPECT_TRUE(create_directories(_Root / LR"(a\)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(b\c\\\)"));
+            EXPECT_TRUE(create_directories(_Root / L"d/e//"));
+            EXPECT_TRUE(is_directory(_Root / L"a"));
+            EXPECT_TRUE(is_directory(_Root / LR"(b\c)"));
+            EXPECT_TRUE(is_directory(_Root / LR"(d\e)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(b\c\)")); // already exists
+        }
+
+        TEST(create_directories, existing_directories) {
+            const _Test_tree _Tree(path(L"mjfs_test_create_directories_existing"));
+            const path& _Root = _Tree.root();
+            EXPECT_TRUE(create_directories(_Root));
+            ASSERT_TRUE(create_directory(_Root / L"a"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(a\keep.txt)", 1));
+            EXPECT_TRUE(create_directories(_Root / LR"(a\b\c)")); // only the missing ones are created
+            EXPECT_TRUE(is_directory(_Root / LR"(a\b\c)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(a\b\c)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(a\b)"));
+            EXPECT_TRUE(create_directories(_Root / L"a"));
+            EXPECT_TRUE(is_regular_file(_Root / LR"(a\keep.txt)")); // the existing content is kept
+        }
+
+        TEST(create_directories, drive_root) {
+            // Note: The root of a drive cannot be created, but it exists, so it counts as created.
+            const path _Drive = current_path().root_path();
+            if (!_Drive.has_root_name()) {
+                GTEST_SKIP() << "the current directory has no drive letter";
+            }
+
+            const ::std::wstring _Str(_Drive.c_str());
+            EXPECT_TRUE(create_directories(_Drive));
+            EXPECT_TRUE(create_directories(path((_Str + LR"(\\)").c_str())));
+            EXPECT_TRUE(create_directories(path((_Str.substr(0, 2) + L"/").c_str())));
+        }
+
+        TEST(create_directories, file_in_the_way) {
+            const _Test_tree _Tree(path(L"mjfs_test_create_directories_in_the_way"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directory(_Root / L"a"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(a\file)", 0));
+            EXPECT_FALSE(create_directories(_Root / LR"(a\file\)")); // a trailing separator doesn't help
+            EXPECT_FALSE(create_directories(_Root / LR"(a\file\b\c)"));
+            EXPECT_FALSE(exists(_Root / LR"(a\file\b)"));
+            EXPECT_TRUE(is_regular_file(_Root / LR"(a\file)"));
+            EXPECT_TRUE(create_directories(_Root / LR"(a\other\b)")); // the file only blocks its own path
+            EXPECT_TRUE(is_directory(_Root / LR"(a\other\b)"));
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_DIRECTORY_HPP_
@@ -0,0 +1,152 @@
+// directory_watcher.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_DIRECTORY_WATCHER_HPP_
+#define _MJFS_TEST_UNIT_DIRECTORY_WATCHER_HPP_
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <mjfs/directory_watcher.hpp>
+#include <mjfs/file.hpp>
+#include <mutex>
+#include <thread>
+#include <unit/test_tree.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        inline size_t _Count_watch_events(
+            const ::std::vector<watch_event>& _Events, const watch_event_type _Type, const path& _Target) {
+            size_t _Count = 0;
+            for (const watch_event& _Event : _Events) {
+                if (_Event.type == _Type && _Event.target == _Target) {
+                    ++_Count;
+                }
+            }
+
+            return _Count;
+        }
+
+        inline bool _Wait_for_watch_event(directory_watcher& _Watcher, ::std::vector<watch_event>& _Received,
+            const watch_event_type _Type, const path& _Target) {
+            // the delivered events are collected for up to 5 seconds, until the expected one arrives
+            ::std::vector<watch_event> _Events;
+            for (int _Attempt = 0; _Attempt < 50; ++_Attempt) {
+                if (_Watcher.wait(_Events, 100)) {
+                    _Received.insert(_Received.end(), _Events.begin(), _Events.end());
+                    if (_Count_watch_events(_Received, _Type, _Target) > 0) {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        TEST(directory_watcher, coalesced_modifications) {
+            const _Test_tree _Tree(path(L"mjfs_test_watcher_coalesce"));
+            const path _File = _Tree.root() / L"file.txt";
+            ASSERT_TRUE(_Create_test_file(_File, 1));
+            directory_watcher_options _Options;
+            _Options.recursive       = false;
+            _Options.coalesce_window = 1000; // long enough for all the writes to fall into one batch
+            directory_watcher _Watcher(_Options);
+            ASSERT_TRUE(_Watcher.watch(_Tree.root()));
+            for (uint64_t _Size = 2; _Size <= 10; ++_Size) { // each write is reported by the system
+                ASSERT_TRUE(_Resize_test_file(_File, _Size));
+            }
+
+            ::std::vector<watch_event> _Events;
+            ASSERT_TRUE(_Wait_for_watch_event(_Watcher, _Events, watch_event_type::modified, _File));
+            EXPECT_EQ(_Count_watch_events(_Events, watch_event_type::modified, _File), 1);
+        }
+
+        TEST(directory_watcher, renamed_entry) {
+            const _Test_tree _Tree(path(L"mjfs_test_watcher_rename"));
+            const path _Old = _Tree.root() / L"old.txt";
+            const path _New = _Tree.root() / L"new.txt";
+            ASSERT_TRUE(_Create_test_file(_Old, 1));
+            directory_watcher_options _Options;
+            _Options.recursive = false;
+            directory_watcher _Watcher(_Options);
+            ASSERT_TRUE(_Watcher.watch(_Tree.root()));
+            ASSERT_TRUE(rename(_Old, _New));
+
+            // the old and the new name are reported as a single event
+            ::std::vector<watch_event> _Events;
+            ASSERT_TRUE(_Wait_for_watch_event(_Watcher, _Events, watch_event_type::renamed, _New));
+            for (const watch_event& _Event : _Events) {
+                if (_Event.type == watch_event_type::renamed) {
+                    EXPECT_EQ(_Event.target, _New);
+                    EXPECT_EQ(_Event.old_target, _Old);
+                }
+            }
+
+            EXPECT_EQ(_Count_watch_events(_Events, watch_event_type::removed, _Old), 0);
+            EXPECT_EQ(_Count_watch_events(_Events, watch_event_type::added, _New), 0);
+        }
+
+        TEST(directory_watcher, queued_delivery) {
+            const _Test_tree _Tree(path(L"mjfs_test_watcher_queue"));
+            const path _First  = _Tree.root() / L"first.txt";
+            const path _Second = _Tree.root() / L"second.txt";
+            directory_watcher_options _Options;
+            _Options.recursive = false;
+            directory_watcher _Watcher(_Options);
+            EXPECT_FALSE(_Watcher.is_watched(_Tree.root()));
+            ASSERT_TRUE(_Watcher.watch(_Tree.root()));
+            EXPECT_TRUE(_Watcher.is_watched(_Tree.root()));
+            ::std::vector<watch_event> _Events;
+            EXPECT_FALSE(_Watcher.poll(_Events)); // nothing has changed yet
+            EXPECT_FALSE(_Watcher.wait(_Events, 10));
+
+            // the events are queued until they're taken, and taken only once
+            ASSERT_TRUE(_Create_test_file(_First, 1));
+            ASSERT_TRUE(_Wait_for_watch_event(_Watcher, _Events, watch_event_type::added, _First));
+            ::std::vector<watch_event> _Rest;
+            while (_Watcher.poll(_Rest)) {
+                EXPECT_EQ(_Count_watch_events(_Rest, watch_event_type::added, _First), 0);
+            }
+
+            // Note: The longest timeout would overflow the deadline, if it wasn't clamped,
+            //       and return before the events arrive.
+            ASSERT_TRUE(_Create_test_file(_Second, 1));
+            ASSERT_TRUE(_Watcher.wait(_Events, (::std::numeric_limits<uint64_t>::max)()));
+            EXPECT_FALSE(_Events.empty());
+        }
+
+        TEST(directory_watcher, callback_delivery) {
+            const _Test_tree _Tree(path(L"mjfs_test_watcher_callback"));
+            const path _File = _Tree.root() / L"file.txt";
+            ::std::mutex _Mtx;
+            ::std::vector<watch_event> _Received;
+            directory_watcher_options _Options;
+            _Options.recursive = false;
+            directory_watcher _Watcher(_Options, [&](const ::std::vector<watch_event>& _Events) {
+                ::std::lock_guard<::std::mutex> _Guard(_Mtx);
+                _Received.insert(_Received.end(), _Events.begin(), _Events.end());
+            });
+            ASSERT_TRUE(_Watcher.watch(_Tree.root()));
+            ASSERT_TRUE(_Create_test_file(_File, 1));
+            bool _Delivered = false;
+            for (int _Attempt = 0; _Attempt < 500 && !_Delivered; ++_Attempt) {
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+                ::std::lock_guard<::std::mutex> _Guard(_Mtx);
+                _Delivered = _Count_watch_events(_Received, watch_event_type::added, _File) > 0;
+            }
+
+            // the callback receives the events, so nothing is queued
+            EXPECT_TRUE(_Delivered);
+            ::std::vector<watch_event> _Events;
+            EXPECT_FALSE(_Watcher.poll(_Events));
+            EXPECT_FALSE(_Watcher.wait(_Events, 10));
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_DIRECTORY_WATCHER_HPP_
@@ -0,0 +1,112 @@
+// disk_usage.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_DISK_USAGE_HPP_
+#define _MJFS_TEST_UNIT_DISK_USAGE_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <unit/test_tree.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        inline void _Create_usage_tree(const path& _Root) {
+            // 60 bytes in 3 files, 3 directories
+            ASSERT_TRUE(create_directories(_Root / LR"(sub\deeper)"));
+            ASSERT_TRUE(create_directory(_Root / L"empty"));
+            ASSERT_TRUE(_Create_test_file(_Root / L"a.txt", 10));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(sub\b.txt)", 20));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(sub\deeper\c.txt)", 30));
+        }
+
+        inline const disk_usage_info* _Find_subtotal(
+            const ::std::vector<disk_usage_subtotal>& _Subtotals, const path& _Name) {
+            for (const disk_usage_subtotal& _Subtotal : _Subtotals) {
+                if (_Subtotal.name == _Name) {
+                    return &_Subtotal.usage;
+                }
+            }
+
+            return nullptr;
+        }
+
+        TEST(disk_usage, totals) {
+            const _Test_tree _Tree(path(L"mjfs_test_disk_usage_totals"));
+            ASSERT_NO_FATAL_FAILURE(_Create_usage_tree(_Tree.root()));
+            disk_usage_info _Usage;
+            ASSERT_TRUE(disk_usage(_Tree.root(), _Usage));
+            EXPECT_EQ(_Usage.bytes, 60);
+            EXPECT_EQ(_Usage.files, 3);
+            EXPECT_EQ(_Usage.directories, 3); // the root is not counted
+
+            disk_usage_info _Missing;
+            EXPECT_FALSE(disk_usage(_Tree.root() / L"missing", _Missing));
+        }
+
+        TEST(disk_usage, subtotals) {
+            const _Test_tree _Tree(path(L"mjfs_test_disk_usage_subtotals"));
+            ASSERT_NO_FATAL_FAILURE(_Create_usage_tree(_Tree.root()));
+            disk_usage_info _Usage;
+            ::std::vector<disk_usage_subtotal> _Subtotals;
+            ASSERT_TRUE(disk_usage(_Tree.root(), _Usage, disk_usage_options::none, &_Subtotals));
+            ASSERT_EQ(_Subtotals.size(), 3); // one for each of the root's entries
+
+            const disk_usage_info* const _File = _Find_subtotal(_Subtotals, path(L"a.txt"));
+            ASSERT_NE(_File, nullptr);
+            EXPECT_EQ(_File->bytes, 10);
+            EXPECT_EQ(_File->files, 1);
+            EXPECT_EQ(_File->directories, 0);
+
+            const disk_usage_info* const _Sub = _Find_subtotal(_Subtotals, path(L"sub"));
+            ASSERT_NE(_Sub, nullptr);
+            EXPECT_EQ(_Sub->bytes, 50);
+            EXPECT_EQ(_Sub->files, 2);
+            EXPECT_EQ(_Sub->directories, 2); // the entry itself and the directory below it
+
+            const disk_usage_info* const _Empty = _Find_subtotal(_Subtotals, path(L"empty"));
+            ASSERT_NE(_Empty, nullptr);
+            EXPECT_EQ(_Empty->bytes, 0);
+            EXPECT_EQ(_Empty->files, 0);
+            EXPECT_EQ(_Empty->directories, 1);
+
+            // the subtotals add up to the totals
+            disk_usage_info _Sum;
+            for (const disk_usage_subtotal& _Subtotal : _Subtotals) {
+                _Sum.bytes           += _Subtotal.usage.bytes;
+                _Sum.allocated_bytes += _Subtotal.usage.allocated_bytes;
+                _Sum.files           += _Subtotal.usage.files;
+                _Sum.directories     += _Subtotal.usage.directories;
+            }
+
+            EXPECT_EQ(_Sum.bytes, _Usage.bytes);
+            EXPECT_EQ(_Sum.allocated_bytes, _Usage.allocated_bytes);
+            EXPECT_EQ(_Sum.files, _Usage.files);
+            EXPECT_EQ(_Sum.directories, _Usage.directories);
+        }
+
+        TEST(disk_usage, count_hard_links_once) {
+            const _Test_tree _Tree(path(L"mjfs_test_disk_usage_hard_links"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directory(_Root / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_Root / L"a.txt", 10));
+            ASSERT_TRUE(_Create_test_file(_Root / L"other.txt", 5));
+            ASSERT_TRUE(_Create_test_hard_link(_Root / LR"(sub\link.txt)", _Root / L"a.txt"));
+
+            // each name of the file is counted by default
+            disk_usage_info _Usage;
+            ASSERT_TRUE(disk_usage(_Root, _Usage));
+            EXPECT_EQ(_Usage.bytes, 25);
+            EXPECT_EQ(_Usage.files, 3);
+
+            ASSERT_TRUE(disk_usage(_Root, _Usage, disk_usage_options::count_hard_links_once));
+            EXPECT_EQ(_Usage.bytes, 15);
+            EXPECT_EQ(_Usage.files, 2);
+            EXPECT_EQ(_Usage.directories, 1);
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_DISK_USAGE_HPP_
@@ -0,0 +1,81 @@
+// glob.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_GLOB_HPP_
+#define _MJFS_TEST_UNIT_GLOB_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/glob.hpp>
+
+namespace mjx {
+    namespace test {
+        TEST(glob_pattern, wildcards) {
+            const glob_pattern _Pattern(L"*.idx");
+            EXPECT_TRUE(_Pattern.valid());
+            EXPECT_TRUE(_Pattern.match(L"data.idx"));
+            EXPECT_TRUE(_Pattern.match(L"DATA.IDX"));
+            EXPECT_TRUE(_Pattern.match(L".idx"));
+            EXPECT_FALSE(_Pattern.match(L"data.idx.bak"));
+            EXPECT_FALSE(_Pattern.match(L"dir/data.idx"));
+
+            EXPECT_TRUE(glob_pattern(L"file?.t*t").match(L"file1.txt"));
+            EXPECT_FALSE(glob_pattern(L"file?.t*t").match(L"file.txt"));
+            EXPECT_TRUE(glob_pattern(L"a*b*c").match(L"aXXbYYbZZc"));
+            EXPECT_FALSE(glob_pattern(L"a*b*c").match(L"aXXbYYcZZ"));
+        }
+
+        TEST(glob_pattern, char_sets) {
+            EXPECT_TRUE(glob_pattern(L"log[0-9].txt").match(L"log7.txt"));
+            EXPECT_FALSE(glob_pattern(L"log[0-9].txt").match(L"logx.txt"));
+            EXPECT_TRUE(glob_pattern(L"log[!0-9].txt").match(L"logx.txt"));
+            EXPECT_FALSE(glob_pattern(L"log[^0-9].txt").match(L"log7.txt"));
+            EXPECT_TRUE(glob_pattern(L"[a-c]*").match(L"Beta"));
+            EXPECT_TRUE(glob_pattern(L"[]]").match(L"]"));
+            EXPECT_TRUE(glob_pattern(L"[abc").match(L"[abc")); // unterminated set is a literal
+        }
+
+        TEST(glob_pattern, globstar) {
+            const glob_pattern _Pattern(L"src/**/*.cpp");
+            EXPECT_TRUE(_Pattern.match(L"src/main.cpp"));
+            EXPECT_TRUE(_Pattern.match(LR"(src\mjfs\impl\glob.cpp)"));
+            EXPECT_FALSE(_Pattern.match(L"tests/main.cpp"));
+            EXPECT_FALSE(_Pattern.match(L"src/main.hpp"));
+
+            EXPECT_TRUE(glob_pattern(L"**").match(L"a/b/c"));
+            EXPECT_TRUE(glob_pattern(L"**/**/x").match(L"x"));
+            EXPECT_TRUE(glob_pattern(L"a/**").match(L"a"));
+        }
+
+        TEST(glob_pattern, pruning) {
+            const glob_pattern _Pattern(L"src/*/*.cpp");
+            const glob_pattern::state_type _Root = _Pattern.initial_state();
+            EXPECT_FALSE(_Pattern.can_continue(_Pattern.advance(_Root, L"docs")));
+
+            const glob_pattern::state_type _Src = _Pattern.advance(_Root, L"src");
+            EXPECT_FALSE(_Pattern.accepts(_Src));
+            EXPECT_TRUE(_Pattern.can_continue(_Src));
+
+            const glob_pattern::state_type _Dir  = _Pattern.advance(_Src, L"mjfs");
+            const glob_pattern::state_type _File = _Pattern.advance(_Dir, L"path.cpp");
+            EXPECT_TRUE(_Pattern.accepts(_File));
+            EXPECT_FALSE(_Pattern.can_continue(_File));
+        }
+
+        TEST(glob_pattern, invalid) {
+            EXPECT_FALSE(glob_pattern().valid());
+            EXPECT_FALSE(glob_pattern().match(L""));
+
+            wchar_t _Buf[2 * (glob_pattern::max_segments + 1)];
+            for (size_t _Idx = 0; _Idx < glob_pattern::max_segments + 1; ++_Idx) {
+                _Buf[2 * _Idx]     = L'a';
+                _Buf[2 * _Idx + 1] = L'/';
+            }
+
+            EXPECT_FALSE(glob_pattern(unicode_string_view{_Buf, sizeof(_Buf) / sizeof(wchar_t)}).valid());
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_GLOB_HPP_
@@ -0,0 +1,153 @@
+// metadata_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_METADATA_CACHE_HPP_
+#define _MJFS_TEST_UNIT_METADATA_CACHE_HPP_
+#include <chrono>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/metadata_cache.hpp>
+#include <mjfs/status.hpp>
+#include <thread>
+#include <unit/test_tree.hpp>
+
+namespace mjx {
+    namespace test {
+        inline bool _Wait_for_cached_size(metadata_cache& _Cache, const path& _Target, const uint64_t _Size) {
+            // the watch reports the change asynchronously, so the cache is polled for up to 5 seconds
+            for (int _Attempt = 0; _Attempt < 500; ++_Attempt) {
+                if (_Cache.status(_Target).size == _Size) {
+                    return true;
+                }
+
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+            }
+
+            return false;
+        }
+
+        TEST(metadata_cache, hit) {
+            const _Test_tree _Tree(path(L"mjfs_test_metadata_cache_hit"));
+            const path _File = _Tree.root() / L"file.txt";
+            ASSERT_TRUE(_Create_test_file(_File, 1));
+            metadata_cache_options _Options;
+            _Options.ttl               = 60'000;
+            _Options.watch_directories = false;
+            metadata_cache _Cache(_Options);
+            EXPECT_EQ(_Cache.status(_File).size, 1);
+            EXPECT_EQ(_Cache.size(), 1);
+
+            // nothing reports the change, so the cached status is returned
+            ASSERT_TRUE(_Resize_test_file(_File, 2));
+            EXPECT_EQ(_Cache.status(_File).size, 1);
+            EXPECT_TRUE(_Cache.is_regular_file(_File));
+            _Cache.invalidate(_File);
+            EXPECT_EQ(_Cache.size(), 0);
+            EXPECT_EQ(_Cache.status(_File).size, 2);
+        }
+
+        TEST(metadata_cache, ttl_expiry) {
+            const _Test_tree _Tree(path(L"mjfs_test_metadata_cache_ttl"));
+            const path _File = _Tree.root() / L"file.txt";
+            ASSERT_TRUE(_Create_test_file(_File, 1));
+            metadata_cache_options _Options;
+            _Options.ttl               = 50;
+            _Options.watch_directories = false;
+            metadata_cache _Cache(_Options);
+            EXPECT_EQ(_Cache.status(_File).size, 1);
+            ASSERT_TRUE(_Resize_test_file(_File, 2));
+            ::std::this_thread::sleep_for(::std::chrono::milliseconds(100));
+            EXPECT_EQ(_Cache.status(_File).size, 2);
+
+            _Options.ttl = 0; // nothing is cached without the TTL and the watch
+            metadata_cache _Uncached(_Options);
+            EXPECT_EQ(_Uncached.status(_File).size, 2);
+            EXPECT_EQ(_Uncached.size(), 0);
+        }
+
+        TEST(metadata_cache, watch_invalidation) {
+            const _Test_tree _Tree(path(L"mjfs_test_metadata_cache_watch"));
+            const path _File = _Tree.root() / L"file.txt";
+            ASSERT_TRUE(_Create_test_file(_File, 1));
+            metadata_cache_options _Options;
+            _Options.ttl = 60'000;
+            metadata_cache _Cache(_Options);
+            EXPECT_EQ(_Cache.status(_File).size, 1);
+            ASSERT_TRUE(_Resize_test_file(_File, 2));
+            EXPECT_TRUE(_Wait_for_cached_size(_Cache, _File, 2));
+            ASSERT_TRUE(delete_file(_File));
+            for (int _Attempt = 0; _Attempt < 500 && _Cache.exists(_File); ++_Attempt) {
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+            }
+
+            EXPECT_FALSE(_Cache.exists(_File));
+        }
+
+        TEST(metadata_cache, released_watch) {
+            // Note: The only watch fails once its directory is removed, so it must be released
+            //       for the next directory to be watched.
+            const _Test_tree _Tree(path(L"mjfs_test_metadata_cache_release"));
+            ASSERT_TRUE(create_directory(_Tree.root() / L"first"));
+            ASSERT_TRUE(create_directory(_Tree.root() / L"second"));
+            const path _First  = _Tree.root() / LR"(first\file.txt)";
+            const path _Second = _Tree.root() / LR"(second\file.txt)";
+            ASSERT_TRUE(_Create_test_file(_First, 1));
+            ASSERT_TRUE(_Create_test_file(_Second, 1));
+            metadata_cache_options _Options;
+            _Options.ttl                     = 60'000;
+            _Options.max_watched_directories = 1;
+            metadata_cache _Cache(_Options);
+            EXPECT_EQ(_Cache.status(_First).size, 1);
+            remove_all(_Tree.root() / L"first");
+
+            // the cache watches the second directory once the first watch is released
+            bool _Watched = false;
+            for (uint64_t _Size = 2; _Size < 100 && !_Watched; ++_Size) {
+                _Cache.invalidate(_Second);
+                _Cache.status(_Second);
+                ASSERT_TRUE(_Resize_test_file(_Second, _Size));
+                for (int _Attempt = 0; _Attempt < 5 && !_Watched; ++_Attempt) {
+                    ::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+                    _Watched = _Cache.status(_Second).size == _Size;
+                }
+            }
+
+            EXPECT_TRUE(_Watched);
+        }
+
+        TEST(metadata_cache, eviction) {
+            const _Test_tree _Tree(path(L"mjfs_test_metadata_cache_eviction"));
+            const path _Hot = _Tree.root() / L"hot.txt";
+            ASSERT_TRUE(_Create_test_file(_Hot, 1));
+            metadata_cache_options _Options;
+            _Options.capacity          = 4;
+            _Options.shard_count       = 1;
+            _Options.ttl               = 60'000;
+            _Options.watch_directories = false;
+            metadata_cache _Cache(_Options);
+            EXPECT_EQ(_Cache.status(_Hot).size, 1);
+            ASSERT_TRUE(_Resize_test_file(_Hot, 2)); // visible only once the entry is evicted
+
+            // Note: A hit marks the entry, so the frequently used one survives the eviction.
+            wchar_t _Name[] = L"cold_00.txt";
+            for (size_t _Idx = 0; _Idx < 20; ++_Idx) {
+                _Name[5] = static_cast<wchar_t>(L'0' + _Idx / 10);
+                _Name[6] = static_cast<wchar_t>(L'0' + _Idx % 10);
+                EXPECT_FALSE(_Cache.exists(_Tree.root() / _Name));
+                EXPECT_LE(_Cache.size(), 4);
+                EXPECT_EQ(_Cache.status(_Hot).size, 1);
+            }
+
+            EXPECT_EQ(_Cache.size(), 4);
+            _Cache.clear();
+            EXPECT_EQ(_Cache.size(), 0);
+            EXPECT_EQ(_Cache.status(_Hot).size, 2);
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_METADATA_CACHE_HPP_
@@ -0,0 +1,136 @@
+// name_filter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_NAME_FILTER_HPP_
+#define _MJFS_TEST_UNIT_NAME_FILTER_HPP_
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/name_filter.hpp>
+#include <mjfs/status.hpp>
+#include <unit/test_tree.hpp>
+
+namespace mjx {
+    namespace test {
+        inline void _Set_name_filter_index(wchar_t* const _Name, const size_t _Idx) noexcept {
+            // replaces the "000" in the name with the index
+            _Name[0] = static_cast<wchar_t>(L'0' + _Idx / 100 % 10);
+            _Name[1] = static_cast<wchar_t>(L'0' + _Idx / 10 % 10);
+            _Name[2] = static_cast<wchar_t>(L'0' + _Idx % 10);
+        }
+
+        TEST(directory_name_filter, contains) {
+            constexpr size_t _Count = 100;
+            const _Test_tree _Tree(path(L"mjfs_test_name_filter_contains"));
+            wchar_t _Name[] = L"file_000.txt";
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Set_name_filter_index(_Name + 5, _Idx);
+                ASSERT_TRUE(_Create_test_file(_Tree.root() / _Name, 1));
+            }
+
+            const directory_name_filter _Filter(_Tree.root());
+            ASSERT_TRUE(_Filter.valid());
+            EXPECT_GE(_Filter.size(), _Count);
+            EXPECT_EQ(_Filter.directory(), _Tree.root());
+
+            // no false negatives, regardless of the case
+            wchar_t _Upper[] = L"FILE_000.TXT";
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Set_name_filter_index(_Name + 5, _Idx);
+                _Set_name_filter_index(_Upper + 5, _Idx);
+                EXPECT_TRUE(_Filter.may_contain(_Name));
+                EXPECT_TRUE(_Filter.may_contain(_Upper));
+            }
+
+            // the false-positive rate stays close to the requested 1%
+            wchar_t _Other[]       = L"other_000.txt";
+            size_t _False_positive = 0;
+            for (size_t _Idx = 0; _Idx < 1000; ++_Idx) {
+                _Set_name_filter_index(_Other + 6, _Idx);
+                if (_Filter.may_contain(_Other)) {
+                    ++_False_positive;
+                }
+            }
+
+            EXPECT_LE(_False_positive, 50);
+        }
+
+        TEST(directory_name_filter, short_name) {
+            const _Test_tree _Tree(path(L"mjfs_test_name_filter_short"));
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"long_file_name.txt", 1));
+            if (!exists(_Tree.root() / L"LONG_F~1.TXT")) {
+                GTEST_SKIP() << "the volume doesn't generate short names";
+            }
+
+            const directory_name_filter _Filter(_Tree.root());
+            ASSERT_TRUE(_Filter.valid());
+            EXPECT_EQ(_Filter.size(), 2); // the long and the short name
+            EXPECT_TRUE(_Filter.may_contain(L"long_file_name.txt"));
+            EXPECT_TRUE(_Filter.may_contain(L"LONG_F~1.TXT"));
+        }
+
+        TEST(directory_name_filter, invalid) {
+            const directory_name_filter _Empty;
+            EXPECT_FALSE(_Empty.valid());
+            EXPECT_EQ(_Empty.size(), 0);
+            EXPECT_TRUE(_Empty.may_contain(L"anything")); // an invalid filter knows nothing
+
+            const _Test_tree _Tree(path(L"mjfs_test_name_filter_invalid"));
+            directory_name_filter _Bad_rate(_Tree.root(), name_filter_mode::snapshot, 1.0);
+            EXPECT_FALSE(_Bad_rate.valid());
+            EXPECT_FALSE(_Bad_rate.refresh());
+            EXPECT_TRUE(_Bad_rate.may_contain(L"anything"));
+
+            const path _Missing_dir = _Tree.root() / L"missing";
+            const directory_name_filter _Missing(_Missing_dir);
+            EXPECT_FALSE(_Missing.valid());
+            EXPECT_EQ(_Missing.directory(), _Missing_dir);
+            EXPECT_TRUE(_Missing.may_contain(L"anything"));
+
+            // a regular file can't be enumerated
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"file.txt", 1));
+            const directory_name_filter _File(_Tree.root() / L"file.txt");
+            EXPECT_FALSE(_File.valid());
+        }
+
+        TEST(directory_name_filter, snapshot_refresh) {
+            const _Test_tree _Tree(path(L"mjfs_test_name_filter_snapshot"));
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"first.txt", 1));
+            directory_name_filter _Filter(_Tree.root());
+            ASSERT_TRUE(_Filter.valid());
+            EXPECT_FALSE(_Filter.is_stale());
+            EXPECT_EQ(_Filter.size(), 1);
+            EXPECT_TRUE(_Filter.may_contain(L"first.txt"));
+
+            // a snapshot doesn't see the change until it's rebuilt
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"second.txt", 1));
+            EXPECT_FALSE(_Filter.is_stale());
+            ASSERT_TRUE(_Filter.refresh());
+            EXPECT_EQ(_Filter.size(), 2);
+            EXPECT_TRUE(_Filter.may_contain(L"first.txt"));
+            EXPECT_TRUE(_Filter.may_contain(L"second.txt"));
+        }
+
+        TEST(directory_name_filter, watch) {
+            const _Test_tree _Tree(path(L"mjfs_test_name_filter_watch"));
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"first.txt", 1));
+            directory_name_filter _Filter(_Tree.root(), name_filter_mode::watch);
+            ASSERT_TRUE(_Filter.valid());
+            EXPECT_FALSE(_Filter.is_stale());
+
+            // a stale filter knows nothing until it's refreshed
+            ASSERT_TRUE(_Create_test_file(_Tree.root() / L"second.txt", 1));
+            EXPECT_TRUE(_Filter.is_stale());
+            EXPECT_TRUE(_Filter.may_contain(L"anything"));
+            ASSERT_TRUE(_Filter.refresh());
+            EXPECT_FALSE(_Filter.is_stale());
+            EXPECT_EQ(_Filter.size(), 2);
+            EXPECT_TRUE(_Filter.may_contain(L"second.txt"));
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_NAME_FILTER_HPP_
@@ -17,6 +17,18 @@ namespace mjx {
             EXPECT_EQ(path(L"foo") / L"C:/bar", L"C:/bar");
         }
 
+        TEST(path, join) {
+            const path _Root(L"C:/root", path::generic_format); // path operands keep their slashes
+            const unicode_string _Dir(L"dir/");
+            const path _Joined = _Root / _Dir / unicode_string_view{L"sub"} / L"name.txt";
+            EXPECT_EQ(_Joined.native(), LR"(C:/root\dir\sub\name.txt)");
+            EXPECT_EQ(path::join(_Root, _Dir, L"sub", L"name.txt"), _Joined);
+            EXPECT_EQ((_Root / _Dir).native(), LR"(C:/root\dir\)");
+            EXPECT_EQ(path::join(L"foo", L"", L"bar"), LR"(foo\bar)");
+            EXPECT_EQ(path::join(L"foo", L"C:/bar", L"baz"), LR"(C:\bar\baz)");
+            EXPECT_EQ(path::join(L"", L"foo"), L"foo");
+        }
+
         TEST(path, make_preferred) {
             EXPECT_EQ(path(L"a/b/c").make_preferred(), L"a\\b\\c");
             EXPECT_EQ(path(L"a\\b\\c").make_preferred(), L"a\\b\\c");
@@ -124,6 +136,128 @@ namespace mjx {
             EXPECT_FALSE(path(L"/foo/..").has_extension());
             EXPECT_FALSE(path(L"/foo/.hidden").has_extension());
         }
+
+        TEST(path, cached_parts) {
+            path _Path(L"/foo/bar.txt");
+            EXPECT_EQ(_Path.filename(), path(L"bar.txt"));
+            EXPECT_EQ(_Path.extension(), path(L".txt"));
+            _Path.replace_extension(L".cc");
+            EXPECT_EQ(_Path.stem(), path(L"bar"));
+            EXPECT_EQ(_Path.extension(), path(L".cc"));
+            _Path += L"x";
+            EXPECT_EQ(_Path.extension(), path(L".ccx"));
+            _Path /= L"baz";
+            EXPECT_EQ(_Path.filename(), path(L"baz"));
+            EXPECT_FALSE(_Path.has_extension());
+            EXPECT_EQ(_Path.parent_path(), path(L"/foo/bar.ccx"));
+            _Path.remove_filename();
+            EXPECT_FALSE(_Path.has_filename());
+
+            path _Other(L"qux.hpp");
+            EXPECT_TRUE(_Other.has_extension());
+            _Other.swap(_Path);
+            EXPECT_FALSE(_Other.has_filename());
+            EXPECT_EQ(_Path.stem(), path(L"qux"));
+            _Other = _Path;
+            EXPECT_EQ(_Other.extension(), path(L".hpp"));
+            _Path.clear();
+            EXPECT_FALSE(_Path.has_stem());
+            EXPECT_FALSE(_Path.has_parent_path());
+        }
+
+        TEST(path, utf8) {
+            EXPECT_EQ(path(utf8_string_view{"C:/foo/bar"}), LR"(C:\foo\bar)");
+            EXPECT_EQ(path(utf8_string_view{"foo/\xC5\xBC\xC3\xB3\xC5\x82w"}), L"foo\\\x017C\x00F3\x0142w");
+            EXPECT_EQ(path(L"foo/\x017C\x00F3\x0142w").u8string(), "foo\\\xC5\xBC\xC3\xB3\xC5\x82w");
+            EXPECT_EQ(path(L"").u8string(), "");
+        }
+
+        TEST(path, from_utf8) {
+            EXPECT_EQ(path::from_utf8("C:/some/ascii/only/path.txt"), LR"(C:\some\ascii\only\path.txt)");
+            EXPECT_EQ(path::from_utf8("C:/\xE6\x97\xA5\xE6\x9C\xAC/long/ascii/tail/after/cjk"),
+                L"C:\\\x65E5\x672C\\long\\ascii\\tail\\after\\cjk");
+            EXPECT_EQ(path::from_utf8("\xF0\x9F\x98\x80.txt"), L"\xD83D\xDE00.txt");
+
+            EXPECT_TRUE(path::from_utf8("\xC0\x80").empty()); // overlong form
+            EXPECT_TRUE(path::from_utf8("\xED\xA0\x80").empty()); // surrogate
+            EXPECT_TRUE(path::from_utf8("\xF4\x90\x80\x80").empty()); // above U+10FFFF
+            EXPECT_TRUE(path::from_utf8("foo\xE6\x97").empty()); // truncated sequence
+            EXPECT_TRUE(path::from_utf8("\x80" "foo").empty()); // unexpected continuation byte
+        }
+
+        TEST(path, to_utf8) {
+            const path _Path(L"C:/\x65E5\x672C/\xD83D\xDE00/some/long/ascii/tail");
+            const char* const _Expected =
+                "C:\\\xE6\x97\xA5\xE6\x9C\xAC\\\xF0\x9F\x98\x80\\some\\long\\ascii\\tail";
+            EXPECT_EQ(_Path.utf8_length(), 35);
+
+            char _Buf[36];
+            EXPECT_FALSE(_Path.to_utf8(_Buf, 35)); // no space for the null-terminator
+            EXPECT_TRUE(_Path.to_utf8(_Buf, 36));
+            EXPECT_STREQ(_Buf, _Expected);
+            EXPECT_EQ(_Path.u8string(), _Expected);
+
+            EXPECT_FALSE(path(L"foo\xD800").to_utf8(_Buf, sizeof(_Buf))); // unpaired surrogate
+            EXPECT_EQ(path(L"foo\xDC00" L"bar").utf8_length(), 0);
+        }
+
+        TEST(path, checked_utf8) {
+            // Note: The checked overloads report an invalid input, which is otherwise indistinguishable
+            //       from an empty one, and leave the result unchanged.
+            path _Path(L"unchanged");
+            EXPECT_TRUE(path::from_utf8("", _Path));
+            EXPECT_TRUE(_Path.empty());
+            EXPECT_TRUE(path::from_utf8("C:/\xE6\x97\xA5/\xF0\x9F\x98\x80.txt", _Path));
+            EXPECT_EQ(_Path, L"C:\\\x65E5\\\xD83D\xDE00.txt");
+            EXPECT_FALSE(path::from_utf8("\xC0\x80", _Path)); // overlong form
+            EXPECT_FALSE(path::from_utf8("foo\xE6\x97", _Path)); // truncated sequence
+            EXPECT_FALSE(path::from_utf8("\xED\xA0\x80", _Path)); // surrogate
+            EXPECT_EQ(_Path, L"C:\\\x65E5\\\xD83D\xDE00.txt");
+
+            utf8_string _Str = "unchanged";
+            EXPECT_TRUE(path(L"").u8string(_Str));
+            EXPECT_TRUE(_Str.empty());
+            EXPECT_TRUE(_Path.u8string(_Str));
+            EXPECT_EQ(_Str, "C:\\\xE6\x97\xA5\\\xF0\x9F\x98\x80.txt");
+            EXPECT_FALSE(path(L"foo\xD800").u8string(_Str)); // unpaired high surrogate
+            EXPECT_FALSE(path(L"\xDC00" L"bar").u8string(_Str)); // unpaired low surrogate
+            EXPECT_EQ(_Str, "C:\\\xE6\x97\xA5\\\xF0\x9F\x98\x80.txt");
+        }
+
+        TEST(path, compare) {
+            EXPECT_EQ(path(L"foo/bar").compare(path(LR"(foo\bar)", path::generic_format)), 0);
+            EXPECT_EQ(path(L"foo//bar/").compare(LR"(foo\bar\)"), 0);
+            EXPECT_LT(path(L"foo").compare(L"foo/"), 0);
+            EXPECT_LT(path(L"foo/bar").compare(L"foo-bar"), 0); // "foo" is a prefix of "foo-bar"
+            EXPECT_GT(path(L"foo/bar/baz").compare(L"foo/bar"), 0);
+            EXPECT_LT(path(L"a/b/c/d/e/f/g/h/i").compare(L"a/b/c/d/e/f/g/h/j"), 0);
+            EXPECT_LT(path(L"C:foo").compare(LR"(C:\foo)"), 0); // no root directory is less
+            EXPECT_LT(path(LR"(C:\zzz)").compare(LR"(D:\aaa)"), 0);
+            EXPECT_GT(path(L"C:").compare(L"zzz"), 0); // root name is compared first
+
+            EXPECT_TRUE(path(L"a/b") < path(L"a/c"));
+            EXPECT_TRUE(path(L"a/b") <= path(L"a\\b"));
+            EXPECT_TRUE((path(L"a/b") <=> path(L"a\\b")) == 0);
+            EXPECT_TRUE(path(L"b") > path(L"a/z"));
+        }
+
+        TEST(path, hash) {
+            EXPECT_EQ(hash_value(path(L"C:/foo/bar")), hash_value(path(L"C:/foo/bar")));
+            EXPECT_NE(hash_value(path(L"C:/foo/bar")), hash_value(path(L"C:/foo/baz")));
+            EXPECT_EQ(::std::hash<path>{}(path(L"foo")), hash_value(path(L"foo")));
+            EXPECT_EQ(path_hash{}(path(L"foo")), path_hash{}(unicode_string_view{L"foo"}));
+
+            const path _Long_path(
+                L"C:/some/long/directory/name/that/spans/more/than/one/chunk/of/folded/input/file.txt");
+            const path _Long_path_upper(
+                LR"(c:\SOME\LONG\DIRECTORY\NAME\THAT\SPANS\MORE\THAN\ONE\CHUNK\OF\FOLDED\INPUT\FILE.TXT)");
+            EXPECT_EQ(path_insensitive_hash{}(path(L"C:/Foo")), path_insensitive_hash{}(path(LR"(c:\FOO)")));
+            EXPECT_EQ(path_insensitive_hash{}(_Long_path), path_insensitive_hash{}(_Long_path_upper));
+            EXPECT_TRUE(path_insensitive_equal{}(path(L"C:/Foo"), path(LR"(c:\FOO)")));
+            EXPECT_TRUE(path_insensitive_equal{}(_Long_path, _Long_path_upper));
+            EXPECT_FALSE(path_insensitive_equal{}(path(L"C:/Foo"), path(L"C:/Fo")));
+            EXPECT_FALSE(path_equal{}(path(L"C:/Foo"), path(LR"(c:\FOO)")));
+        }
     } // namespace test
 } // namespace mjx
 
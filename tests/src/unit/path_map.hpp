@@ -0,0 +1,73 @@
+// path_map.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_PATH_MAP_HPP_
+#define _MJFS_TEST_UNIT_PATH_MAP_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/path_map.hpp>
+
+namespace mjx {
+    namespace test {
+        TEST(path_set, insert) {
+            path_set<> _Set;
+            EXPECT_TRUE(_Set.empty());
+            EXPECT_TRUE(_Set.insert(L"C:/foo"));
+            EXPECT_TRUE(_Set.insert(L"C:/bar"));
+            EXPECT_FALSE(_Set.insert(L"C:/foo"));
+            EXPECT_EQ(_Set.size(), 2);
+            EXPECT_TRUE(_Set.contains(L"C:/bar"));
+            EXPECT_FALSE(_Set.contains(L"C:/FOO"));
+            EXPECT_EQ(_Set.key(0), L"C:/foo");
+            EXPECT_EQ(_Set.key(1), L"C:/bar");
+        }
+
+        TEST(path_set, insensitive) {
+            path_set<path_insensitive_hash, path_insensitive_equal> _Set;
+            EXPECT_TRUE(_Set.insert(L"C:/Foo/Bar"));
+            EXPECT_FALSE(_Set.insert(L"c:\\FOO\\bar"));
+            EXPECT_TRUE(_Set.contains(L"C:\\foo/BAR"));
+            EXPECT_EQ(_Set.size(), 1);
+        }
+
+        TEST(path_map, emplace) {
+            path_map<int> _Map;
+            EXPECT_TRUE(_Map.emplace(L"foo", 1).second);
+            EXPECT_FALSE(_Map.emplace(L"foo", 2).second);
+            EXPECT_EQ(*_Map.find(L"foo"), 1);
+            EXPECT_EQ(_Map.find(L"bar"), nullptr);
+
+            _Map[L"bar"] += 5;
+            EXPECT_EQ(_Map[L"bar"], 5);
+            EXPECT_EQ(_Map.size(), 2);
+        }
+
+        TEST(path_map, rehash) {
+            wchar_t _Key[] = L"C:/dir/file_000";
+            const auto _Make_key = [&_Key](size_t _Idx) noexcept {
+                for (size_t _Pos = 14; _Pos >= 12; --_Pos, _Idx /= 10) {
+                    _Key[_Pos] = static_cast<wchar_t>(L'0' + _Idx % 10);
+                }
+
+                return unicode_string_view{_Key};
+            };
+
+            path_map<size_t> _Map;
+            for (size_t _Idx = 0; _Idx < 1000; ++_Idx) {
+                _Map.emplace(_Make_key(_Idx), _Idx);
+            }
+
+            EXPECT_EQ(_Map.size(), 1000);
+            for (size_t _Idx = 0; _Idx < 1000; ++_Idx) {
+                const size_t* const _Value = _Map.find(_Make_key(_Idx));
+                ASSERT_NE(_Value, nullptr);
+                EXPECT_EQ(*_Value, _Idx);
+                EXPECT_EQ(_Map.key(_Idx), _Make_key(_Idx));
+            }
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_PATH_MAP_HPP_
@@ -0,0 +1,101 @@
+// path_pool.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_PATH_POOL_HPP_
+#define _MJFS_TEST_UNIT_PATH_POOL_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/path_pool.hpp>
+
+namespace mjx {
+    namespace test {
+        TEST(path_pool, intern) {
+            path_pool _Pool;
+            const path_pool::handle_type _Bar = _Pool.intern(path(L"C:/foo/bar"));
+            const path_pool::handle_type _Baz = _Pool.intern(path(LR"(C:\foo\\baz)"));
+            ASSERT_NE(_Bar, path_pool::npos);
+            ASSERT_NE(_Baz, path_pool::npos);
+            EXPECT_EQ(_Pool.size(), 5); // "C:", "\", "foo", "bar" and "baz"
+            EXPECT_EQ(_Pool.parent(_Bar), _Pool.parent(_Baz));
+            EXPECT_EQ(_Pool.intern(path(LR"(C:\foo\bar)")), _Bar);
+            EXPECT_EQ(_Pool.find(_Pool.parent(_Bar), L"bar"), _Bar);
+            EXPECT_EQ(_Pool.find(_Pool.parent(_Bar), L"qux"), path_pool::npos);
+            EXPECT_EQ(_Pool.name(_Bar), L"bar");
+            EXPECT_EQ(_Pool.intern(path(L"")), path_pool::npos);
+        }
+
+        TEST(path_pool, reconstruct) {
+            path_pool _Pool;
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(L"C:/foo/bar"))), LR"(C:\foo\bar)");
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(L"C:foo/bar"))), LR"(C:foo\bar)");
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(L"/foo//bar/"))), LR"(\foo\bar)");
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(L"foo"))), L"foo");
+
+            const path_pool::handle_type _Handle = _Pool.intern(path(L"C:/foo/bar"));
+            EXPECT_EQ(_Pool.length(_Handle), 10);
+
+            wchar_t _Buf[11];
+            EXPECT_FALSE(_Pool.copy_path(_Handle, _Buf, 10)); // no space for the null-terminator
+            EXPECT_TRUE(_Pool.copy_path(_Handle, _Buf, 11));
+            EXPECT_EQ(unicode_string_view{_Buf}, LR"(C:\foo\bar)");
+        }
+
+        TEST(path_pool, unc_root_name) {
+            path_pool _Pool;
+            const path_pool::handle_type _Handle = _Pool.intern(path(LR"(\\server\share\foo\bar)"));
+            ASSERT_NE(_Handle, path_pool::npos);
+            EXPECT_EQ(_Pool.to_path(_Handle), LR"(\\server\share\foo\bar)");
+            EXPECT_EQ(_Pool.size(), 4); // "\\server\share", "\", "foo" and "bar"
+            EXPECT_EQ(_Pool.name(0), LR"(\\server\share)");
+            EXPECT_EQ(_Pool.parent(1), 0);
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(LR"(\\server\share)"))), LR"(\\server\share)");
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(LR"(\\server\other\)"))), LR"(\\server\other\)");
+            EXPECT_EQ(_Pool.intern(path(LR"(\\server\share\foo\bar)")), _Handle);
+        }
+
+        TEST(path_pool, device_root_name) {
+            path_pool _Pool;
+            const path_pool::handle_type _Handle = _Pool.intern(path(LR"(\\?\C:\foo\bar)"));
+            ASSERT_NE(_Handle, path_pool::npos);
+            EXPECT_EQ(_Pool.to_path(_Handle), LR"(\\?\C:\foo\bar)");
+            EXPECT_EQ(_Pool.name(0), LR"(\\?\C:)");
+            EXPECT_EQ(_Pool.length(_Handle), 14);
+            EXPECT_EQ(_Pool.to_path(_Pool.intern(path(LR"(\\?\UNC\server\share\foo)"))),
+                LR"(\\?\UNC\server\share\foo)");
+            EXPECT_EQ(
+                _Pool.to_path(_Pool.intern(path(LR"(\\?\Volume{1234}\foo)"))), LR"(\\?\Volume{1234}\foo)");
+        }
+
+        TEST(path_pool, reject_separators) {
+            path_pool _Pool;
+            const path_pool::handle_type _Root = _Pool.intern(path(L"C:/root"));
+            ASSERT_NE(_Root, path_pool::npos);
+            EXPECT_EQ(_Pool.intern(_Root, LR"(foo\bar)"), path_pool::npos);
+            EXPECT_EQ(_Pool.intern(_Root, L"foo/bar"), path_pool::npos);
+            EXPECT_EQ(_Pool.intern(_Root, LR"(\)"), path_pool::npos);
+            EXPECT_EQ(_Pool.intern(path_pool::npos, LR"(\\server\share)"), path_pool::npos);
+            EXPECT_EQ(_Pool.size(), 3); // nothing was added
+            EXPECT_NE(_Pool.intern(_Root, L"foo"), path_pool::npos);
+        }
+
+        TEST(path_pool, rehash) {
+            path_pool _Pool;
+            const path_pool::handle_type _Root = _Pool.intern(path(L"C:/root"));
+            wchar_t _Name[] = L"dir_000";
+            for (size_t _Idx = 0; _Idx < 1000; ++_Idx) {
+                _Name[4] = static_cast<wchar_t>(L'0' + _Idx / 100);
+                _Name[5] = static_cast<wchar_t>(L'0' + _Idx / 10 % 10);
+                _Name[6] = static_cast<wchar_t>(L'0' + _Idx % 10);
+                EXPECT_EQ(_Pool.intern(_Root, _Name), static_cast<path_pool::handle_type>(_Idx + 3));
+            }
+
+            EXPECT_EQ(_Pool.size(), 1003);
+            EXPECT_EQ(_Pool.find(_Root, L"dir_512"), 515);
+            EXPECT_EQ(_Pool.to_path(515), LR"(C:\root\dir_512)");
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_PATH_POOL_HPP_
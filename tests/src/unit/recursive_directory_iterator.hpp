@@ -0,0 +1,157 @@
+// recursive_directory_iterator.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_RECURSIVE_DIRECTORY_ITERATOR_HPP_
+#define _MJFS_TEST_UNIT_RECURSIVE_DIRECTORY_ITERATOR_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/path.hpp>
+#include <unit/test_tree.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        struct _Visited_entry {
+            path target;
+            int depth;
+
+            bool operator==(const _Visited_entry&) const = default;
+        };
+
+        inline ::std::vector<_Visited_entry> _Visit_tree(const path& _Root, const directory_options _Options,
+            const recursive_directory_limits& _Limits = recursive_directory_limits{}) {
+            ::std::vector<_Visited_entry> _Visited;
+            for (recursive_directory_iterator _Iter(_Root, _Options, _Limits);
+                 _Iter != recursive_directory_iterator{}; ++_Iter) {
+                _Visited.push_back(_Visited_entry{_Iter->absolute_path(), _Iter.depth()});
+            }
+
+            return _Visited;
+        }
+
+        TEST(recursive_directory_iterator, sorted_by_name) {
+            // Note: The names are ordered case-insensitively, like in a sorted directory_listing,
+            //       so "_x.txt" follows the letters instead of preceding the lower case ones.
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_sorted"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(_Create_test_file(_Root / L"c.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"_x.txt", 1));
+            ASSERT_TRUE(create_directory(_Root / L"B"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(B\y.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(B\X.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"a.txt", 1));
+            const ::std::vector<_Visited_entry> _Expected = {{_Root / L"a.txt", 0}, {_Root / L"B", 0},
+                {_Root / LR"(B\X.txt)", 1}, {_Root / LR"(B\y.txt)", 1}, {_Root / L"c.txt", 0},
+                {_Root / L"_x.txt", 0}};
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name), _Expected);
+        }
+
+        TEST(recursive_directory_iterator, breadth_first) {
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_breadth"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directories(_Root / LR"(d1\d2)"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(d1\d2\f2.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(d1\f1.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"g.txt", 1));
+
+            // a whole level is reported before the level below it
+            const ::std::vector<_Visited_entry> _Expected = {{_Root / L"d1", 0}, {_Root / L"g.txt", 0},
+                {_Root / LR"(d1\d2)", 1}, {_Root / LR"(d1\f1.txt)", 1}, {_Root / LR"(d1\d2\f2.txt)", 2}};
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::breadth_first | directory_options::sorted_by_name),
+                _Expected);
+        }
+
+        TEST(recursive_directory_iterator, max_depth) {
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_depth"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directories(_Root / LR"(a\b\c)"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(a\b\c\file.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(a\file.txt)", 1));
+            recursive_directory_limits _Limits;
+            _Limits.max_depth = 0; // only the target's entries
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name, _Limits),
+                (::std::vector<_Visited_entry>{{_Root / L"a", 0}}));
+
+            _Limits.max_depth = 1;
+            const ::std::vector<_Visited_entry> _Expected = {
+                {_Root / L"a", 0}, {_Root / LR"(a\b)", 1}, {_Root / LR"(a\file.txt)", 1}};
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name, _Limits), _Expected);
+            EXPECT_EQ(_Visit_tree(_Root,
+                          directory_options::breadth_first | directory_options::sorted_by_name, _Limits),
+                _Expected);
+
+            _Limits.max_depth = -1; // no limit
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name, _Limits).size(), 5);
+        }
+
+        TEST(recursive_directory_iterator, skip_visited_directories) {
+            // Note: The junction points to the root, so following it without the option never ends.
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_cycle"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directory(_Root / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_Root / LR"(sub\file.txt)", 1));
+            ASSERT_TRUE(_Create_test_junction(_Root / LR"(sub\loop)", _Root));
+            const directory_options _Options = directory_options::follow_directory_symlink
+                | directory_options::skip_visited_directories | directory_options::sorted_by_name;
+            const ::std::vector<_Visited_entry> _Expected = {
+                {_Root / L"sub", 0}, {_Root / LR"(sub\file.txt)", 1}, {_Root / LR"(sub\loop)", 1}};
+            EXPECT_EQ(_Visit_tree(_Root, _Options), _Expected); // the junction is reported, but not entered
+            for (recursive_directory_iterator _Iter(_Root, _Options); _Iter != recursive_directory_iterator{};
+                 ++_Iter) {
+                if (_Iter->is_junction()) {
+                    EXPECT_FALSE(_Iter.recursion_pending());
+                }
+            }
+        }
+
+        TEST(recursive_directory_iterator, report_hard_links_once) {
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_hard_links"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directory(_Root / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_Root / L"a.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"other.txt", 1));
+            ASSERT_TRUE(_Create_test_hard_link(_Root / L"b.txt", _Root / L"a.txt"));
+            ASSERT_TRUE(_Create_test_hard_link(_Root / LR"(sub\c.txt)", _Root / L"a.txt"));
+
+            // only the first name of the file is reported
+            const ::std::vector<_Visited_entry> _Expected = {
+                {_Root / L"a.txt", 0}, {_Root / L"other.txt", 0}, {_Root / L"sub", 0}};
+            const directory_options _Options =
+                directory_options::report_hard_links_once | directory_options::sorted_by_name;
+            EXPECT_EQ(_Visit_tree(_Root, _Options), _Expected);
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name).size(), 5);
+        }
+
+        TEST(recursive_directory_iterator, max_open_handles) {
+            // Note: Only one handle may stay open, so each parent's remaining entries are read into memory
+            //       before a subdirectory is entered. No entry may be lost or reported twice.
+            const _Test_tree _Tree(path(L"mjfs_test_recursive_handles"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(create_directories(_Root / LR"(a\b\c)"));
+            ASSERT_TRUE(create_directories(_Root / LR"(a\d)"));
+            ASSERT_TRUE(create_directory(_Root / L"e"));
+            const ::std::vector<path> _Dirs = {
+                _Root, _Root / L"a", _Root / LR"(a\b)", _Root / LR"(a\b\c)", _Root / LR"(a\d)"};
+            wchar_t _Name[] = L"file_0.txt";
+            for (const path& _Dir : _Dirs) {
+                for (wchar_t _Idx = L'0'; _Idx < L'3'; ++_Idx) {
+                    _Name[5] = _Idx;
+                    ASSERT_TRUE(_Create_test_file(_Dir / _Name, 1));
+                }
+            }
+
+            recursive_directory_limits _Limits;
+            _Limits.max_open_handles = 1;
+            const ::std::vector<_Visited_entry> _Unlimited = _Visit_tree(_Root, directory_options::none);
+            EXPECT_EQ(_Unlimited.size(), 20); // 5 directories and 15 files
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::none, _Limits), _Unlimited);
+            EXPECT_EQ(_Visit_tree(_Root, directory_options::sorted_by_name, _Limits),
+                _Visit_tree(_Root, directory_options::sorted_by_name));
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_RECURSIVE_DIRECTORY_ITERATOR_HPP_
@@ -0,0 +1,113 @@
+// remove_all.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_REMOVE_ALL_HPP_
+#define _MJFS_TEST_UNIT_REMOVE_ALL_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/status.hpp>
+#include <unit/test_tree.hpp>
+
+namespace mjx {
+    namespace test {
+        inline void _Create_nested_tree(const path& _Target) {
+            // creates 5 directories (including the target) and 3 files
+            ASSERT_TRUE(create_directories(_Target / LR"(a\b\c)"));
+            ASSERT_TRUE(create_directory(_Target / L"d"));
+            ASSERT_TRUE(_Create_test_file(_Target / LR"(a\b\c\first.txt)", 1));
+            ASSERT_TRUE(_Create_test_file(_Target / LR"(a\second.txt)", 2));
+            ASSERT_TRUE(_Create_test_file(_Target / LR"(d\third.txt)", 3));
+        }
+
+        TEST(remove_all, nested_directories) {
+            const _Test_tree _Tree(path(L"mjfs_test_remove_all_nested"));
+            const path _Target = _Tree.root() / L"target";
+            ASSERT_NO_FATAL_FAILURE(_Create_nested_tree(_Target));
+            remove_all_stats _Stats;
+            EXPECT_TRUE(remove_all(_Target, &_Stats));
+            EXPECT_FALSE(exists(_Target));
+            EXPECT_EQ(_Stats.removed_files, 3);
+            EXPECT_EQ(_Stats.removed_directories, 5);
+            EXPECT_EQ(_Stats.error, 0);
+            EXPECT_TRUE(_Stats.failed_path.empty());
+            EXPECT_TRUE(remove_all(_Target, &_Stats)); // a missing target is not an error
+            EXPECT_EQ(_Stats.removed_files, 0);
+        }
+
+        TEST(remove_all, read_only_files) {
+            const _Test_tree _Tree(path(L"mjfs_test_remove_all_read_only"));
+            const path _Target = _Tree.root() / L"target";
+            ASSERT_TRUE(create_directories(_Target / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_Target / L"read_only.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Target / LR"(sub\read_only.txt)", 1));
+            ASSERT_TRUE(make_readonly(_Target / L"read_only.txt"));
+            ASSERT_TRUE(make_readonly(_Target / LR"(sub\read_only.txt)"));
+            remove_all_stats _Stats;
+            EXPECT_TRUE(remove_all(_Target, &_Stats));
+            EXPECT_FALSE(exists(_Target));
+            EXPECT_EQ(_Stats.removed_files, 2);
+            EXPECT_EQ(_Stats.removed_directories, 2);
+        }
+
+        TEST(remove_all, junction_not_followed) {
+            const _Test_tree _Tree(path(L"mjfs_test_remove_all_junction"));
+            const path _Outside = _Tree.root() / L"outside";
+            const path _Target  = _Tree.root() / L"target";
+            ASSERT_TRUE(create_directory(_Outside));
+            ASSERT_TRUE(_Create_test_file(_Outside / L"keep.txt", 1));
+            ASSERT_TRUE(create_directory(_Target));
+            ASSERT_TRUE(_Create_test_junction(_Target / L"link", _Outside));
+            ASSERT_TRUE(is_junction(_Target / L"link"));
+            remove_all_stats _Stats;
+            EXPECT_TRUE(remove_all(_Target, &_Stats));
+            EXPECT_FALSE(exists(_Target));
+            EXPECT_TRUE(is_regular_file(_Outside / L"keep.txt")); // the target of the junction is kept
+            EXPECT_EQ(_Stats.removed_files, 0);
+            EXPECT_EQ(_Stats.removed_directories, 2); // the target and the junction
+        }
+
+        TEST(remove_all, failed_path) {
+            const _Test_tree _Tree(path(L"mjfs_test_remove_all_failed"));
+            const path _Target = _Tree.root() / L"target";
+            const path _Locked = _Target / L"locked.txt";
+            ASSERT_TRUE(create_directory(_Target));
+            ASSERT_TRUE(_Create_test_file(_Locked, 1));
+            ASSERT_TRUE(_Create_test_file(_Target / L"other.txt", 1));
+            remove_all_stats _Stats;
+            {
+                const file _Lock(_Locked); // opened without sharing, so it cannot be deleted
+                ASSERT_TRUE(_Lock.is_open());
+                EXPECT_FALSE(remove_all(_Target, &_Stats));
+            }
+
+            EXPECT_EQ(_Stats.error, 32); // ERROR_SHARING_VIOLATION
+            EXPECT_EQ(_Stats.failed_path, _Locked);
+            EXPECT_EQ(_Stats.removed_files, 1); // the error doesn't stop the other entries
+            EXPECT_EQ(_Stats.removed_directories, 0); // the target is not empty
+            EXPECT_TRUE(exists(_Locked));
+            EXPECT_FALSE(exists(_Target / L"other.txt"));
+        }
+
+        TEST(remove_all, background_removal) {
+            const _Test_tree _Tree(path(L"mjfs_test_remove_all_background"));
+            const path _Target = _Tree.root() / L"target";
+            ASSERT_NO_FATAL_FAILURE(_Create_nested_tree(_Target));
+            background_removal _Removal;
+            EXPECT_FALSE(_Removal.pending());
+            ASSERT_TRUE(remove_all(_Target, _Removal));
+            EXPECT_FALSE(exists(_Target)); // renamed before returning
+            remove_all_stats _Stats;
+            EXPECT_TRUE(_Removal.wait(&_Stats));
+            EXPECT_FALSE(_Removal.pending());
+            EXPECT_EQ(_Stats.removed_files, 3);
+            EXPECT_EQ(_Stats.removed_directories, 5);
+            EXPECT_TRUE(_Stats.failed_path.empty());
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_REMOVE_ALL_HPP_
@@ -0,0 +1,109 @@
+// space_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_SPACE_CACHE_HPP_
+#define _MJFS_TEST_UNIT_SPACE_CACHE_HPP_
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/space_cache.hpp>
+#include <unit/test_tree.hpp>
+#include <utility>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        // Note: The space is cached for a minute, so it doesn't change while the test runs, and only
+        //       the reservations affect it.
+        inline constexpr uint64_t _Space_cache_test_age = 60'000;
+        inline constexpr uint64_t _Space_cache_test_size = 1024 * 1024;
+
+        TEST(space_cache, reservation) {
+            const _Test_tree _Tree(path(L"mjfs_test_space_cache_reservation"));
+            const path& _Root = _Tree.root();
+            space_cache _Cache(_Space_cache_test_age);
+            const space_info _Initial = _Cache.space(_Root);
+            if (_Initial.available < 4 * _Space_cache_test_size) {
+                GTEST_SKIP() << "the volume is almost full";
+            }
+
+            space_reservation _Reservation = _Cache.try_reserve(_Root, _Space_cache_test_size);
+            ASSERT_TRUE(_Reservation);
+            EXPECT_EQ(_Reservation.size(), _Space_cache_test_size);
+            const space_info _Reduced = _Cache.space(_Root);
+            EXPECT_EQ(_Reduced.capacity, _Initial.capacity);
+            EXPECT_EQ(_Reduced.free, _Initial.free - _Space_cache_test_size);
+            EXPECT_EQ(_Reduced.available, _Initial.available - _Space_cache_test_size);
+
+            // the reserved space can't be reserved again, neither can the headroom
+            EXPECT_FALSE(_Cache.try_reserve(_Root, _Reduced.available + 1));
+            EXPECT_FALSE(_Cache.try_reserve(_Root, _Space_cache_test_size, _Reduced.available));
+            EXPECT_EQ(_Cache.space(_Root).available, _Reduced.available); // a failed attempt reserves nothing
+        }
+
+        TEST(space_cache, release) {
+            const _Test_tree _Tree(path(L"mjfs_test_space_cache_release"));
+            const path& _Root = _Tree.root();
+            space_cache _Cache(_Space_cache_test_age);
+            const uint64_t _Initial = _Cache.space(_Root).available;
+            if (_Initial < 4 * _Space_cache_test_size) {
+                GTEST_SKIP() << "the volume is almost full";
+            }
+
+            space_reservation _First  = _Cache.try_reserve(_Root, _Space_cache_test_size);
+            space_reservation _Second = _Cache.try_reserve(_Root, _Space_cache_test_size);
+            ASSERT_TRUE(_First);
+            ASSERT_TRUE(_Second);
+            EXPECT_EQ(_Cache.space(_Root).available, _Initial - 2 * _Space_cache_test_size);
+            _First.release();
+            EXPECT_FALSE(_First);
+            EXPECT_EQ(_First.size(), 0);
+            EXPECT_EQ(_Cache.space(_Root).available, _Initial - _Space_cache_test_size);
+            _First.release(); // releasing twice gives nothing back
+            EXPECT_EQ(_Cache.space(_Root).available, _Initial - _Space_cache_test_size);
+
+            { // a moved reservation is released once, by its new owner
+                const space_reservation _Moved = ::std::move(_Second);
+                EXPECT_FALSE(_Second);
+                EXPECT_EQ(_Cache.space(_Root).available, _Initial - _Space_cache_test_size);
+            }
+
+            EXPECT_EQ(_Cache.space(_Root).available, _Initial);
+        }
+
+        TEST(space_cache, shared_volume) {
+            // Note: Both directories lie on the same volume, so a reservation made through either of them
+            //       reduces the space of both, and each volume is counted once.
+            const _Test_tree _Tree(path(L"mjfs_test_space_cache_volume"));
+            const path _First  = _Tree.root() / L"first";
+            const path _Second = _Tree.root() / LR"(second\nested)";
+            ASSERT_TRUE(create_directory(_First));
+            ASSERT_TRUE(create_directories(_Second));
+            space_cache _Cache(_Space_cache_test_age);
+            const uint64_t _Initial = _Cache.space(_First).available;
+            if (_Initial < 4 * _Space_cache_test_size) {
+                GTEST_SKIP() << "the volume is almost full";
+            }
+
+            EXPECT_EQ(_Cache.space(_Second).available, _Initial);
+            const space_reservation _Reservation = _Cache.try_reserve(_First, _Space_cache_test_size);
+            ASSERT_TRUE(_Reservation);
+            EXPECT_EQ(_Cache.space(_Second).available, _Initial - _Space_cache_test_size);
+            const space_reservation _Other = _Cache.try_reserve(_Second, _Space_cache_test_size);
+            ASSERT_TRUE(_Other);
+            EXPECT_EQ(_Cache.space(_First).available, _Initial - 2 * _Space_cache_test_size);
+
+            const ::std::vector<path> _Targets = {_First, _Second, _First};
+            ::std::vector<space_info> _Spaces(_Targets.size());
+            ASSERT_TRUE(_Cache.space_batch(_Targets, _Spaces));
+            for (const space_info& _Space : _Spaces) {
+                EXPECT_EQ(_Space.available, _Initial - 2 * _Space_cache_test_size);
+            }
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_SPACE_CACHE_HPP_
@@ -0,0 +1,53 @@
+// static_path.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_STATIC_PATH_HPP_
+#define _MJFS_TEST_UNIT_STATIC_PATH_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/static_path.hpp>
+
+namespace mjx {
+    namespace test {
+        TEST(static_path, decomposition) {
+            constexpr static_path _Path(L"cache/index/meta.bin");
+            static_assert(_Path.size() == 20);
+            static_assert(_Path.c_str()[5] == L'\\');
+            static_assert(_Path.filename_offset() == 12);
+            static_assert(_Path.extension_offset() == 16);
+            static_assert(_Path.parent_path_length() == 11);
+            static_assert(_Path.has_filename() && _Path.has_stem() && _Path.has_extension());
+            EXPECT_EQ(_Path.filename(), L"meta.bin");
+            EXPECT_EQ(_Path.stem(), L"meta");
+            EXPECT_EQ(_Path.extension(), L".bin");
+            EXPECT_EQ(_Path.parent_path(), LR"(cache\index)");
+
+            constexpr static_path _Dir(L"cache/index/");
+            static_assert(!_Dir.has_filename() && !_Dir.has_stem() && !_Dir.has_extension());
+            constexpr static_path _Hidden(L".hidden");
+            static_assert(!_Hidden.has_extension() && _Hidden.parent_path_length() == 7);
+            constexpr static_path _Dot_dot(L"foo/..");
+            static_assert(!_Dot_dot.has_extension() && _Dot_dot.has_stem());
+            constexpr static_path _Root(L"/foo");
+            static_assert(_Root.parent_path_length() == 1);
+            constexpr static_path _Empty(L"");
+            static_assert(_Empty.empty() && !_Empty.has_filename() && !_Empty.has_parent_path());
+        }
+
+        TEST(static_path, conversion) {
+            constexpr static_path _Native(L"C:/foo/bar.txt");
+            const path _Path = _Native;
+            EXPECT_EQ(_Path, LR"(C:\foo\bar.txt)");
+            EXPECT_EQ(_Path.filename(), _Native.filename());
+            EXPECT_EQ(_Path.extension(), _Native.extension());
+
+            constexpr static_path _Generic(LR"(foo\bar)", path::generic_format);
+            EXPECT_EQ(_Generic.native(), L"foo/bar");
+            EXPECT_EQ(path{_Generic}, path(L"foo/bar", path::generic_format));
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_STATIC_PATH_HPP_
@@ -0,0 +1,219 @@
+// status.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_STATUS_HPP_
+#define _MJFS_TEST_UNIT_STATUS_HPP_
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <mjfs/bitmask.hpp>
+#include <mjfs/directory.hpp>
+#include <mjfs/path.hpp>
+#include <mjfs/status.hpp>
+#include <string>
+#include <unit/test_tree.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        inline void _Expect_same_status(const file_status& _Left, const file_status& _Right) {
+            EXPECT_EQ(_Left.type, _Right.type);
+            if (_Left.type != file_type::not_found) {
+                EXPECT_EQ(_Left.attributes, _Right.attributes);
+                EXPECT_EQ(_Left.size, _Right.size);
+                EXPECT_EQ(_Left.last_write_time, _Right.last_write_time);
+            }
+        }
+
+        inline path _Make_status_file_name(const wchar_t* const _Prefix, const size_t _Idx) {
+            // returns "<prefix>file_NN", the prefix is either empty or a drive ("X:")
+            wchar_t _Name[] = L"file_00";
+            _Name[5]        = static_cast<wchar_t>(L'0' + _Idx / 10 % 10);
+            _Name[6]        = static_cast<wchar_t>(L'0' + _Idx % 10);
+            return path(::std::wstring(_Prefix).append(_Name).c_str());
+        }
+
+        inline ::std::vector<path> _Create_status_batch_tree(const path& _Root, const size_t _Count) {
+            // returns the files, a directory and a missing path, all in the same directory
+            ::std::vector<path> _Targets;
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Targets.push_back(_Root / _Make_status_file_name(L"", _Idx));
+                EXPECT_TRUE(_Create_test_file(_Targets.back(), _Idx));
+            }
+
+            _Targets.push_back(_Root / L"dir");
+            EXPECT_TRUE(create_directory(_Targets.back()));
+            _Targets.push_back(_Root / L"missing");
+            return _Targets;
+        }
+
+        class _Current_path_guard { // restores the current directory when the test ends
+        public:
+            _Current_path_guard() : _Myold(current_path()) {}
+
+            ~_Current_path_guard() noexcept {
+                current_path(_Myold);
+            }
+
+            _Current_path_guard(const _Current_path_guard&)            = delete;
+            _Current_path_guard& operator=(const _Current_path_guard&) = delete;
+
+            const path& old_path() const noexcept {
+                return _Myold;
+            }
+
+        private:
+            path _Myold;
+        };
+
+        TEST(status, regular_file) {
+            const _Test_tree _Tree(path(L"mjfs_test_status_file"));
+            const path _File = _Tree.root() / L"file.txt";
+            ASSERT_TRUE(_Create_test_file(_File, 5));
+            const file_status _Status = status(_File);
+            EXPECT_EQ(_Status.type, file_type::regular);
+            EXPECT_FALSE(_Has_bits(_Status.attributes, file_attribute::directory));
+            EXPECT_EQ(_Status.size, 5);
+            EXPECT_NE(_Status.last_write_time, 0);
+            EXPECT_TRUE(is_regular_file(_Status));
+            _Expect_same_status(symlink_status(_File), _Status); // nothing to follow
+        }
+
+        TEST(status, directory) {
+            const _Test_tree _Tree(path(L"mjfs_test_status_directory"));
+            const path _Dir = _Tree.root() / L"dir";
+            ASSERT_TRUE(create_directory(_Dir));
+            const file_status _Status = status(_Dir);
+            EXPECT_EQ(_Status.type, file_type::directory);
+            EXPECT_TRUE(_Has_bits(_Status.attributes, file_attribute::directory));
+            EXPECT_FALSE(_Has_bits(_Status.attributes, file_attribute::reparse_point));
+            EXPECT_TRUE(is_directory(_Status));
+            _Expect_same_status(symlink_status(_Dir), _Status);
+        }
+
+        TEST(status, missing_path) {
+            // Note: A missing path is a known status, unlike a status that couldn't be obtained.
+            const _Test_tree _Tree(path(L"mjfs_test_status_missing"));
+            for (const path& _Target : {_Tree.root() / L"missing", _Tree.root() / LR"(missing\file.txt)"}) {
+                const file_status _Status         = status(_Target);
+                const file_status _Symlink_status = symlink_status(_Target);
+                EXPECT_EQ(_Status.type, file_type::not_found);
+                EXPECT_EQ(_Symlink_status.type, file_type::not_found);
+                EXPECT_EQ(_Status.attributes, file_attribute::unknown);
+                EXPECT_TRUE(status_known(_Status));
+                EXPECT_FALSE(exists(_Status));
+                EXPECT_FALSE(exists(_Symlink_status));
+            }
+        }
+
+        TEST(status, junction) {
+            // Note: status() follows the junction to its target, symlink_status() describes the junction.
+            const _Test_tree _Tree(path(L"mjfs_test_status_junction"));
+            const path _Target = _Tree.root() / L"target";
+            const path _Link   = _Tree.root() / L"link";
+            ASSERT_TRUE(create_directory(_Target));
+            ASSERT_TRUE(_Create_test_junction(_Link, _Target));
+            const file_status _Status = status(_Link);
+            EXPECT_EQ(_Status.type, file_type::directory);
+            EXPECT_FALSE(_Has_bits(_Status.attributes, file_attribute::reparse_point));
+            _Expect_same_status(_Status, status(_Target));
+
+            const file_status _Symlink_status = symlink_status(_Link);
+            EXPECT_EQ(_Symlink_status.type, file_type::junction);
+            EXPECT_TRUE(_Has_bits(_Symlink_status.attributes, file_attribute::reparse_point));
+            EXPECT_TRUE(is_junction(_Symlink_status));
+            EXPECT_FALSE(is_symlink(_Symlink_status));
+
+            // a junction to a removed target still exists, but cannot be followed
+            ASSERT_TRUE(remove_directory(_Target));
+            EXPECT_EQ(symlink_status(_Link).type, file_type::junction);
+            EXPECT_FALSE(exists(status(_Link)));
+        }
+
+        TEST(status_batch, large_group) {
+            // Note: 20 paths share the directory, so the directory is enumerated instead of
+            //       querying each path.
+            const _Test_tree _Tree(path(L"mjfs_test_status_batch"));
+            const ::std::vector<path> _Targets = _Create_status_batch_tree(_Tree.root(), 18);
+            ::std::vector<file_status> _Statuses(_Targets.size());
+            ASSERT_TRUE(status_batch(_Targets, _Statuses));
+            for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+                _Expect_same_status(_Statuses[_Idx], status(_Targets[_Idx]));
+            }
+
+            EXPECT_EQ(_Statuses[17].type, file_type::regular);
+            EXPECT_EQ(_Statuses[17].size, 17);
+            EXPECT_EQ(_Statuses[18].type, file_type::directory);
+            EXPECT_EQ(_Statuses[19].type, file_type::not_found);
+        }
+
+        TEST(status_batch, small_group) {
+            const _Test_tree _Tree(path(L"mjfs_test_status_batch_small"));
+            const ::std::vector<path> _Targets = _Create_status_batch_tree(_Tree.root(), 3);
+            ::std::vector<file_status> _Statuses(_Targets.size());
+            ASSERT_TRUE(status_batch(_Targets, _Statuses));
+            for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+                _Expect_same_status(_Statuses[_Idx], status(_Targets[_Idx]));
+            }
+
+            ::std::vector<file_status> _Short(_Targets.size() - 1);
+            EXPECT_FALSE(status_batch(_Targets, _Short)); // the sizes differ
+        }
+
+        TEST(status_batch, bare_drive) {
+            // Note: "X:name" is relative to the current directory of the drive, so a group of such
+            //       paths must list the current directory, not the root of the drive.
+            const _Test_tree _Tree(path(L"mjfs_test_status_batch_drive"));
+            _Create_status_batch_tree(_Tree.root(), 20);
+            const _Current_path_guard _Guard;
+            const ::std::wstring _Old(_Guard.old_path().c_str());
+            if (_Old.size() < 2 || _Old[1] != L':') {
+                GTEST_SKIP() << "the current directory has no drive letter";
+            }
+
+            ASSERT_TRUE(current_path(_Tree.root()));
+            const ::std::wstring _Drive = _Old.substr(0, 2);
+            ::std::vector<path> _Targets;
+            for (size_t _Idx = 0; _Idx < 20; ++_Idx) {
+                _Targets.push_back(_Make_status_file_name(_Drive.c_str(), _Idx));
+            }
+
+            _Targets.push_back(path((_Drive + L"missing").c_str()));
+            ::std::vector<file_status> _Statuses(_Targets.size());
+            ASSERT_TRUE(status_batch(_Targets, _Statuses));
+            for (size_t _Idx = 0; _Idx < 20; ++_Idx) {
+                EXPECT_EQ(_Statuses[_Idx].type, file_type::regular);
+                EXPECT_EQ(_Statuses[_Idx].size, _Idx);
+            }
+
+            EXPECT_EQ(_Statuses[20].type, file_type::not_found);
+        }
+
+        TEST(symlink_status_batch, large_group) {
+            const _Test_tree _Tree(path(L"mjfs_test_symlink_status_batch"));
+            const ::std::vector<path> _Targets = _Create_status_batch_tree(_Tree.root(), 18);
+            ::std::vector<file_status> _Statuses(_Targets.size());
+            ASSERT_TRUE(symlink_status_batch(_Targets, _Statuses));
+            for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+                _Expect_same_status(_Statuses[_Idx], symlink_status(_Targets[_Idx]));
+            }
+
+            EXPECT_EQ(_Statuses[18].type, file_type::directory);
+            EXPECT_EQ(_Statuses[19].type, file_type::not_found);
+        }
+
+        TEST(symlink_status_batch, small_group) {
+            const _Test_tree _Tree(path(L"mjfs_test_symlink_status_batch_small"));
+            const ::std::vector<path> _Targets = _Create_status_batch_tree(_Tree.root(), 3);
+            ::std::vector<file_status> _Statuses(_Targets.size());
+            ASSERT_TRUE(symlink_status_batch(_Targets, _Statuses));
+            for (size_t _Idx = 0; _Idx < _Targets.size(); ++_Idx) {
+                _Expect_same_status(_Statuses[_Idx], symlink_status(_Targets[_Idx]));
+            }
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_STATUS_HPP_
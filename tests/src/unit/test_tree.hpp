@@ -0,0 +1,69 @@
+// test_tree.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_TEST_TREE_HPP_
+#define _MJFS_TEST_UNIT_TEST_TREE_HPP_
+#include <cstdint>
+#include <cstdlib>
+#include <mjfs/directory.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/path.hpp>
+#include <string>
+
+namespace mjx {
+    namespace test {
+        inline bool _Create_test_file(const path& _Target, const uint64_t _Size) {
+            file _File;
+            return create_file(_Target, &_File) && _File.resize(_Size);
+        }
+
+        inline bool _Resize_test_file(const path& _Target, const uint64_t _Size) {
+            file _File(_Target);
+            return _File.is_open() && _File.resize(_Size);
+        }
+
+        inline bool _Create_test_link(const wchar_t* const _Kind, const path& _Link, const path& _Target) {
+            // Note: The links are created by mklink, since the library doesn't create them. Neither a junction
+            //       ("/J") nor a hard link ("/H") requires any privilege.
+            ::std::wstring _Command = L"mklink ";
+            _Command.append(_Kind).append(L" \"").append(_Link.c_str()).append(L"\" \"");
+            _Command.append(_Target.c_str()).append(L"\" >nul");
+            return ::_wsystem(_Command.c_str()) == 0;
+        }
+
+        inline bool _Create_test_junction(const path& _Link, const path& _Target) {
+            return _Create_test_link(L"/J", _Link, _Target);
+        }
+
+        inline bool _Create_test_hard_link(const path& _Link, const path& _Target) {
+            return _Create_test_link(L"/H", _Link, _Target);
+        }
+
+        class _Test_tree { // a directory created for a single test, removed with all its contents
+        public:
+            explicit _Test_tree(const path& _Root) : _Myroot(_Root) {
+                remove_all(_Myroot); // left behind by an interrupted run
+                create_directory(_Myroot);
+            }
+
+            ~_Test_tree() noexcept {
+                remove_all(_Myroot);
+            }
+
+            _Test_tree(const _Test_tree&)            = delete;
+            _Test_tree& operator=(const _Test_tree&) = delete;
+
+            const path& root() const noexcept {
+                return _Myroot;
+            }
+
+        private:
+            path _Myroot;
+        };
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_TEST_TREE_HPP_
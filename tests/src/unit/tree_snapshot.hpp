@@ -0,0 +1,95 @@
+// tree_snapshot.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _MJFS_TEST_UNIT_TREE_SNAPSHOT_HPP_
+#define _MJFS_TEST_UNIT_TREE_SNAPSHOT_HPP_
+#include <gtest/gtest.h>
+#include <mjfs/directory.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/tree_snapshot.hpp>
+#include <unit/test_tree.hpp>
+#include <vector>
+
+namespace mjx {
+    namespace test {
+        TEST(tree_snapshot, diff) {
+            const _Test_tree _Tree(path(L"mjfs_test_snapshot_diff"));
+            const path& _Root = _Tree.root();
+            ASSERT_TRUE(_Create_test_file(_Root / L"a.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"b.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"c.txt", 1));
+            ASSERT_TRUE(_Create_test_file(_Root / L"m.txt", 1));
+
+            tree_snapshot _Old;
+            ASSERT_TRUE(_Old.scan(_Root));
+            ASSERT_EQ(_Old.size(), 4);
+            EXPECT_EQ(_Old.relative_path(2), L"c.txt");
+
+            ASSERT_TRUE(delete_file(_Root / L"b.txt"));
+            ASSERT_TRUE(rename(_Root / L"c.txt", _Root / L"e.txt"));
+            ASSERT_TRUE(_Resize_test_file(_Root / L"m.txt", 2));
+            ASSERT_TRUE(_Create_test_file(_Root / L"z.txt", 1));
+
+            tree_snapshot _New;
+            ASSERT_TRUE(_New.scan(_Root, _Old));
+            ASSERT_EQ(_New.size(), 4); // a.txt, e.txt, m.txt and z.txt
+            EXPECT_EQ(_New.file_id(1), _Old.file_id(2)); // the ID is kept by the rename
+
+            const ::std::vector<snapshot_change> _Changes = diff(_Old, _New);
+            ASSERT_EQ(_Changes.size(), 4);
+            EXPECT_EQ(_Changes[0].type, snapshot_change_type::modified);
+            EXPECT_EQ(_Changes[0].old_index, 3);
+            EXPECT_EQ(_Changes[0].new_index, 2);
+            EXPECT_EQ(_Changes[1].type, snapshot_change_type::renamed);
+            EXPECT_EQ(_Changes[1].old_index, 2);
+            EXPECT_EQ(_Changes[1].new_index, 1);
+            EXPECT_EQ(_Changes[2].type, snapshot_change_type::removed);
+            EXPECT_EQ(_Changes[2].old_index, 1);
+            EXPECT_EQ(_Changes[2].new_index, tree_snapshot::npos);
+            EXPECT_EQ(_Changes[3].type, snapshot_change_type::added);
+            EXPECT_EQ(_Changes[3].old_index, tree_snapshot::npos);
+            EXPECT_EQ(_Changes[3].new_index, 3);
+            EXPECT_TRUE(diff(_New, _New).empty());
+        }
+
+        TEST(tree_snapshot, mismatched_root) {
+            const _Test_tree _First(path(L"mjfs_test_snapshot_first"));
+            const _Test_tree _Second(path(L"mjfs_test_snapshot_second"));
+            ASSERT_TRUE(create_directory(_First.root() / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_First.root() / LR"(sub\first.txt)", 1));
+            ASSERT_TRUE(create_directory(_Second.root() / L"sub"));
+            ASSERT_TRUE(_Create_test_file(_Second.root() / LR"(sub\second.txt)", 1));
+
+            tree_snapshot _Previous;
+            ASSERT_TRUE(_Previous.scan(_First.root()));
+            ASSERT_TRUE(_Previous.save(_First.root() / L"snapshot.bin"));
+
+            // a snapshot of another root is ignored, nothing is taken from it
+            tree_snapshot _Snapshot;
+            ASSERT_TRUE(_Snapshot.scan(_Second.root(), _Previous));
+            EXPECT_EQ(_Snapshot.root(), _Second.root());
+            ASSERT_EQ(_Snapshot.size(), 2);
+            EXPECT_EQ(_Snapshot.relative_path(1), LR"(sub\second.txt)");
+            EXPECT_EQ(_Snapshot.find(LR"(sub\first.txt)"), tree_snapshot::npos);
+
+            // a loaded snapshot keeps its root, so it's ignored as well
+            tree_snapshot _Loaded;
+            ASSERT_TRUE(_Loaded.load(_First.root() / L"snapshot.bin"));
+            EXPECT_EQ(_Loaded.root(), _First.root());
+            EXPECT_EQ(_Loaded.volume_serial(), _Previous.volume_serial());
+            ASSERT_TRUE(_Snapshot.scan(_Second.root(), _Loaded));
+            EXPECT_EQ(_Snapshot.find(LR"(sub\first.txt)"), tree_snapshot::npos);
+            EXPECT_NE(_Snapshot.find(LR"(sub\second.txt)"), tree_snapshot::npos);
+
+            // a file that is not a snapshot is rejected
+            ASSERT_TRUE(_Create_test_file(_Second.root() / L"junk.bin", 64));
+            EXPECT_FALSE(_Loaded.load(_Second.root() / L"junk.bin"));
+            EXPECT_FALSE(_Loaded.valid());
+        }
+    } // namespace test
+} // namespace mjx
+
+#endif // _MJFS_TEST_UNIT_TREE_SNAPSHOT_HPP_